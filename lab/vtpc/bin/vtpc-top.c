@@ -0,0 +1,168 @@
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <time.h>
+
+#include "vtpc.h"
+
+/*
+ * vtpc-top <pid> [interval_ms] [count]
+ * Раз в interval_ms (по умолчанию секунда) читает снимок, который процесс pid
+ * публикует в /vtpc.<pid>, и печатает скорость попаданий, задержку промахов,
+ * грязные страницы, пользу упреждающего чтения и скорость сброса за интервал.
+ * count == 0 — печатать, пока процесс публикует снимки. Процесс должен
+ * включить vtpc_config.monitor: по умолчанию снимки не публикуются.
+ */
+
+#define TOP_DEFAULT_INTERVAL_MS 1000
+#define TOP_NSEC_PER_SEC 1000000000ULL
+#define TOP_NSEC_PER_MSEC 1000000ULL
+#define TOP_NSEC_PER_USEC 1000ULL
+#define TOP_PERCENT 100.0
+#define TOP_P50 0.50
+#define TOP_P99 0.99
+
+static double ratio(uint64_t part, uint64_t total) {
+  return total == 0 ? 0.0 : TOP_PERCENT * (double)part / (double)total;
+}
+
+/* latency_quantile — верхняя граница корзины, в которую попадает квантиль q
+ * промахов интервала, в микросекундах. */
+static double latency_quantile(
+    const struct vtpc_monitor* now, const struct vtpc_monitor* prev, double q
+) {
+  uint64_t total = 0;
+  for (size_t i = 0; i < VTPC_MONITOR_BUCKETS; ++i) {
+    total += now->miss_latency[i] - prev->miss_latency[i];
+  }
+  if (total == 0) {
+    return 0.0;
+  }
+
+  uint64_t seen = 0;
+  for (size_t i = 0; i < VTPC_MONITOR_BUCKETS; ++i) {
+    seen += now->miss_latency[i] - prev->miss_latency[i];
+    if ((double)seen >= q * (double)total) {
+      return (double)(2ULL << i) / (double)TOP_NSEC_PER_USEC;
+    }
+  }
+  return 0.0;
+}
+
+static void print_header(void) {
+  printf(
+      "%8s %8s %10s %10s %10s %8s %8s %10s %10s\n",
+      "hit%",
+      "misses/s",
+      "miss_avg",
+      "miss_p50",
+      "miss_p99",
+      "dirty",
+      "ra_eff%",
+      "flush/s",
+      "used"
+  );
+}
+
+static void print_line(
+    const struct vtpc_monitor* now, const struct vtpc_monitor* prev
+) {
+  const struct vtpc_stats* cur = &now->stats;
+  const struct vtpc_stats* old = &prev->stats;
+  double seconds =
+      (double)(now->time_ns - prev->time_ns) / (double)TOP_NSEC_PER_SEC;
+  if (seconds <= 0.0) {
+    seconds = 1.0;
+  }
+
+  uint64_t hits = cur->hits - old->hits;
+  uint64_t misses = cur->misses - old->misses;
+  uint64_t miss_ns = now->miss_ns - prev->miss_ns;
+  uint64_t ra_pages = cur->readahead_pages - old->readahead_pages;
+  uint64_t ra_hits = cur->readahead_hits - old->readahead_hits;
+  uint64_t flushed = cur->writebacks - old->writebacks;
+  double miss_avg = misses == 0 ? 0.0
+                                : (double)miss_ns / (double)misses /
+                                      (double)TOP_NSEC_PER_USEC;
+
+  printf(
+      "%7.1f%% %8.0f %8.1fus %8.1fus %8.1fus %8zu %7.1f%% %10.0f %5zu/%zu\n",
+      ratio(hits, hits + misses),
+      (double)misses / seconds,
+      miss_avg,
+      latency_quantile(now, prev, TOP_P50),
+      latency_quantile(now, prev, TOP_P99),
+      cur->dirty_pages,
+      ratio(ra_hits, ra_pages),
+      (double)flushed / seconds,
+      cur->used_pages,
+      now->capacity
+  );
+  for (size_t i = 0; i < now->partition_count; ++i) {
+    const struct vtpc_partition_stats* part = &now->partitions[i];
+    printf(
+        "  %-16s %8zu pages (%zu..%zu)\n",
+        part->name,
+        part->used_pages,
+        part->min_pages,
+        part->max_pages
+    );
+  }
+  fflush(stdout);
+}
+
+static int parse_number(const char* text, long* value) {
+  char* end = NULL;
+  errno = 0;
+  *value = strtol(text, &end, 10);  // NOLINT
+  return errno == 0 && end != text && *end == '\0' && *value >= 0 ? 0 : -1;
+}
+
+int main(int argc, char** argv) {
+  long pid = 0;
+  long interval = TOP_DEFAULT_INTERVAL_MS;
+  long count = 0;
+  if (argc < 2 || argc > 4 || parse_number(argv[1], &pid) != 0 ||
+      (argc > 2 && (parse_number(argv[2], &interval) != 0 || interval == 0)) ||
+      (argc > 3 && parse_number(argv[3], &count) != 0)) {
+    fprintf(stderr, "usage: %s <pid> [interval_ms] [count]\n", argv[0]);
+    return 2;
+  }
+
+  struct vtpc_monitor prev;
+  if (vtpc_monitor_read((pid_t)pid, &prev) != 0) {
+    if (errno == ENOENT) {
+      fprintf(stderr, "vtpc-top: %ld: no snapshot, is monitor enabled?\n", pid);
+      return 1;
+    }
+    fprintf(stderr, "vtpc-top: %ld: %s\n", pid, strerror(errno));
+    return 1;
+  }
+
+  const uint64_t period = (uint64_t)interval * TOP_NSEC_PER_MSEC;
+  const struct timespec delay = {
+      .tv_sec = (time_t)(period / TOP_NSEC_PER_SEC),
+      .tv_nsec = (long)(period % TOP_NSEC_PER_SEC),
+  };
+  print_header();
+  for (long i = 0; count == 0 || i < count; ++i) {
+    nanosleep(&delay, NULL);
+    struct vtpc_monitor now;
+    if (vtpc_monitor_read((pid_t)pid, &now) != 0) {
+      if (errno == ENOENT) {
+        return 0; /* процесс завершился */
+      }
+      fprintf(stderr, "vtpc-top: %ld: %s\n", pid, strerror(errno));
+      return 1;
+    }
+    print_line(&now, &prev);
+    prev = now;
+  }
+  return 0;
+}
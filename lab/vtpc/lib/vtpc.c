@@ -1,30 +1,2215 @@
+#define _GNU_SOURCE
 #include "vtpc.h"
 
+#include <errno.h>
 #include <fcntl.h>
+#include <pthread.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
 #include <sys/types.h>
+#include <time.h>
 #include <unistd.h>
 
+#include "vtpc_dev.h"
+#include "vtpc_index.h"
+#include "vtpc_l2.h"
+#include "vtpc_monitor.h"
+
+#define VTPC_HANDLES_INITIAL 16
+#define VTPC_HANDLE_SLOT_BITS 20
+#define VTPC_HANDLES_MAX (1U << VTPC_HANDLE_SLOT_BITS)
+#define VTPC_HANDLE_GENERATIONS (1U << (31 - VTPC_HANDLE_SLOT_BITS))
+#define VTPC_HANDLE_NONE SIZE_MAX
+#define VTPC_FILES_INITIAL 64
+#define VTPC_FILE_HASH 0x9E3779B97F4A7C15ULL
+#define VTPC_DEFAULT_MAX_FDS 512
+#define VTPC_READAHEAD_MIN 4
+#define VTPC_READAHEAD_SEQUENTIAL 4 /* во сколько раз SEQUENTIAL больше */
+#define VTPC_ADVICE_RANGES 8
+#define VTPC_JOBS_MAX 64
+#define VTPC_LAST_PAGE (INT64_MAX / VTPC_PAGE_SIZE)
+#define VTPC_NSEC_PER_SEC 1000000000ULL
+#define VTPC_NSEC_PER_MSEC 1000000ULL
+
+struct vtpc_file;
+
+/* vtpc_page — страница кэша; одновременно состоит в индексе, LRU-списке
+ * своего раздела и списке страниц файла. Свободные страницы связаны через
+ * free_next. */
+struct vtpc_page {
+  struct vtpc_file* file;
+  off_t index;
+  char* data;
+  int dirty;
+  int loading;   /* страница читается или пишется без блокировки кэша */
+  int readahead; /* загружена упреждением и ещё не использована */
+  int pinned;    /* сколько раз закреплена; закреплённая страница вне LRU */
+  int partition;
+  struct vtpc_page* free_next;
+  struct vtpc_page* lru_prev;
+  struct vtpc_page* lru_next;
+  struct vtpc_page* file_prev;
+  struct vtpc_page* file_next;
+};
+
+/* vtpc_lru — в голове самая свежая страница, в хвосте — самая старая. */
+struct vtpc_lru {
+  struct vtpc_page* head;
+  struct vtpc_page* tail;
+};
+
+struct vtpc_partition {
+  int active;
+  char name[VTPC_PARTITION_NAME_MAX];
+  size_t min_pages;
+  size_t max_pages;
+  size_t used_pages;
+  struct vtpc_lru lru;
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t evictions;
+};
+
+/* vtpc_file — открытый файл, общий для всех хэндлов с тем же inode. Логический
+ * размер size может расходиться с размером на диске disk_size, пока грязные
+ * страницы не сброшены. Дескриптор ОС fd открывается при первом обращении к
+ * диску и живёт, пока файл в LRU дескрипторов; path нужен, чтобы открыть его
+ * снова. Файл с грязными страницами свой дескриптор не отдаёт: после
+ * переименования или удаления путь ведёт уже не к нему, а сбросить их надо. */
+struct vtpc_file {
+  uint64_t id; /* номер во втором уровне; новый после усечения */
+  int fd;      /* -1, если дескриптор закрыт */
+  int writable;
+  char* path; /* абсолютный путь, по которому файл открыт */
+  dev_t dev;
+  ino_t ino;
+  off_t size;
+  off_t disk_size;
+  int no_extents; /* файловая система не умеет fallocate */
+  int stale;      /* убран из таблицы: его inode занял другой файл */
+  /* отпечаток файла на диске на момент закрытия дескриптора */
+  struct timespec stamp_mtime;
+  struct timespec stamp_ctime;
+  off_t stamp_size;
+  size_t refs;
+  size_t dirty_pages; /* грязные страницы файла */
+  size_t loads;       /* промахи, читающие страницы файла с устройства */
+  struct vtpc_page* pages;
+  struct vtpc_file* next; /* следующий файл в корзине таблицы файлов */
+  struct vtpc_file* fd_prev;
+  struct vtpc_file* fd_next;
+};
+
+/* vtpc_advice — подсказка vtpc_fadvise для страниц [first, last]. */
+struct vtpc_advice {
+  off_t first;
+  off_t last;
+  int advice;
+};
+
+struct vtpc_handle {
+  struct vtpc_file* file;
+  off_t pos;
+  int readable;
+  int writable;
+  int append;
+  int partition;
+  struct vtpc_advice advice[VTPC_ADVICE_RANGES];
+  size_t advice_count;
+  off_t ra_prev;    /* последняя прочитанная страница */
+  off_t ra_end;     /* первая страница за пределами упреждения */
+  size_t ra_window; /* текущий размер окна упреждения */
+};
+
+/* vtpc_handle_slot — ячейка таблицы хэндлов. Номер хэндла складывается из
+ * номера ячейки и её поколения, поэтому закрытый номер не совпадёт с хэндлом,
+ * открытым позже в той же ячейке. */
+struct vtpc_handle_slot {
+  struct vtpc_handle* handle;
+  unsigned generation;
+  size_t free_next; /* следующая свободная ячейка или VTPC_HANDLE_NONE */
+};
+
+enum vtpc_job_type {
+  VTPC_JOB_PREFETCH,
+  VTPC_JOB_WRITEBACK,
+};
+
+/* vtpc_job — задание фонового потока над страницами [first, last] файла. */
+struct vtpc_job {
+  enum vtpc_job_type type;
+  struct vtpc_file* file;
+  off_t first;
+  off_t last;
+  int partition;
+  int cold;
+};
+
+struct vtpc_cache {
+  pthread_mutex_t lock;
+  pthread_cond_t idle; /* завершилась фоновая загрузка или задание */
+  pthread_cond_t work; /* в очереди появилось задание */
+  pthread_cond_t reclaim; /* свободных страниц меньше нижней отметки */
+  int initialized;
+  const struct vtpc_dev* dev;
+  size_t capacity;
+  size_t used_pages;
+  size_t dirty_pages;
+  size_t locked_pages;
+  size_t locked_max;
+  struct vtpc_page* slab;      /* все дескрипторы страниц */
+  char* slab_data;             /* данные всех страниц */
+  struct vtpc_page* free_list; /* незанятые дескрипторы */
+  size_t free_pages;
+  size_t reclaim_low;
+  size_t reclaim_high;
+  /* файл страницы, которую сейчас сбрасывает фоновое освобождение */
+  struct vtpc_file* reclaim_file;
+  uint64_t reclaimed_pages;
+  size_t loads; /* промахи, читающие страницы с устройства */
+  struct vtpc_index index;
+  struct vtpc_l2 l2;
+  uint64_t file_ids;
+  struct vtpc_partition partitions[VTPC_MAX_PARTITIONS];
+  struct vtpc_file** files; /* таблица файлов по (dev, ino) */
+  size_t file_buckets;
+  size_t file_count;
+  struct vtpc_file* fd_head; /* файлы с открытым дескриптором, свежий первым */
+  struct vtpc_file* fd_tail;
+  size_t fd_count;
+  size_t fd_max;
+  uint64_t fd_reopens;
+  struct vtpc_handle_slot* handles;
+  size_t handle_count;
+  size_t handle_free; /* первая свободная ячейка или VTPC_HANDLE_NONE */
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t evictions;
+  uint64_t writebacks;
+  uint64_t readahead_pages;
+  uint64_t readahead_hits;
+  uint64_t readahead_waits;
+  uint64_t miss_ns;
+  uint64_t miss_latency[VTPC_MONITOR_BUCKETS];
+  struct vtpc_monitor_page* monitor; /* NULL, если монитор выключен */
+  uint64_t monitor_time;             /* время последней публикации, нс */
+  int worker_started;
+  struct vtpc_job jobs[VTPC_JOBS_MAX];
+  size_t job_head;
+  size_t job_count;
+  struct vtpc_file* job_file; /* файл задания, выполняемого сейчас */
+  int job_cancel;
+};
+
+static struct vtpc_config config = VTPC_CONFIG_DEFAULT;
+
+static struct vtpc_cache cache = {
+    .handle_free = VTPC_HANDLE_NONE,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .idle = PTHREAD_COND_INITIALIZER,
+    .work = PTHREAD_COND_INITIALIZER,
+    .reclaim = PTHREAD_COND_INITIALIZER,
+};
+
+/* ---------------------------- Инициализация ---------------------------- */
+
+static void slab_destroy(void) {
+  vtpc_index_destroy(&cache.index);
+  free(cache.slab_data);
+  free(cache.slab);
+  cache.slab_data = NULL;
+  cache.slab = NULL;
+  cache.free_list = NULL;
+  cache.free_pages = 0;
+}
+
+/*
+ * slab_create — заранее выделяет дескрипторы, данные страниц и индекс под всю
+ * ёмкость кэша, чтобы чтение, запись, промах, вытеснение и сброс обходились
+ * без обращений к аллокатору.
+ */
+static int slab_create(size_t pages) {
+  if (vtpc_index_init(&cache.index, pages) != 0) {
+    return -1;
+  }
+  void* data = NULL;
+  cache.slab = calloc(pages, sizeof(*cache.slab));
+  if (pages > SIZE_MAX / VTPC_PAGE_SIZE ||
+      posix_memalign(&data, VTPC_PAGE_SIZE, pages * VTPC_PAGE_SIZE) != 0) {
+    data = NULL;
+  }
+  cache.slab_data = data;
+  if (!cache.slab || !cache.slab_data) {
+    slab_destroy();
+    errno = ENOMEM;
+    return -1;
+  }
+
+  for (size_t i = pages; i > 0; --i) {
+    struct vtpc_page* page = &cache.slab[i - 1];
+    page->data = cache.slab_data + (i - 1) * VTPC_PAGE_SIZE;
+    page->free_next = cache.free_list;
+    cache.free_list = page;
+  }
+  cache.free_pages = pages;
+  return 0;
+}
+
+static void* reclaim_main(void* arg);
+
+/* reclaim_start — запускает фоновое освобождение, если заданы отметки. Без
+ * него кэш работает, освобождая место прямо на промахе. */
+static void reclaim_start(void) {
+  cache.reclaim_high = config.reclaim_high;
+  if (cache.reclaim_high > cache.capacity) {
+    cache.reclaim_high = cache.capacity;
+  }
+  cache.reclaim_low = config.reclaim_low;
+  if (cache.reclaim_low > cache.reclaim_high) {
+    cache.reclaim_low = cache.reclaim_high;
+  }
+
+  pthread_t reclaimer;
+  if (cache.reclaim_high == 0 ||
+      pthread_create(&reclaimer, NULL, reclaim_main, NULL) != 0) {
+    cache.reclaim_low = 0;
+    cache.reclaim_high = 0;
+    return;
+  }
+  pthread_detach(reclaimer);
+}
+
+static int cache_init(void) {
+  if (cache.initialized) {
+    return 0;
+  }
+
+  if (slab_create(config.cache_pages) != 0) {
+    return -1;
+  }
+  cache.capacity = config.cache_pages;
+  cache.fd_max = config.max_fds ? config.max_fds : VTPC_DEFAULT_MAX_FDS;
+  cache.locked_max = config.locked_pages ? config.locked_pages
+                                         : cache.capacity / 2;
+  if (cache.locked_max > cache.capacity) {
+    cache.locked_max = cache.capacity;
+  }
+
+  if (vtpc_l2_open(&cache.l2, config.l2_path, config.l2_pages) != 0) {
+    int saved = errno;
+    slab_destroy();
+    errno = saved;
+    return -1;
+  }
+
+  cache.dev = &vtpc_dev_posix;
+  if (config.device == VTPC_DEVICE_SIM) {
+    if (vtpc_sim_setup(&config.sim) != 0) {
+      int saved = errno;
+      vtpc_l2_close(&cache.l2);
+      slab_destroy();
+      errno = saved;
+      return -1;
+    }
+    cache.dev = &vtpc_dev_sim;
+  }
+
+  struct vtpc_partition* def = &cache.partitions[VTPC_DEFAULT_PARTITION];
+  def->active = 1;
+  strcpy(def->name, "default");  // NOLINT
+  def->min_pages = 0;
+  def->max_pages = cache.capacity;
+
+  if (config.monitor) {
+    /* Без монитора кэш работает как обычно, поэтому ошибку не возвращаем. */
+    cache.monitor = vtpc_monitor_open();
+  }
+
+  reclaim_start();
+  cache.initialized = 1;
+  return 0;
+}
+
+int vtpc_configure(const struct vtpc_config* cfg) {
+  if (!cfg || cfg->cache_pages == 0 ||
+      (cfg->device != VTPC_DEVICE_POSIX && cfg->device != VTPC_DEVICE_SIM) ||
+      cfg->reclaim_low > cfg->reclaim_high) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  pthread_mutex_lock(&cache.lock);
+  if (cache.initialized) {
+    pthread_mutex_unlock(&cache.lock);
+    errno = EBUSY;
+    return -1;
+  }
+  config = *cfg;
+  pthread_mutex_unlock(&cache.lock);
+  return 0;
+}
+
+/* ---------------------------- Индекс страниц ---------------------------- */
+
+static struct vtpc_page* hash_find(const struct vtpc_file* file, off_t index) {
+  return vtpc_index_find(&cache.index, file, index);
+}
+
+static void hash_insert(struct vtpc_page* page) {
+  vtpc_index_insert(&cache.index, page->file, page->index, page);
+}
+
+static void hash_remove(struct vtpc_page* page) {
+  vtpc_index_remove(&cache.index, page->file, page->index);
+}
+
+/* ------------------------------ Списки ------------------------------ */
+
+static void lru_remove(struct vtpc_lru* lru, struct vtpc_page* page) {
+  if (page->lru_prev) {
+    page->lru_prev->lru_next = page->lru_next;
+  } else {
+    lru->head = page->lru_next;
+  }
+  if (page->lru_next) {
+    page->lru_next->lru_prev = page->lru_prev;
+  } else {
+    lru->tail = page->lru_prev;
+  }
+  page->lru_prev = NULL;
+  page->lru_next = NULL;
+}
+
+static void lru_push_head(struct vtpc_lru* lru, struct vtpc_page* page) {
+  page->lru_prev = NULL;
+  page->lru_next = lru->head;
+  if (lru->head) {
+    lru->head->lru_prev = page;
+  } else {
+    lru->tail = page;
+  }
+  lru->head = page;
+}
+
+static void lru_push_tail(struct vtpc_lru* lru, struct vtpc_page* page) {
+  page->lru_next = NULL;
+  page->lru_prev = lru->tail;
+  if (lru->tail) {
+    lru->tail->lru_next = page;
+  } else {
+    lru->head = page;
+  }
+  lru->tail = page;
+}
+
+/* lru_oldest — самая старая страница списка, которую можно вытеснить. */
+static struct vtpc_page* lru_oldest(const struct vtpc_lru* lru) {
+  struct vtpc_page* page = lru->tail;
+  while (page && page->loading) {
+    page = page->lru_prev;
+  }
+  return page;
+}
+
+static void file_link_page(struct vtpc_file* file, struct vtpc_page* page) {
+  page->file_prev = NULL;
+  page->file_next = file->pages;
+  if (file->pages) {
+    file->pages->file_prev = page;
+  }
+  file->pages = page;
+}
+
+static void file_unlink_page(struct vtpc_file* file, struct vtpc_page* page) {
+  if (page->file_prev) {
+    page->file_prev->file_next = page->file_next;
+  } else {
+    file->pages = page->file_next;
+  }
+  if (page->file_next) {
+    page->file_next->file_prev = page->file_prev;
+  }
+  page->file_prev = NULL;
+  page->file_next = NULL;
+}
+
+/* ------------------------------ Монитор ------------------------------ */
+
+static uint64_t clock_ns(clockid_t clock) {
+  struct timespec now;
+  clock_gettime(clock, &now);
+  return (uint64_t)now.tv_sec * VTPC_NSEC_PER_SEC + (uint64_t)now.tv_nsec;
+}
+
+/* miss_account — заносит задержку промаха в гистограмму по степеням двойки. */
+static void miss_account(uint64_t ns) {
+  size_t bucket = 0;
+  while (bucket + 1 < VTPC_MONITOR_BUCKETS && (ns >> (bucket + 1)) != 0) {
+    ++bucket;
+  }
+  ++cache.miss_latency[bucket];
+  cache.miss_ns += ns;
+}
+
+static void stats_fill(struct vtpc_stats* stats) {
+  stats->hits = cache.hits;
+  stats->misses = cache.misses;
+  stats->evictions = cache.evictions;
+  stats->writebacks = cache.writebacks;
+  stats->readahead_pages = cache.readahead_pages;
+  stats->readahead_hits = cache.readahead_hits;
+  stats->readahead_waits = cache.readahead_waits;
+  stats->used_pages = cache.used_pages;
+  stats->dirty_pages = cache.dirty_pages;
+  stats->locked_pages = cache.locked_pages;
+  stats->free_pages = cache.free_pages;
+  stats->reclaimed_pages = cache.reclaimed_pages;
+  stats->l2_hits = cache.l2.hits;
+  stats->l2_misses = cache.l2.misses;
+  stats->l2_writes = cache.l2.writes;
+  stats->l2_used_pages = cache.l2.used_pages;
+  stats->open_fds = cache.fd_count;
+  stats->fd_reopens = cache.fd_reopens;
+}
+
+static void partition_fill(
+    const struct vtpc_partition* part, struct vtpc_partition_stats* stats
+) {
+  memcpy(stats->name, part->name, sizeof(stats->name));
+  stats->min_pages = part->min_pages;
+  stats->max_pages = part->max_pages;
+  stats->used_pages = part->used_pages;
+  stats->hits = part->hits;
+  stats->misses = part->misses;
+  stats->evictions = part->evictions;
+}
+
+/*
+ * monitor_tick — публикует снимок счётчиков, если с прошлого раза прошло
+ * VTPC_MONITOR_INTERVAL_MS. Время берётся грубыми часами, чтобы проверка на
+ * каждом вызове API ничего не стоила; снимок собирается на стеке и
+ * переписывается в разделяемую память одним memcpy.
+ */
+static void monitor_tick(void) {
+  if (!cache.monitor) {
+    return;
+  }
+  uint64_t now = clock_ns(CLOCK_MONOTONIC_COARSE);
+  if (now - cache.monitor_time <
+      (uint64_t)VTPC_MONITOR_INTERVAL_MS * VTPC_NSEC_PER_MSEC) {
+    return;
+  }
+  cache.monitor_time = now;
+
+  struct vtpc_monitor snapshot;
+  memset(&snapshot, 0, sizeof(snapshot));
+  snapshot.pid = getpid();
+  snapshot.time_ns = clock_ns(CLOCK_MONOTONIC);
+  snapshot.capacity = cache.capacity;
+  stats_fill(&snapshot.stats);
+  snapshot.miss_ns = cache.miss_ns;
+  memcpy(
+      snapshot.miss_latency, cache.miss_latency, sizeof(snapshot.miss_latency)
+  );
+  for (size_t i = 0; i < VTPC_MAX_PARTITIONS; ++i) {
+    if (cache.partitions[i].active) {
+      partition_fill(
+          &cache.partitions[i], &snapshot.partitions[snapshot.partition_count]
+      );
+      ++snapshot.partition_count;
+    }
+  }
+  vtpc_monitor_publish(cache.monitor, &snapshot);
+}
+
+/* --------------------------- Дескрипторы ОС --------------------------- */
+
+static void fd_lru_remove(struct vtpc_file* file) {
+  if (file->fd_prev) {
+    file->fd_prev->fd_next = file->fd_next;
+  } else {
+    cache.fd_head = file->fd_next;
+  }
+  if (file->fd_next) {
+    file->fd_next->fd_prev = file->fd_prev;
+  } else {
+    cache.fd_tail = file->fd_prev;
+  }
+  file->fd_prev = NULL;
+  file->fd_next = NULL;
+}
+
+static void fd_lru_push(struct vtpc_file* file) {
+  file->fd_prev = NULL;
+  file->fd_next = cache.fd_head;
+  if (cache.fd_head) {
+    cache.fd_head->fd_prev = file;
+  } else {
+    cache.fd_tail = file;
+  }
+  cache.fd_head = file;
+}
+
+/* fd_busy — фоновый поток пишет или читает через дескриптор файла без
+ * блокировки кэша или у файла есть несброшенные страницы, закрывать его
+ * нельзя. */
+static int fd_busy(const struct vtpc_file* file) {
+  return cache.job_file == file || cache.reclaim_file == file ||
+         file->loads > 0 || file->dirty_pages > 0;
+}
+
+/* file_stamp — запоминает отпечаток файла на диске, по которому файл с
+ * закрытым дескриптором отличают от нового, получившего его inode. */
+static void file_stamp(struct vtpc_file* file, const struct stat* st) {
+  file->stamp_mtime = st->st_mtim;
+  file->stamp_ctime = st->st_ctim;
+  file->stamp_size = st->st_size;
+}
+
+/*
+ * file_matches(file, st) — тот ли это файл. Открытый дескриптор держит inode,
+ * и совпадения (dev, ino) достаточно; файл с закрытым дескриптором могли
+ * удалить, а inode отдать новому, поэтому сверяется и отпечаток.
+ */
+static int file_matches(const struct vtpc_file* file, const struct stat* st) {
+  if (st->st_dev != file->dev || st->st_ino != file->ino) {
+    return 0;
+  }
+  return file->fd >= 0 ||
+         (st->st_mtim.tv_sec == file->stamp_mtime.tv_sec &&
+          st->st_mtim.tv_nsec == file->stamp_mtime.tv_nsec &&
+          st->st_ctim.tv_sec == file->stamp_ctime.tv_sec &&
+          st->st_ctim.tv_nsec == file->stamp_ctime.tv_nsec &&
+          st->st_size == file->stamp_size);
+}
+
+static void fd_close(struct vtpc_file* file) {
+  fd_lru_remove(file);
+  cache.dev->close(file->fd);
+  file->fd = -1;
+  --cache.fd_count;
+}
+
+/* fd_attach — делает fd дескриптором файла, закрывая самые давно
+ * использованные дескрипторы сверх предела. */
+static void fd_attach(struct vtpc_file* file, int fd) {
+  struct vtpc_file* victim = cache.fd_tail;
+  while (victim && cache.fd_count >= cache.fd_max) {
+    struct vtpc_file* prev = victim->fd_prev;
+    if (!fd_busy(victim)) {
+      struct stat st;
+      if (cache.dev->fstat(victim->fd, &st) == 0) {
+        file_stamp(victim, &st);
+      }
+      fd_close(victim);
+    }
+    victim = prev;
+  }
+  file->fd = fd;
+  fd_lru_push(file);
+  ++cache.fd_count;
+}
+
+/*
+ * file_fd(file) — дескриптор ОС для ввода-вывода файла. Закрытый по LRU файл
+ * открывается заново по пути; если там теперь другой файл или файл менялся в
+ * обход кэша, возвращает -1 с errno = ESTALE.
+ */
+static int file_fd(struct vtpc_file* file) {
+  if (file->fd >= 0) {
+    if (cache.fd_head != file) {
+      fd_lru_remove(file);
+      fd_lru_push(file);
+    }
+    return file->fd;
+  }
+  if (file->stale) {
+    errno = ESTALE;
+    return -1;
+  }
+
+  int fd = cache.dev->open(file->path, file->writable ? O_RDWR : O_RDONLY, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  struct stat st;
+  int error = 0;
+  if (cache.dev->fstat(fd, &st) != 0) {
+    error = errno;
+  } else if (!file_matches(file, &st)) {
+    error = ESTALE;
+  }
+  if (error != 0) {
+    cache.dev->close(fd);
+    errno = error;
+    return -1;
+  }
+  ++cache.fd_reopens;
+  fd_attach(file, fd);
+  return fd;
+}
+
+/* ------------------------------ Страницы ------------------------------ */
+
+/*
+ * file_reserve(file, fd, offset) — перед записью страницы offset за концом
+ * файла на диске выделяет место участком до ближайшей границы extent_pages
+ * страниц, чтобы дописываемые страницы легли на диск непрерывно, а не
+ * отвоёвывали блоки по одному. Файл на диске при этом вырастает до границы
+ * участка; лишний хвост срезает file_flush, приводя disk_size к логическому
+ * размеру. Без fallocate запись просто идёт как раньше.
+ */
+static void file_reserve(struct vtpc_file* file, int fd, off_t offset) {
+  off_t end = offset + VTPC_PAGE_SIZE;
+  if (config.extent_pages == 0 || file->no_extents || end <= file->disk_size) {
+    return;
+  }
+  off_t extent = (off_t)(config.extent_pages * VTPC_PAGE_SIZE);
+  off_t start = offset / extent * extent;
+  if (start < file->disk_size) {
+    start = file->disk_size;
+  }
+  off_t target = (end + extent - 1) / extent * extent;
+  if (cache.dev->fallocate(fd, 0, start, target - start) != 0) {
+    file->no_extents = 1;
+    return;
+  }
+  file->disk_size = target;
+}
+
+static int page_writeback(struct vtpc_page* page) {
+  if (!page->dirty) {
+    return 0;
+  }
+
+  struct vtpc_file* file = page->file;
+  int fd = file_fd(file);
+  if (fd < 0) {
+    return -1;
+  }
+  off_t offset = page->index * VTPC_PAGE_SIZE;
+  file_reserve(file, fd, offset);
+  ssize_t written = cache.dev->pwrite(fd, page->data, VTPC_PAGE_SIZE, offset);
+  if (written != VTPC_PAGE_SIZE) {
+    if (written >= 0) {
+      errno = EIO;
+    }
+    return -1;
+  }
+  if (offset + VTPC_PAGE_SIZE > file->disk_size) {
+    file->disk_size = offset + VTPC_PAGE_SIZE;
+  }
+
+  page->dirty = 0;
+  --cache.dirty_pages;
+  --file->dirty_pages;
+  ++cache.writebacks;
+  return 0;
+}
+
+/* page_mark_dirty — страница расходится с копией во втором уровне, поэтому
+ * копия забывается. С первой грязной страницей файл закрепляет дескриптор;
+ * обычно он уже открыт записью, иначе открывается здесь. */
+static void page_mark_dirty(struct vtpc_page* page) {
+  if (!page->dirty) {
+    page->dirty = 1;
+    ++cache.dirty_pages;
+    if (page->file->dirty_pages++ == 0 && page->file->fd < 0) {
+      (void)file_fd(page->file);
+    }
+    vtpc_l2_invalidate(&cache.l2, page->file->id, page->index);
+  }
+}
+
+/* page_install — вносит страницу в кэш; cold ставит её в холодный конец LRU,
+ * откуда она будет вытеснена первой. */
+static void page_install(
+    struct vtpc_page* page,
+    struct vtpc_file* file,
+    off_t index,
+    int partition,
+    int cold
+) {
+  struct vtpc_partition* part = &cache.partitions[partition];
+  page->file = file;
+  page->index = index;
+  page->dirty = 0;
+  page->loading = 0;
+  page->readahead = 0;
+  page->pinned = 0;
+  page->partition = partition;
+  hash_insert(page);
+  if (cold) {
+    lru_push_tail(&part->lru, page);
+  } else {
+    lru_push_head(&part->lru, page);
+  }
+  file_link_page(file, page);
+  ++part->used_pages;
+  ++cache.used_pages;
+}
+
+/* page_detach — исключает страницу из кэша; грязные данные теряются, поэтому
+ * вызывающий обязан сбросить их заранее, если они нужны. */
+static void page_detach(struct vtpc_page* page) {
+  struct vtpc_partition* part = &cache.partitions[page->partition];
+  if (page->dirty) {
+    page->dirty = 0;
+    --cache.dirty_pages;
+    --page->file->dirty_pages;
+  }
+  hash_remove(page);
+  if (page->pinned) {
+    page->pinned = 0;
+    --cache.locked_pages;
+  } else {
+    lru_remove(&part->lru, page);
+  }
+  file_unlink_page(page->file, page);
+  --part->used_pages;
+  --cache.used_pages;
+  page->file = NULL;
+}
+
+/* page_free — возвращает отсоединённую страницу в список свободных. */
+static void page_free(struct vtpc_page* page) {
+  page->free_next = cache.free_list;
+  cache.free_list = page;
+  ++cache.free_pages;
+}
+
+static void page_touch(struct vtpc_page* page) {
+  struct vtpc_lru* lru = &cache.partitions[page->partition].lru;
+  if (!page->pinned && lru->head != page) {
+    lru_remove(lru, page);
+    lru_push_head(lru, page);
+  }
+}
+
+static void page_cool(struct vtpc_page* page) {
+  struct vtpc_lru* lru = &cache.partitions[page->partition].lru;
+  if (!page->pinned && lru->tail != page) {
+    lru_remove(lru, page);
+    lru_push_tail(lru, page);
+  }
+}
+
+/* excess_victim — самая старая страница раздела, сильнее всех превысившего
+ * свой минимум, либо NULL. */
+static struct vtpc_page* excess_victim(void) {
+  struct vtpc_partition* best = NULL;
+  struct vtpc_page* victim = NULL;
+  for (size_t i = 0; i < VTPC_MAX_PARTITIONS; ++i) {
+    struct vtpc_partition* other = &cache.partitions[i];
+    if (!other->active || other->used_pages <= other->min_pages) {
+      continue;
+    }
+    struct vtpc_page* oldest = lru_oldest(&other->lru);
+    if (oldest && (!best || other->used_pages - other->min_pages >
+                                best->used_pages - best->min_pages)) {
+      best = other;
+      victim = oldest;
+    }
+  }
+  return victim;
+}
+
+/*
+ * choose_victim(partition) — выбирает страницу для вытеснения при загрузке
+ * страницы в раздел partition. Раздел, упёршийся в свой максимум, вытесняет
+ * только себя. Иначе жертвой становится самая старая страница того раздела,
+ * который сильнее всех превысил свой минимум. Если таких разделов нет, раздел
+ * вытесняет собственную страницу. Страницы, которые сейчас загружаются, не
+ * вытесняются.
+ */
+static struct vtpc_page* choose_victim(int partition) {
+  struct vtpc_partition* part = &cache.partitions[partition];
+  if (part->used_pages >= part->max_pages) {
+    return lru_oldest(&part->lru);
+  }
+
+  struct vtpc_page* victim = excess_victim();
+  return victim ? victim : lru_oldest(&part->lru);
+}
+
+static void* worker_main(void* arg);
+
+/* worker_wake — будит фоновый поток, запуская его при первом обращении. */
+static int worker_wake(void) {
+  if (!cache.worker_started) {
+    pthread_t worker;
+    if (pthread_create(&worker, NULL, worker_main, NULL) != 0) {
+      return -1;
+    }
+    pthread_detach(worker);
+    cache.worker_started = 1;
+  }
+  pthread_cond_signal(&cache.work);
+  return 0;
+}
+
+/* l2_stage — отдаёт чистую вытесняемую страницу второму уровню. */
+static void l2_stage(const struct vtpc_page* page) {
+  if (cache.l2.fd >= 0) {
+    vtpc_l2_stage(&cache.l2, page->file->id, page->index, page->data);
+    worker_wake();
+  }
+}
+
+/*
+ * page_alloc(partition) — берёт свободную страницу, а если их нет или раздел
+ * упёрся в максимум, вытесняет жертву сама. Когда свободных страниц становится
+ * меньше нижней отметки, будит фоновое освобождение.
+ */
+static struct vtpc_page* page_alloc(int partition) {
+  struct vtpc_partition* part = &cache.partitions[partition];
+  if (cache.free_pages <= cache.reclaim_low && cache.reclaim_high) {
+    pthread_cond_signal(&cache.reclaim);
+  }
+  if (cache.used_pages < cache.capacity &&
+      part->used_pages < part->max_pages && cache.free_list) {
+    struct vtpc_page* page = cache.free_list;
+    cache.free_list = page->free_next;
+    page->free_next = NULL;
+    --cache.free_pages;
+    return page;
+  }
+
+  struct vtpc_page* victim = choose_victim(partition);
+  if (!victim) {
+    errno = cache.job_file || cache.reclaim_file || cache.loads > 0 ? EAGAIN
+                                                                    : ENOMEM;
+    return NULL;
+  }
+  if (page_writeback(victim) != 0) {
+    return NULL;
+  }
+  l2_stage(victim);
+  ++cache.partitions[victim->partition].evictions;
+  ++cache.evictions;
+  page_detach(victim);
+  return victim;
+}
+
+/* page_clip — обнуляет хвост страницы после прочитанных got байт и после
+ * логического конца файла, до которого от начала страницы valid байт. */
+static void page_clip(char* data, ssize_t got, off_t valid) {
+  if (valid > got) {
+    valid = got;
+  }
+  if (valid < VTPC_PAGE_SIZE) {
+    memset(data + valid, 0, VTPC_PAGE_SIZE - valid);
+  }
+}
+
+/*
+ * page_fill(page) — читает страницу, уже внесённую в кэш. Второй уровень
+ * читается под блокировкой, устройство — без неё, как в prefetch_run: на это
+ * время страница помечена loading, обращения к ней ждут, вытеснение её
+ * пропускает, а дескриптор файла не закрывается.
+ */
+static int page_fill(struct vtpc_page* page) {
+  struct vtpc_file* file = page->file;
+  off_t offset = page->index * VTPC_PAGE_SIZE;
+  if (offset >= file->size) {
+    memset(page->data, 0, VTPC_PAGE_SIZE);
+    return 0;
+  }
+
+  ssize_t slot = vtpc_l2_lookup(&cache.l2, file->id, page->index);
+  if (slot >= 0) {
+    return vtpc_l2_read_slot(&cache.l2, (size_t)slot, page->data);
+  }
+  int fd = file_fd(file);
+  if (fd < 0) {
+    return -1;
+  }
+  off_t valid = file->size - offset;
+  page->loading = 1;
+  ++file->loads;
+  ++cache.loads;
+
+  pthread_mutex_unlock(&cache.lock);
+  ssize_t got = cache.dev->pread(fd, page->data, VTPC_PAGE_SIZE, offset);
+  int saved = errno;
+  if (got >= 0) {
+    page_clip(page->data, got, valid);
+  }
+  pthread_mutex_lock(&cache.lock);
+
+  page->loading = 0;
+  --file->loads;
+  --cache.loads;
+  pthread_cond_broadcast(&cache.idle);
+  errno = saved;
+  return got < 0 ? -1 : 0;
+}
+
+/* handle_advice — действующая подсказка хэндла для страницы index. */
+static int handle_advice(const struct vtpc_handle* handle, off_t index) {
+  for (size_t i = handle->advice_count; i > 0; --i) {
+    const struct vtpc_advice* range = &handle->advice[i - 1];
+    if (range->first <= index && index <= range->last) {
+      return range->advice;
+    }
+  }
+  return VTPC_FADV_NORMAL;
+}
+
+/*
+ * page_get(handle, index, fill) — находит страницу файла в кэше или загружает
+ * её. Если fill == 0, вызывающий перезапишет страницу целиком и читать её с
+ * диска не нужно. Страницу, которую сейчас читает другой поток, дожидается;
+ * такое обращение ждало устройства и считается промахом, а не попаданием.
+ */
+static struct vtpc_page* page_get(
+    struct vtpc_handle* handle, off_t index, int fill
+) {
+  struct vtpc_file* file = handle->file;
+  struct vtpc_partition* part = &cache.partitions[handle->partition];
+  int waited = 0;
+
+  for (;;) {
+    struct vtpc_page* page = hash_find(file, index);
+    if (page && page->loading) {
+      /* Грязную страницу не читают, а сбрасывают: её данные уже в кэше. */
+      waited |= !page->dirty;
+      pthread_cond_wait(&cache.idle, &cache.lock);
+      continue;
+    }
+    if (page && waited) {
+      ++cache.misses;
+      ++part->misses;
+      if (page->readahead) {
+        page->readahead = 0;
+        ++cache.readahead_waits;
+      }
+    } else if (page) {
+      ++cache.hits;
+      ++part->hits;
+      if (page->readahead) {
+        page->readahead = 0;
+        ++cache.readahead_hits;
+      }
+    }
+    if (page) {
+      if (handle_advice(handle, index) != VTPC_FADV_NOREUSE) {
+        page_touch(page);
+      }
+      return page;
+    }
+
+    page = page_alloc(handle->partition);
+    if (!page && errno == EAGAIN) {
+      pthread_cond_wait(&cache.idle, &cache.lock);
+      continue;
+    }
+    if (!page) {
+      return NULL;
+    }
+
+    ++cache.misses;
+    ++part->misses;
+    int cold = handle_advice(handle, index) == VTPC_FADV_NOREUSE;
+    page_install(page, file, index, handle->partition, cold);
+    uint64_t start = cache.monitor ? clock_ns(CLOCK_MONOTONIC) : 0;
+    if (fill && page_fill(page) != 0) {
+      int saved = errno;
+      page_detach(page);
+      page_free(page);
+      errno = saved;
+      return NULL;
+    }
+    if (cache.monitor) {
+      miss_account(clock_ns(CLOCK_MONOTONIC) - start);
+    }
+    return page;
+  }
+}
+
+/* ------------------------------ Файлы ------------------------------ */
+
+static int file_flush(struct vtpc_file* file) {
+  int result = 0;
+  for (struct vtpc_page* page = file->pages; page; page = page->file_next) {
+    if (page_writeback(page) != 0) {
+      result = -1;
+    }
+  }
+  if (result == 0 && file->disk_size != file->size) {
+    int fd = file_fd(file);
+    if (fd < 0 || cache.dev->ftruncate(fd, file->size) != 0) {
+      return -1;
+    }
+    file->disk_size = file->size;
+  }
+  return result;
+}
+
+static void file_drop_pages(struct vtpc_file* file) {
+  while (file->pages) {
+    struct vtpc_page* page = file->pages;
+    page_detach(page);
+    page_free(page);
+  }
+}
+
+static size_t file_bucket(dev_t dev, ino_t ino, size_t buckets) {
+  uint64_t key = ((uint64_t)dev * VTPC_FILE_HASH) ^ (uint64_t)ino;
+  key *= VTPC_FILE_HASH;
+  return (size_t)(key >> 32U) & (buckets - 1);
+}
+
+static struct vtpc_file* file_find(dev_t dev, ino_t ino) {
+  if (cache.file_buckets == 0) {
+    return NULL;
+  }
+  size_t bucket = file_bucket(dev, ino, cache.file_buckets);
+  struct vtpc_file* file = cache.files[bucket];
+  while (file && (file->dev != dev || file->ino != ino)) {
+    file = file->next;
+  }
+  return file;
+}
+
+/* file_insert — добавляет файл в таблицу, удваивая её, когда файлов
+ * становится больше, чем корзин. */
+static int file_insert(struct vtpc_file* file) {
+  if (cache.file_count >= cache.file_buckets) {
+    size_t buckets = cache.file_buckets ? cache.file_buckets * 2
+                                        : VTPC_FILES_INITIAL;
+    struct vtpc_file** files = calloc(buckets, sizeof(*files));
+    if (!files) {
+      errno = ENOMEM;
+      return -1;
+    }
+    for (size_t i = 0; i < cache.file_buckets; ++i) {
+      while (cache.files[i]) {
+        struct vtpc_file* moved = cache.files[i];
+        cache.files[i] = moved->next;
+        size_t bucket = file_bucket(moved->dev, moved->ino, buckets);
+        moved->next = files[bucket];
+        files[bucket] = moved;
+      }
+    }
+    free(cache.files);
+    cache.files = files;
+    cache.file_buckets = buckets;
+  }
+
+  size_t bucket = file_bucket(file->dev, file->ino, cache.file_buckets);
+  file->next = cache.files[bucket];
+  cache.files[bucket] = file;
+  ++cache.file_count;
+  return 0;
+}
+
+static void file_unhash(struct vtpc_file* file) {
+  struct vtpc_file** link =
+      &cache.files[file_bucket(file->dev, file->ino, cache.file_buckets)];
+  while (*link != file) {
+    link = &(*link)->next;
+  }
+  *link = file->next;
+  --cache.file_count;
+}
+
+/*
+ * file_lookup(st) — файл кэша, описываемый st. Устаревший файл, чей inode
+ * занял новый, убирается из таблицы: открытые хэндлы дочитывают его страницы
+ * из кэша, обращение к диску получает ESTALE, а память освобождает закрытие
+ * последнего хэндла.
+ */
+static struct vtpc_file* file_lookup(const struct stat* st) {
+  struct vtpc_file* file = file_find(st->st_dev, st->st_ino);
+  if (file && !file_matches(file, st)) {
+    file_unhash(file);
+    file->stale = 1;
+    file = NULL;
+  }
+  return file;
+}
+
+static void file_release(struct vtpc_file* file) {
+  if (!file->stale) {
+    file_unhash(file);
+  }
+  file_drop_pages(file);
+  if (file->fd >= 0) {
+    fd_close(file);
+  }
+  free(file->path);
+  free(file);
+}
+
+/* ----------------------------- Фоновый поток ----------------------------- */
+
+/*
+ * prefetch_run(job) — загружает отсутствующие страницы диапазона. Страница
+ * заранее занимает место в кэше с флагом loading, а чтение с диска идёт без
+ * блокировки кэша, чтобы не останавливать вызывающие потоки.
+ */
+static void prefetch_run(const struct vtpc_job* job) {
+  struct vtpc_file* file = job->file;
+  for (off_t index = job->first; index <= job->last && !cache.job_cancel;
+       ++index) {
+    off_t offset = index * VTPC_PAGE_SIZE;
+    if (offset >= file->size) {
+      break;
+    }
+    if (hash_find(file, index)) {
+      continue;
+    }
+    struct vtpc_page* page = page_alloc(job->partition);
+    if (!page) {
+      break;
+    }
+    page_install(page, file, index, job->partition, job->cold);
+    page->loading = 1;
+
+    off_t valid = file->size - offset;
+    ssize_t slot = vtpc_l2_lookup(&cache.l2, file->id, index);
+    int fd = slot >= 0 ? -1 : file_fd(file);
+    pthread_mutex_unlock(&cache.lock);
+    ssize_t got = VTPC_PAGE_SIZE;
+    if (slot >= 0) {
+      if (vtpc_l2_read_slot(&cache.l2, (size_t)slot, page->data) != 0) {
+        got = -1;
+      }
+    } else if (fd >= 0) {
+      got = cache.dev->pread(fd, page->data, VTPC_PAGE_SIZE, offset);
+    } else {
+      got = -1;
+    }
+    if (got >= 0) {
+      page_clip(page->data, got, valid);
+    }
+    pthread_mutex_lock(&cache.lock);
+
+    page->loading = 0;
+    pthread_cond_broadcast(&cache.idle);
+    if (got < 0) {
+      page_detach(page);
+      page_free(page);
+      break;
+    }
+    page->readahead = 1;
+    ++cache.readahead_pages;
+  }
+}
+
+/* writeback_run(job) — сбрасывает грязные страницы диапазона и переносит их в
+ * холодный конец LRU. */
+static void writeback_run(const struct vtpc_job* job) {
+  struct vtpc_page* page = job->file->pages;
+  while (page && !cache.job_cancel) {
+    struct vtpc_page* next = page->file_next;
+    if (page->dirty && !page->loading && job->first <= page->index &&
+        page->index <= job->last && page_writeback(page) == 0) {
+      page_cool(page);
+    }
+    page = next;
+  }
+}
+
+static void* worker_main(void* arg) {
+  (void)arg;
+
+  pthread_mutex_lock(&cache.lock);
+  for (;;) {
+    while (cache.job_count == 0 && cache.l2.staged_count == 0) {
+      pthread_cond_wait(&cache.work, &cache.lock);
+    }
+
+    struct vtpc_l2_store store;
+    if (vtpc_l2_store_begin(&cache.l2, &store)) {
+      pthread_mutex_unlock(&cache.lock);
+      int result = vtpc_l2_store_write(&cache.l2, &store);
+      pthread_mutex_lock(&cache.lock);
+      vtpc_l2_store_end(&cache.l2, &store, result);
+      continue;
+    }
+
+    struct vtpc_job job = cache.jobs[cache.job_head];
+    cache.job_head = (cache.job_head + 1) % VTPC_JOBS_MAX;
+    --cache.job_count;
+
+    cache.job_file = job.file;
+    cache.job_cancel = 0;
+    if (job.type == VTPC_JOB_PREFETCH) {
+      prefetch_run(&job);
+    } else {
+      writeback_run(&job);
+    }
+    cache.job_file = NULL;
+    pthread_cond_broadcast(&cache.idle);
+  }
+  return NULL;
+}
+
+/* job_submit — ставит задание в очередь фонового потока. Переполненная
+ * очередь задание отбрасывает: это всего лишь подсказка. */
+static void job_submit(const struct vtpc_job* job) {
+  if (cache.job_count == VTPC_JOBS_MAX || worker_wake() != 0) {
+    return;
+  }
+
+  size_t tail = (cache.job_head + cache.job_count) % VTPC_JOBS_MAX;
+  cache.jobs[tail] = *job;
+  ++cache.job_count;
+}
+
+/* file_wait_idle — дожидается окончания задания, фоновой записи и чтений
+ * страниц файла без блокировки кэша, если они идут. */
+static void file_wait_idle(const struct vtpc_file* file) {
+  while (cache.job_file == file || cache.reclaim_file == file ||
+         file->loads > 0) {
+    pthread_cond_wait(&cache.idle, &cache.lock);
+  }
+}
+
+/* file_quiesce — снимает задания над файлом из очереди, прерывает текущее и
+ * дожидается его окончания. */
+static void file_quiesce(struct vtpc_file* file) {
+  size_t kept = 0;
+  for (size_t i = 0; i < cache.job_count; ++i) {
+    struct vtpc_job job = cache.jobs[(cache.job_head + i) % VTPC_JOBS_MAX];
+    if (job.file != file) {
+      cache.jobs[(cache.job_head + kept) % VTPC_JOBS_MAX] = job;
+      ++kept;
+    }
+  }
+  cache.job_count = kept;
+
+  if (cache.job_file == file) {
+    cache.job_cancel = 1;
+  }
+  file_wait_idle(file);
+}
+
+/* ------------------------ Фоновое освобождение ------------------------ */
+
+/*
+ * reclaim_writeback(page) — сбрасывает грязную жертву без блокировки кэша. На
+ * время записи страница помечена loading: обращения к ней ждут, а вытеснение
+ * её пропускает.
+ */
+static int reclaim_writeback(struct vtpc_page* page) {
+  struct vtpc_file* file = page->file;
+  int fd = file_fd(file);
+  if (fd < 0) {
+    return -1;
+  }
+  off_t offset = page->index * VTPC_PAGE_SIZE;
+  file_reserve(file, fd, offset);
+  page->loading = 1;
+  cache.reclaim_file = file;
+
+  pthread_mutex_unlock(&cache.lock);
+  ssize_t written = cache.dev->pwrite(fd, page->data, VTPC_PAGE_SIZE, offset);
+  pthread_mutex_lock(&cache.lock);
+
+  page->loading = 0;
+  cache.reclaim_file = NULL;
+  pthread_cond_broadcast(&cache.idle);
+  if (written != VTPC_PAGE_SIZE) {
+    return -1;
+  }
+  if (offset + VTPC_PAGE_SIZE > file->disk_size) {
+    file->disk_size = offset + VTPC_PAGE_SIZE;
+  }
+  if (page->dirty) {
+    page->dirty = 0;
+    --cache.dirty_pages;
+    --file->dirty_pages;
+    ++cache.writebacks;
+  }
+  return 0;
+}
+
+/* reclaim_one — освобождает одну страницу раздела, превысившего минимум. */
+static int reclaim_one(void) {
+  struct vtpc_page* victim = excess_victim();
+  if (!victim || (victim->dirty && reclaim_writeback(victim) != 0)) {
+    return -1;
+  }
+  l2_stage(victim);
+  ++cache.partitions[victim->partition].evictions;
+  ++cache.evictions;
+  ++cache.reclaimed_pages;
+  page_detach(victim);
+  page_free(victim);
+  return 0;
+}
+
+/*
+ * reclaim_main — поток фонового освобождения в духе kswapd. Просыпается, когда
+ * свободных страниц становится не больше reclaim_low, и вытесняет страницы,
+ * пока их не наберётся reclaim_high, чтобы промах брал готовую страницу.
+ */
+static void* reclaim_main(void* arg) {
+  (void)arg;
+
+  pthread_mutex_lock(&cache.lock);
+  for (;;) {
+    pthread_cond_wait(&cache.reclaim, &cache.lock);
+    while (cache.free_pages < cache.reclaim_high && reclaim_one() == 0) {
+    }
+  }
+  return NULL;
+}
+
+/*
+ * handle_readahead(handle, index) — упреждающее чтение перед обращением
+ * к странице index. Последовательный поток удваивает окно от
+ * VTPC_READAHEAD_MIN до readahead_pages и запрашивает следующее окно, когда
+ * читатель проходит половину предыдущего. Непоследовательное обращение
+ * сбрасывает окно. Под NOREUSE окно не ведётся: холодные страницы вытесняли
+ * бы друг друга раньше, чем их прочтут.
+ */
+static void handle_readahead(struct vtpc_handle* handle, off_t index) {
+  if (index == handle->ra_prev) {
+    return;
+  }
+  int sequential = index == handle->ra_prev + 1;
+  handle->ra_prev = index;
+
+  int advice = handle_advice(handle, index);
+  if (advice == VTPC_FADV_RANDOM || advice == VTPC_FADV_NOREUSE ||
+      !sequential || config.readahead_pages == 0) {
+    handle->ra_window = 0;
+    handle->ra_end = index + 1;
+    return;
+  }
+
+  size_t max = config.readahead_pages;
+  size_t window = handle->ra_window ? handle->ra_window * 2
+                                    : VTPC_READAHEAD_MIN;
+  if (advice == VTPC_FADV_SEQUENTIAL) {
+    max *= VTPC_READAHEAD_SEQUENTIAL;
+    if (window < config.readahead_pages) {
+      window = config.readahead_pages;
+    }
+  }
+  size_t limit = cache.partitions[handle->partition].max_pages / 2;
+  if (max > limit) {
+    max = limit;
+  }
+  if (window > max) {
+    window = max;
+  }
+  if (window == 0 ||
+      handle->ra_end - index > (off_t)handle->ra_window / 2) {
+    return;
+  }
+
+  struct vtpc_job job = {
+      .type = VTPC_JOB_PREFETCH,
+      .file = handle->file,
+      .first = handle->ra_end > index ? handle->ra_end : index + 1,
+      .last = index + (off_t)window,
+      .partition = handle->partition,
+  };
+  handle->ra_window = window;
+  handle->ra_end = job.last + 1;
+  if (job.first <= job.last) {
+    job_submit(&job);
+  }
+}
+
+/* ------------------------------ Хэндлы ------------------------------ */
+
+static struct vtpc_handle* handle_get(int fd) {
+  size_t slot = (size_t)fd & (VTPC_HANDLES_MAX - 1);
+  unsigned generation = (unsigned)fd >> VTPC_HANDLE_SLOT_BITS;
+  if (fd < 0 || slot >= cache.handle_count || !cache.handles[slot].handle ||
+      cache.handles[slot].generation != generation) {
+    errno = EBADF;
+    return NULL;
+  }
+  return cache.handles[slot].handle;
+}
+
+/* handles_grow — удваивает таблицу хэндлов и добавляет новые ячейки в список
+ * свободных так, чтобы первыми выдавались меньшие номера. */
+static int handles_grow(void) {
+  size_t count = cache.handle_count ? cache.handle_count * 2
+                                    : VTPC_HANDLES_INITIAL;
+  if (count > VTPC_HANDLES_MAX) {
+    errno = EMFILE;
+    return -1;
+  }
+  struct vtpc_handle_slot* handles =
+      realloc(cache.handles, count * sizeof(*handles));
+  if (!handles) {
+    errno = ENOMEM;
+    return -1;
+  }
+
+  for (size_t i = count; i > cache.handle_count; --i) {
+    struct vtpc_handle_slot* slot = &handles[i - 1];
+    slot->handle = NULL;
+    slot->generation = 0;
+    slot->free_next = cache.handle_free;
+    cache.handle_free = i - 1;
+  }
+  cache.handles = handles;
+  cache.handle_count = count;
+  return 0;
+}
+
+static int handle_install(struct vtpc_handle* handle) {
+  if (cache.handle_free == VTPC_HANDLE_NONE && handles_grow() != 0) {
+    return -1;
+  }
+  size_t index = cache.handle_free;
+  struct vtpc_handle_slot* slot = &cache.handles[index];
+  cache.handle_free = slot->free_next;
+  slot->handle = handle;
+  return (int)((slot->generation << VTPC_HANDLE_SLOT_BITS) | index);
+}
+
+/* handle_remove — освобождает ячейку хэндла и меняет её поколение. */
+static void handle_remove(int fd) {
+  size_t index = (size_t)fd & (VTPC_HANDLES_MAX - 1);
+  struct vtpc_handle_slot* slot = &cache.handles[index];
+  slot->handle = NULL;
+  slot->generation = (slot->generation + 1) % VTPC_HANDLE_GENERATIONS;
+  slot->free_next = cache.handle_free;
+  cache.handle_free = index;
+}
+
+/* ------------------------------ API ------------------------------ */
+
+/* path_absolute — копия пути, не зависящая от текущего каталога, чтобы файл
+ * можно было открыть заново после chdir. */
+static char* path_absolute(const char* path) {
+  if (path[0] == '/') {
+    return strdup(path);
+  }
+  char* cwd = getcwd(NULL, 0);
+  if (!cwd) {
+    return NULL;
+  }
+  size_t cwd_len = strlen(cwd);
+  size_t path_len = strlen(path);
+  char* result = malloc(cwd_len + path_len + 2);
+  if (result) {
+    memcpy(result, cwd, cwd_len);
+    result[cwd_len] = '/';
+    memcpy(result + cwd_len + 1, path, path_len + 1);
+  }
+  free(cwd);
+  return result;
+}
+
+/* file_create — заводит файл по результату stat, пока без дескриптора ОС. */
+static struct vtpc_file* file_create(
+    const char* path, const struct stat* st, int writable
+) {
+  struct vtpc_file* file = calloc(1, sizeof(*file));
+  if (file) {
+    file->path = path_absolute(path);
+    file->dev = st->st_dev;
+    file->ino = st->st_ino;
+  }
+  if (!file || !file->path || file_insert(file) != 0) {
+    if (file) {
+      free(file->path);
+    }
+    free(file);
+    errno = ENOMEM;
+    return NULL;
+  }
+  file->id = ++cache.file_ids;
+  file->fd = -1;
+  file->writable = writable;
+  file->size = st->st_size;
+  file->disk_size = st->st_size;
+  file->refs = 1;
+  file_stamp(file, st);
+  return file;
+}
+
+/*
+ * open_fast(path, mode, out) — открывает существующий обычный файл одним
+ * stat, не трогая дескрипторы ОС: уже известный кэшу файл находится по
+ * (dev, ino), новый заводится без дескриптора, и его откроет file_fd при
+ * первом обращении к диску. Возвращает 1 и файл со взятой ссылкой, 0, если
+ * нужен настоящий open (создание, усечение, O_EXCL, не обычный файл, первое
+ * открытие на запись — права на неё проверяет ОС), или -1 с errno.
+ */
+static int open_fast(const char* path, int mode, struct vtpc_file** out) {
+  int writable = (mode & O_ACCMODE) != O_RDONLY;
+  if (mode & (O_EXCL | O_TRUNC)) {
+    return 0;
+  }
+  struct stat st;
+  if (cache.dev->stat(path, &st) != 0) {
+    return errno == ENOENT && (mode & O_CREAT) ? 0 : -1;
+  }
+  if (!S_ISREG(st.st_mode)) {
+    return 0;
+  }
+  struct vtpc_file* file = file_lookup(&st);
+  if (file) {
+    if (writable && !file->writable) {
+      return 0;
+    }
+    ++file->refs;
+  } else {
+    if (writable) {
+      return 0;
+    }
+    file = file_create(path, &st, 0);
+    if (!file) {
+      return -1;
+    }
+  }
+  *out = file;
+  return 1;
+}
+
+/* open_slow — открывает файл системным вызовом: создаёт, усекает или
+ * проверяет права на запись. Возвращает файл со взятой ссылкой или NULL. */
+static struct vtpc_file* open_slow(const char* path, int mode, int access) {
+  int writable = (mode & O_ACCMODE) != O_RDONLY;
+  int flags = (mode & ~(O_ACCMODE | O_APPEND)) | (writable ? O_RDWR : O_RDONLY);
+  int kernel_fd = cache.dev->open(path, flags, access);
+  struct stat st;
+  if (kernel_fd < 0 || cache.dev->fstat(kernel_fd, &st) != 0) {
+    int saved = errno;
+    if (kernel_fd >= 0) {
+      cache.dev->close(kernel_fd);
+    }
+    errno = saved;
+    return NULL;
+  }
+
+  /* O_TRUNC уже изменил отпечаток, но страницы файла всё равно сбрасываются
+   * ниже, так что сверять его незачем. */
+  struct vtpc_file* file = (mode & O_TRUNC) ? file_find(st.st_dev, st.st_ino)
+                                            : file_lookup(&st);
+  if (file) {
+    ++file->refs;
+    if (writable && !file->writable) {
+      file_wait_idle(file);
+      if (file->fd >= 0) {
+        fd_close(file);
+      }
+      fd_attach(file, kernel_fd);
+      file->writable = 1;
+    } else if (file->fd < 0) {
+      fd_attach(file, kernel_fd);
+    } else {
+      cache.dev->close(kernel_fd);
+    }
+    if (mode & O_TRUNC) {
+      file_quiesce(file);
+      file_drop_pages(file);
+      file->id = ++cache.file_ids;
+      file->size = 0;
+      file->disk_size = 0;
+    }
+  } else {
+    file = file_create(path, &st, writable);
+    if (!file) {
+      cache.dev->close(kernel_fd);
+      return NULL;
+    }
+    fd_attach(file, kernel_fd);
+  }
+  return file;
+}
+
+static int open_locked(const char* path, int mode, int access) {
+  if (cache_init() != 0) {
+    return -1;
+  }
+
+  int accmode = mode & O_ACCMODE;
+  int writable = accmode != O_RDONLY;
+  struct vtpc_handle* handle = calloc(1, sizeof(*handle));
+  if (!handle) {
+    errno = ENOMEM;
+    return -1;
+  }
+
+  struct vtpc_file* file = NULL;
+  int fast = open_fast(path, mode, &file);
+  if (fast == 0) {
+    file = open_slow(path, mode, access);
+  }
+  if (!file) {
+    free(handle);
+    return -1;
+  }
+
+  handle->file = file;
+  handle->readable = accmode != O_WRONLY;
+  handle->writable = writable;
+  handle->append = (mode & O_APPEND) != 0;
+  handle->partition = VTPC_DEFAULT_PARTITION;
+  handle->ra_prev = -1;
+
+  int fd = handle_install(handle);
+  if (fd < 0) {
+    if (--file->refs == 0) {
+      file_release(file);
+    }
+    free(handle);
+  }
+  return fd;
+}
+
 int vtpc_open(const char* path, int mode, int access) {
-  return open(path, mode, access);
+  pthread_mutex_lock(&cache.lock);
+  int fd = open_locked(path, mode, access);
+  pthread_mutex_unlock(&cache.lock);
+  return fd;
 }
 
 int vtpc_close(int fd) {
-  return close(fd);
+  pthread_mutex_lock(&cache.lock);
+  struct vtpc_handle* handle = handle_get(fd);
+  if (!handle) {
+    pthread_mutex_unlock(&cache.lock);
+    return -1;
+  }
+  handle_remove(fd);
+
+  int result = 0;
+  struct vtpc_file* file = handle->file;
+  if (file->refs == 1) {
+    file_quiesce(file);
+  }
+  if (--file->refs == 0) {
+    result = file_flush(file);
+    int saved = errno;
+    file_release(file);
+    errno = saved;
+  }
+  free(handle);
+
+  pthread_mutex_unlock(&cache.lock);
+  return result;
+}
+
+static ssize_t read_locked(
+    struct vtpc_handle* handle, char* buf, size_t count
+) {
+  struct vtpc_file* file = handle->file;
+  if (handle->pos >= file->size) {
+    return 0;
+  }
+  if ((off_t)count > file->size - handle->pos) {
+    count = (size_t)(file->size - handle->pos);
+  }
+
+  size_t done = 0;
+  while (done < count) {
+    off_t pos = handle->pos + (off_t)done;
+    off_t index = pos / VTPC_PAGE_SIZE;
+    size_t offset = (size_t)(pos % VTPC_PAGE_SIZE);
+    size_t chunk = VTPC_PAGE_SIZE - offset;
+    if (chunk > count - done) {
+      chunk = count - done;
+    }
+
+    handle_readahead(handle, index);
+    struct vtpc_page* page = page_get(handle, index, 1);
+    if (!page) {
+      break;
+    }
+    memcpy(buf + done, page->data + offset, chunk);
+    done += chunk;
+
+    if (offset + chunk == VTPC_PAGE_SIZE &&
+        handle_advice(handle, index) == VTPC_FADV_SEQUENTIAL) {
+      page_cool(page);
+    }
+  }
+
+  handle->pos += (off_t)done;
+  return done > 0 ? (ssize_t)done : (count > 0 ? -1 : 0);
 }
 
 ssize_t vtpc_read(int fd, void* buf, size_t count) {
-  return read(fd, buf, count);
+  pthread_mutex_lock(&cache.lock);
+  struct vtpc_handle* handle = handle_get(fd);
+  ssize_t result = -1;
+  if (handle && !handle->readable) {
+    errno = EBADF;
+  } else if (handle) {
+    result = read_locked(handle, buf, count);
+  }
+  monitor_tick();
+  pthread_mutex_unlock(&cache.lock);
+  return result;
+}
+
+static ssize_t write_locked(
+    struct vtpc_handle* handle, const char* buf, size_t count
+) {
+  struct vtpc_file* file = handle->file;
+  if (handle->append) {
+    handle->pos = file->size;
+  }
+  /* Дескриптор понадобится для сброса; ошибку открытия (права, ESTALE)
+   * лучше вернуть сейчас, чем потерять данные при вытеснении. */
+  if (count > 0 && file->fd < 0 && file_fd(file) < 0) {
+    return -1;
+  }
+
+  size_t done = 0;
+  while (done < count) {
+    off_t pos = handle->pos + (off_t)done;
+    off_t index = pos / VTPC_PAGE_SIZE;
+    size_t offset = (size_t)(pos % VTPC_PAGE_SIZE);
+    size_t chunk = VTPC_PAGE_SIZE - offset;
+    if (chunk > count - done) {
+      chunk = count - done;
+    }
+
+    int whole = offset == 0 && chunk == VTPC_PAGE_SIZE;
+    struct vtpc_page* page = page_get(handle, index, !whole);
+    if (!page) {
+      break;
+    }
+    memcpy(page->data + offset, buf + done, chunk);
+    page_mark_dirty(page);
+    done += chunk;
+
+    if (pos + (off_t)chunk > file->size) {
+      file->size = pos + (off_t)chunk;
+    }
+  }
+
+  handle->pos += (off_t)done;
+  return done > 0 ? (ssize_t)done : (count > 0 ? -1 : 0);
 }
 
 ssize_t vtpc_write(int fd, const void* buf, size_t count) {
-  return write(fd, buf, count);
+  pthread_mutex_lock(&cache.lock);
+  struct vtpc_handle* handle = handle_get(fd);
+  ssize_t result = -1;
+  if (handle && !handle->writable) {
+    errno = EBADF;
+  } else if (handle) {
+    result = write_locked(handle, buf, count);
+  }
+  monitor_tick();
+  pthread_mutex_unlock(&cache.lock);
+  return result;
 }
 
 off_t vtpc_lseek(int fd, off_t offset, int whence) {
-  return lseek(fd, offset, whence);
+  pthread_mutex_lock(&cache.lock);
+  struct vtpc_handle* handle = handle_get(fd);
+  if (!handle) {
+    pthread_mutex_unlock(&cache.lock);
+    return -1;
+  }
+
+  off_t base = 0;
+  if (whence == SEEK_CUR) {
+    base = handle->pos;
+  } else if (whence == SEEK_END) {
+    base = handle->file->size;
+  } else if (whence != SEEK_SET) {
+    pthread_mutex_unlock(&cache.lock);
+    errno = EINVAL;
+    return -1;
+  }
+  if (base + offset < 0) {
+    pthread_mutex_unlock(&cache.lock);
+    errno = EINVAL;
+    return -1;
+  }
+
+  handle->pos = base + offset;
+  off_t result = handle->pos;
+  pthread_mutex_unlock(&cache.lock);
+  return result;
 }
 
 int vtpc_fsync(int fd) {
-  return fsync(fd);
+  pthread_mutex_lock(&cache.lock);
+  struct vtpc_handle* handle = handle_get(fd);
+  int result = -1;
+  if (handle && file_flush(handle->file) == 0) {
+    int kernel_fd = file_fd(handle->file);
+    result = kernel_fd < 0 ? -1 : cache.dev->fsync(kernel_fd);
+  }
+  monitor_tick();
+  pthread_mutex_unlock(&cache.lock);
+  return result;
+}
+
+/* handle_advise — запоминает подсказку для страниц [first, last]; при
+ * переполнении забывается самая старая. */
+static void handle_advise(
+    struct vtpc_handle* handle, off_t first, off_t last, int advice
+) {
+  if (advice == VTPC_FADV_NORMAL && first == 0 && last == VTPC_LAST_PAGE) {
+    handle->advice_count = 0;
+    return;
+  }
+  if (handle->advice_count == VTPC_ADVICE_RANGES) {
+    memmove(
+        handle->advice,
+        handle->advice + 1,
+        (VTPC_ADVICE_RANGES - 1) * sizeof(*handle->advice)
+    );
+    --handle->advice_count;
+  }
+  handle->advice[handle->advice_count++] = (struct vtpc_advice){
+      .first = first,
+      .last = last,
+      .advice = advice,
+  };
+}
+
+/* file_dontneed — снимает упреждающее чтение файла, выбрасывает чистые
+ * страницы диапазона и отдаёт грязные фоновому потоку на запись. */
+static void file_dontneed(
+    struct vtpc_file* file, off_t first, off_t last, int partition
+) {
+  file_quiesce(file);
+
+  int dirty = 0;
+  struct vtpc_page* page = file->pages;
+  while (page) {
+    struct vtpc_page* next = page->file_next;
+    if (first <= page->index && page->index <= last && !page->loading &&
+        !page->pinned) {
+      if (page->dirty) {
+        dirty = 1;
+      } else {
+        page_detach(page);
+        page_free(page);
+      }
+    }
+    page = next;
+  }
+
+  if (dirty) {
+    struct vtpc_job job = {
+        .type = VTPC_JOB_WRITEBACK,
+        .file = file,
+        .first = first,
+        .last = last,
+        .partition = partition,
+    };
+    job_submit(&job);
+  }
+}
+
+int vtpc_fadvise(int fd, off_t offset, off_t len, int advice) {
+  if (offset < 0 || len < 0 || advice < VTPC_FADV_NORMAL ||
+      advice > VTPC_FADV_NOREUSE) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  pthread_mutex_lock(&cache.lock);
+  struct vtpc_handle* handle = handle_get(fd);
+  if (!handle) {
+    pthread_mutex_unlock(&cache.lock);
+    return -1;
+  }
+
+  off_t first = offset / VTPC_PAGE_SIZE;
+  off_t last = VTPC_LAST_PAGE;
+  if (len > 0 && len <= INT64_MAX - offset) {
+    last = (offset + len - 1) / VTPC_PAGE_SIZE;
+  }
+
+  struct vtpc_file* file = handle->file;
+  if (advice == VTPC_FADV_WILLNEED) {
+    struct vtpc_job job = {
+        .type = VTPC_JOB_PREFETCH,
+        .file = file,
+        .first = first,
+        .last = last,
+        .partition = handle->partition,
+        .cold = handle_advice(handle, first) == VTPC_FADV_NOREUSE,
+    };
+    job_submit(&job);
+  } else if (advice == VTPC_FADV_DONTNEED) {
+    file_dontneed(file, first, last, handle->partition);
+  } else {
+    handle_advise(handle, first, last, advice);
+  }
+
+  pthread_mutex_unlock(&cache.lock);
+  return 0;
+}
+
+/* ---------------------------- Закрепление ---------------------------- */
+
+/* page_pin — закрепляет страницу, вынимая её из LRU: вытеснение её не видит. */
+static void page_pin(struct vtpc_page* page) {
+  if (page->pinned++ == 0) {
+    lru_remove(&cache.partitions[page->partition].lru, page);
+    ++cache.locked_pages;
+  }
+}
+
+static void page_unpin(struct vtpc_page* page) {
+  if (--page->pinned == 0) {
+    lru_push_head(&cache.partitions[page->partition].lru, page);
+    --cache.locked_pages;
+  }
+}
+
+/* file_last_page — номер последней страницы диапазона [offset, offset + len)
+ * в пределах файла; len == 0 означает «до конца файла». */
+static off_t file_last_page(
+    const struct vtpc_file* file, off_t offset, off_t len
+) {
+  off_t end = file->size;
+  if (len > 0 && len <= INT64_MAX - offset && offset + len < end) {
+    end = offset + len;
+  }
+  return (end - 1) / VTPC_PAGE_SIZE;
+}
+
+static int lock_range_locked(
+    struct vtpc_handle* handle, off_t offset, off_t len
+) {
+  struct vtpc_file* file = handle->file;
+  if (offset >= file->size) {
+    return 0;
+  }
+  off_t first = offset / VTPC_PAGE_SIZE;
+  off_t last = file_last_page(file, offset, len);
+
+  size_t needed = 0;
+  for (off_t index = first; index <= last; ++index) {
+    struct vtpc_page* page = hash_find(file, index);
+    if (!page || !page->pinned) {
+      ++needed;
+    }
+  }
+  if (needed > cache.locked_max - cache.locked_pages) {
+    errno = ENOMEM;
+    return -1;
+  }
+
+  for (off_t index = first; index <= last; ++index) {
+    struct vtpc_page* page = page_get(handle, index, 1);
+    if (page && !page->pinned && cache.locked_pages == cache.locked_max) {
+      errno = ENOMEM;
+      page = NULL;
+    }
+    if (!page) {
+      int saved = errno;
+      while (index-- > first) {
+        page = hash_find(file, index);
+        if (page && page->pinned) {
+          page_unpin(page);
+        }
+      }
+      errno = saved;
+      return -1;
+    }
+    page_pin(page);
+  }
+  return 0;
+}
+
+int vtpc_lock_range(int fd, off_t offset, off_t len) {
+  if (offset < 0 || len < 0) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  pthread_mutex_lock(&cache.lock);
+  struct vtpc_handle* handle = handle_get(fd);
+  int result = handle ? lock_range_locked(handle, offset, len) : -1;
+  pthread_mutex_unlock(&cache.lock);
+  return result;
+}
+
+int vtpc_unlock_range(int fd, off_t offset, off_t len) {
+  if (offset < 0 || len < 0) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  pthread_mutex_lock(&cache.lock);
+  struct vtpc_handle* handle = handle_get(fd);
+  if (!handle) {
+    pthread_mutex_unlock(&cache.lock);
+    return -1;
+  }
+
+  struct vtpc_file* file = handle->file;
+  off_t first = offset / VTPC_PAGE_SIZE;
+  off_t last = VTPC_LAST_PAGE;
+  if (len > 0 && len <= INT64_MAX - offset) {
+    last = (offset + len - 1) / VTPC_PAGE_SIZE;
+  }
+  for (struct vtpc_page* page = file->pages; page; page = page->file_next) {
+    if (page->pinned && first <= page->index && page->index <= last) {
+      page_unpin(page);
+    }
+  }
+
+  pthread_mutex_unlock(&cache.lock);
+  return 0;
+}
+
+int vtpc_stats(struct vtpc_stats* stats) {
+  if (!stats) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  pthread_mutex_lock(&cache.lock);
+  stats_fill(stats);
+  pthread_mutex_unlock(&cache.lock);
+  return 0;
+}
+
+int vtpc_sim_stats(struct vtpc_sim_stats* stats) {
+  if (!stats) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  pthread_mutex_lock(&cache.lock);
+  int on_sim = cache_init() == 0 && cache.dev == &vtpc_dev_sim;
+  pthread_mutex_unlock(&cache.lock);
+  if (!on_sim) {
+    errno = ENODEV;
+    return -1;
+  }
+  vtpc_sim_read_stats(stats);
+  return 0;
+}
+
+/* ------------------------------ Разделы ------------------------------ */
+
+static int partition_find_locked(const char* name) {
+  for (int i = 0; i < VTPC_MAX_PARTITIONS; ++i) {
+    if (cache.partitions[i].active &&
+        strcmp(cache.partitions[i].name, name) == 0) {
+      return i;
+    }
+  }
+  errno = ENOENT;
+  return -1;
+}
+
+static int partition_create_locked(
+    const char* name, size_t min_pages, size_t max_pages
+) {
+  if (cache_init() != 0) {
+    return -1;
+  }
+  if (max_pages == 0 || max_pages > cache.capacity) {
+    max_pages = cache.capacity;
+  }
+  if (strlen(name) >= VTPC_PARTITION_NAME_MAX || min_pages > max_pages) {
+    errno = EINVAL;
+    return -1;
+  }
+  if (partition_find_locked(name) >= 0) {
+    errno = EEXIST;
+    return -1;
+  }
+
+  size_t reserved = min_pages;
+  int slot = -1;
+  for (int i = 0; i < VTPC_MAX_PARTITIONS; ++i) {
+    if (cache.partitions[i].active) {
+      reserved += cache.partitions[i].min_pages;
+    } else if (slot < 0) {
+      slot = i;
+    }
+  }
+  if (slot < 0) {
+    errno = ENOSPC;
+    return -1;
+  }
+  if (reserved > cache.capacity) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  struct vtpc_partition* part = &cache.partitions[slot];
+  memset(part, 0, sizeof(*part));
+  part->active = 1;
+  strcpy(part->name, name);  // NOLINT
+  part->min_pages = min_pages;
+  part->max_pages = max_pages;
+  return slot;
+}
+
+int vtpc_partition_create(
+    const char* name, size_t min_pages, size_t max_pages
+) {
+  if (!name || name[0] == '\0') {
+    errno = EINVAL;
+    return -1;
+  }
+
+  pthread_mutex_lock(&cache.lock);
+  int result = partition_create_locked(name, min_pages, max_pages);
+  pthread_mutex_unlock(&cache.lock);
+  return result;
+}
+
+int vtpc_partition_find(const char* name) {
+  if (!name) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  pthread_mutex_lock(&cache.lock);
+  int result = partition_find_locked(name);
+  pthread_mutex_unlock(&cache.lock);
+  return result;
+}
+
+static int partition_valid(int partition) {
+  if (partition < 0 || partition >= VTPC_MAX_PARTITIONS ||
+      !cache.partitions[partition].active) {
+    errno = EINVAL;
+    return 0;
+  }
+  return 1;
+}
+
+int vtpc_set_partition(int fd, int partition) {
+  pthread_mutex_lock(&cache.lock);
+  struct vtpc_handle* handle = handle_get(fd);
+  int result = -1;
+  if (handle && partition_valid(partition)) {
+    handle->partition = partition;
+    result = 0;
+  }
+  pthread_mutex_unlock(&cache.lock);
+  return result;
+}
+
+int vtpc_partition_stats(int partition, struct vtpc_partition_stats* stats) {
+  if (!stats) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  pthread_mutex_lock(&cache.lock);
+  int result = -1;
+  if (cache_init() == 0 && partition_valid(partition)) {
+    partition_fill(&cache.partitions[partition], stats);
+    result = 0;
+  }
+  pthread_mutex_unlock(&cache.lock);
+  return result;
 }
@@ -1,10 +1,262 @@
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
 #include <sys/types.h>
 
+/* Размер страницы кэша; все операции с диском выполняются целыми страницами. */
+#define VTPC_PAGE_SIZE 4096
+
+/* Максимальное число разделов кэша, включая раздел по умолчанию. */
+#define VTPC_MAX_PARTITIONS 16
+
+/* Максимальная длина имени раздела вместе с завершающим нулём. */
+#define VTPC_PARTITION_NAME_MAX 32
+
+/* Раздел, в который попадают все хэндлы сразу после vtpc_open. */
+#define VTPC_DEFAULT_PARTITION 0
+
+/* Подсказки vtpc_fadvise; значения совпадают с POSIX_FADV_* в Linux. */
+#define VTPC_FADV_NORMAL 0     /* обычное упреждающее чтение */
+#define VTPC_FADV_RANDOM 1     /* упреждающее чтение отключено */
+#define VTPC_FADV_SEQUENTIAL 2 /* крупное упреждение, прочитанное — в хвост */
+#define VTPC_FADV_WILLNEED 3   /* загрузить диапазон в фоне */
+#define VTPC_FADV_DONTNEED 4   /* выбросить чистые страницы, сбросить грязные */
+#define VTPC_FADV_NOREUSE 5    /* новые страницы ставить в холодный конец */
+
+/* Устройства, на которых может работать кэш. */
+#define VTPC_DEVICE_POSIX 0 /* обычные файлы, открытые с O_DIRECT */
+#define VTPC_DEVICE_SIM 1   /* файлы в памяти с моделью задержек диска */
+
+/* Часы симулятора: реальное ожидание или виртуальное время. */
+#define VTPC_SIM_CLOCK_WALL 0
+#define VTPC_SIM_CLOCK_VIRTUAL 1
+
+/*
+ * vtpc_sim_config — модель диска. Время обслуживания запроса складывается из
+ * latency_ns, стоимости позиционирования и передачи данных со скоростью
+ * bandwidth. Позиционирование бесплатно для запроса, продолжающего предыдущий;
+ * иначе оно стоит от seek_min_ns до seek_max_ns линейно по расстоянию, которое
+ * достигает максимума на seek_span байтах или при переходе к другому файлу.
+ * Устройство обслуживает до queue_depth запросов одновременно; с виртуальными
+ * часами параллельно обслуживаются запросы разных потоков.
+ */
+struct vtpc_sim_config {
+  int clock;
+  uint64_t latency_ns;
+  uint64_t seek_min_ns;
+  uint64_t seek_max_ns;
+  uint64_t seek_span;
+  uint64_t bandwidth; /* байт в секунду, 0 — без ограничения */
+  unsigned queue_depth;
+};
+
+/* vtpc_sim_stats — нагрузка на симулируемое устройство. */
+struct vtpc_sim_stats {
+  uint64_t reads;
+  uint64_t writes;
+  uint64_t bytes_read;
+  uint64_t bytes_written;
+  uint64_t busy_ns;    /* суммарное время обслуживания запросов */
+  uint64_t latency_ns; /* суммарная задержка запросов с учётом очереди */
+  uint64_t max_latency_ns;
+  /* время устройства с момента запуска; у виртуальных часов — момент
+   * завершения последнего запроса */
+  uint64_t clock_ns;
+};
+
+/*
+ * vtpc_config — параметры кэша, задаваемые до первого обращения к нему.
+ * Фоновый поток держит запас свободных страниц: когда их остаётся не больше
+ * reclaim_low, он вытесняет страницы, пока свободных не станет reclaim_high.
+ * Второй уровень кэша — файл l2_path на быстром локальном диске, куда
+ * попадают вытесненные из памяти чистые страницы; путь читается при первом
+ * обращении к кэшу, а файл создаётся заново. Хэндл не держит собственного
+ * дескриптора ОС: уже существующий файл, открываемый на чтение, и любой
+ * файл, уже известный кэшу, находятся одним stat, а дескриптор открывается
+ * при первом обращении к диску — тогда же, а не в vtpc_open, проявляется
+ * отказ в правах на чтение. Открытыми остаются не больше max_fds последних
+ * использованных файлов, остальные открываются заново по пути при обращении
+ * к диску, а их страницы тем временем остаются в кэше. Файл с грязными
+ * страницами держит свой дескриптор до их записи, поэтому переименование
+ * или удаление файла не мешает обратной записи, а дескрипторов может
+ * временно оказаться больше max_fds. Дописываемые файлы
+ * растут на диске участками по extent_pages страниц, выделенными fallocate;
+ * до vtpc_fsync или закрытия файл на диске может быть длиннее логического
+ * размера, и тогда неиспользованный хвост срезается.
+ *
+ * Ноль в readahead_pages, reclaim_high и extent_pages выключает возможность,
+ * поэтому конфигурацию, отличающуюся от умолчаний парой полей, начинают с
+ * VTPC_CONFIG_DEFAULT и меняют нужные поля.
+ */
+struct vtpc_config {
+  size_t cache_pages;     /* ёмкость кэша в страницах */
+  size_t readahead_pages; /* предел окна упреждения, 0 — без упреждения */
+  int device;             /* VTPC_DEVICE_POSIX или VTPC_DEVICE_SIM */
+  struct vtpc_sim_config sim;
+  const char* l2_path; /* файл второго уровня */
+  size_t l2_pages;     /* ёмкость второго уровня, 0 — уровень выключен */
+  size_t locked_pages; /* предел закреплённых страниц, 0 — половина ёмкости */
+  size_t reclaim_low;  /* нижняя отметка свободных страниц */
+  size_t reclaim_high; /* верхняя отметка, 0 — без фонового освобождения */
+  int monitor;         /* публиковать счётчики для vtpc-top, 0 — нет */
+  size_t max_fds;      /* дескрипторов ОС на все файлы, 0 — по умолчанию */
+  size_t extent_pages; /* шаг предвыделения, 0 — без предвыделения */
+};
+
+/* Умолчания кэша, с которыми он работает без vtpc_configure. */
+#define VTPC_DEFAULT_CACHE_PAGES 1024
+#define VTPC_DEFAULT_READAHEAD_PAGES 32
+#define VTPC_DEFAULT_RECLAIM_LOW 16
+#define VTPC_DEFAULT_RECLAIM_HIGH 32
+#define VTPC_DEFAULT_EXTENT_PAGES 256
+
+/* VTPC_CONFIG_DEFAULT — инициализатор vtpc_config со всеми умолчаниями. */
+#define VTPC_CONFIG_DEFAULT                            \
+  {                                                    \
+      .cache_pages = VTPC_DEFAULT_CACHE_PAGES,         \
+      .readahead_pages = VTPC_DEFAULT_READAHEAD_PAGES, \
+      .device = VTPC_DEVICE_POSIX,                     \
+      .reclaim_low = VTPC_DEFAULT_RECLAIM_LOW,         \
+      .reclaim_high = VTPC_DEFAULT_RECLAIM_HIGH,       \
+      .extent_pages = VTPC_DEFAULT_EXTENT_PAGES,       \
+  }
+
+/* vtpc_stats — сводные счётчики кэша. */
+struct vtpc_stats {
+  uint64_t hits;            /* обращения, обслуженные из кэша */
+  uint64_t misses;          /* обращения, ждавшие загрузки страницы */
+  uint64_t evictions;       /* вытесненные страницы */
+  uint64_t writebacks;      /* записи грязных страниц на диск */
+  uint64_t readahead_pages; /* страницы, загруженные упреждением */
+  uint64_t readahead_hits;  /* из них использованные до вытеснения */
+  uint64_t readahead_waits; /* из них дочитанные при ожидании, это промахи */
+  size_t used_pages;        /* занятые страницы */
+  size_t dirty_pages;       /* грязные страницы */
+  size_t locked_pages;      /* страницы, закреплённые vtpc_lock_range */
+  size_t free_pages;        /* незанятые страницы */
+  uint64_t reclaimed_pages; /* страницы, освобождённые фоновым потоком */
+  uint64_t l2_hits;         /* промахи в памяти, обслуженные вторым уровнем */
+  uint64_t l2_misses;       /* промахи, ушедшие мимо второго уровня на диск */
+  uint64_t l2_writes;       /* страницы, записанные во второй уровень */
+  size_t l2_used_pages;     /* занятые ячейки второго уровня */
+  size_t open_fds;          /* открытые дескрипторы ОС */
+  uint64_t fd_reopens;      /* открытия по пути: отложенные и после LRU */
+};
+
+/* vtpc_partition_stats — квота и счётчики одного раздела. */
+struct vtpc_partition_stats {
+  char name[VTPC_PARTITION_NAME_MAX];
+  size_t min_pages;   /* гарантированный минимум */
+  size_t max_pages;   /* верхняя граница */
+  size_t used_pages;  /* страницы, принадлежащие разделу */
+  uint64_t hits;      /* попадания хэндлов раздела */
+  uint64_t misses;    /* промахи хэндлов раздела */
+  uint64_t evictions; /* страницы раздела, вытесненные из кэша */
+};
+
+/* Число корзин гистограммы задержек промахов. */
+#define VTPC_MONITOR_BUCKETS 32
+
+/*
+ * vtpc_monitor — снимок счётчиков, который кэш с включённым
+ * vtpc_config.monitor публикует в разделяемой памяти /vtpc.<pid> не реже
+ * раза в VTPC_MONITOR_INTERVAL_MS, пока процесс обращается к кэшу. Монитор
+ * выключен по умолчанию. Сегмент удаляется при обычном завершении процесса
+ * (exit или возврат из main); после _exit, сигнала или падения он остаётся
+ * в /dev/shm до перезагрузки, пока его не удалят вручную или пока процесс
+ * с тем же pid не включит монитор снова.
+ */
+struct vtpc_monitor {
+  pid_t pid;
+  uint64_t time_ns; /* момент снимка по CLOCK_MONOTONIC */
+  size_t capacity;  /* ёмкость кэша в страницах */
+  struct vtpc_stats stats;
+  uint64_t miss_ns; /* суммарная задержка промахов */
+  /* число промахов с задержкой из [2^i, 2^(i+1)) нс */
+  uint64_t miss_latency[VTPC_MONITOR_BUCKETS];
+  size_t partition_count;
+  struct vtpc_partition_stats partitions[VTPC_MAX_PARTITIONS];
+};
+
+#define VTPC_MONITOR_INTERVAL_MS 100
+
+/*
+ * vtpc_configure(config)
+ * Задаёт параметры кэша. Допустимо только до первого vtpc_open или создания
+ * раздела, иначе возвращает -1 с errno = EBUSY.
+ */
+int vtpc_configure(const struct vtpc_config* config);
+
 int vtpc_open(const char* path, int mode, int access);
 int vtpc_close(int fd);
 ssize_t vtpc_read(int fd, void* buf, size_t count);
 ssize_t vtpc_write(int fd, const void* buf, size_t count);
 off_t vtpc_lseek(int fd, off_t offset, int whence);
 int vtpc_fsync(int fd);
+
+/*
+ * vtpc_fadvise(fd, offset, len, advice)
+ * Сообщает кэшу, как будет использоваться диапазон [offset, offset + len)
+ * (len == 0 — до конца файла), по аналогии с posix_fadvise. NORMAL, RANDOM,
+ * SEQUENTIAL и NOREUSE запоминаются для диапазона хэндла; более поздняя
+ * подсказка перекрывает более раннюю. WILLNEED и DONTNEED выполняются сразу:
+ * загрузка и запись грязных страниц идут в фоновом потоке. В отличие от
+ * posix_fadvise, ошибка возвращается как -1 с errno.
+ */
+int vtpc_fadvise(int fd, off_t offset, off_t len, int advice);
+
+/*
+ * vtpc_lock_range(fd, offset, len)
+ * Загружает диапазон [offset, offset + len) (len == 0 — до конца файла) и
+ * исключает его страницы из вытеснения, по аналогии с mlock. Закрепления одной
+ * страницы складываются. Если закреплённых страниц стало бы больше предела
+ * vtpc_config.locked_pages, возвращает -1 с errno = ENOMEM и ничего не
+ * закрепляет. Страницы за концом файла не закрепляются.
+ */
+int vtpc_lock_range(int fd, off_t offset, off_t len);
+
+/*
+ * vtpc_unlock_range(fd, offset, len)
+ * Снимает одно закрепление со страниц диапазона. Все закрепления файла
+ * снимаются, когда закрывается его последний хэндл.
+ */
+int vtpc_unlock_range(int fd, off_t offset, off_t len);
+
+/* vtpc_stats(stats) — копирует сводные счётчики кэша в stats. */
+int vtpc_stats(struct vtpc_stats* stats);
+
+/*
+ * vtpc_sim_stats(stats) — счётчики симулируемого устройства. Возвращает -1 с
+ * errno = ENODEV, если кэш работает не на VTPC_DEVICE_SIM.
+ */
+int vtpc_sim_stats(struct vtpc_sim_stats* stats);
+
+/*
+ * vtpc_partition_create(name, min_pages, max_pages)
+ * Создаёт именованный раздел кэша. Раздел всегда может удерживать min_pages
+ * страниц и никогда не превышает max_pages (0 — без ограничения). При нехватке
+ * места жертва выбирается только среди разделов, занявших больше своего
+ * минимума. Возвращает номер раздела либо -1 с errno.
+ */
+int vtpc_partition_create(const char* name, size_t min_pages, size_t max_pages);
+
+/* vtpc_partition_find(name) — номер раздела по имени либо -1 (ENOENT). */
+int vtpc_partition_find(const char* name);
+
+/*
+ * vtpc_set_partition(fd, partition)
+ * Относит хэндл к разделу: новые страницы, загруженные через него, а также его
+ * попадания и промахи учитываются в этом разделе.
+ */
+int vtpc_set_partition(int fd, int partition);
+
+/* vtpc_partition_stats(partition, stats) — квота и счётчики раздела. */
+int vtpc_partition_stats(int partition, struct vtpc_partition_stats* stats);
+
+/*
+ * vtpc_monitor_read(pid, monitor)
+ * Читает последний снимок, опубликованный процессом pid, не останавливая его.
+ * Возвращает -1 с errno = ENOENT, если процесс ничего не публикует.
+ */
+int vtpc_monitor_read(pid_t pid, struct vtpc_monitor* monitor);
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "vtpc.h"
+
+/*
+ * vtpc_dev — устройство, на котором лежат файлы кэша. Набор операций повторяет
+ * соответствующие системные вызовы; дескрипторы принадлежат устройству.
+ */
+struct vtpc_dev {
+  int (*open)(const char* path, int flags, int access);
+  int (*close)(int fd);
+  int (*fstat)(int fd, struct stat* st);
+  int (*stat)(const char* path, struct stat* st);
+  ssize_t (*pread)(int fd, void* buf, size_t count, off_t offset);
+  ssize_t (*pwrite)(int fd, const void* buf, size_t count, off_t offset);
+  int (*ftruncate)(int fd, off_t size);
+  int (*fallocate)(int fd, int mode, off_t offset, off_t len);
+  int (*fsync)(int fd);
+};
+
+/* Файлы ОС, открытые в обход страничного кэша ядра. */
+extern const struct vtpc_dev vtpc_dev_posix;
+
+/* Файлы в памяти с моделью задержек из vtpc_sim_config. */
+extern const struct vtpc_dev vtpc_dev_sim;
+
+/* vtpc_sim_setup(config) — запускает симулятор; вызывается один раз. */
+int vtpc_sim_setup(const struct vtpc_sim_config* config);
+
+/* vtpc_sim_read_stats(stats) — снимок счётчиков симулятора. */
+void vtpc_sim_read_stats(struct vtpc_sim_stats* stats);
@@ -0,0 +1,205 @@
+#include "vtpc_index.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define VTPC_INDEX_EMPTY 0x80U
+#define VTPC_INDEX_DELETED 0xFEU
+#define VTPC_INDEX_H2_BITS 7U
+#define VTPC_INDEX_H2_MASK 0x7FU
+#define VTPC_INDEX_MULTIPLIER 0x9E3779B97F4A7C15ULL
+#define VTPC_INDEX_FOLD 32U
+
+static uint64_t index_hash(const void* file, off_t page) {
+  uint64_t key = (uint64_t)(uintptr_t)file * VTPC_INDEX_MULTIPLIER;
+  key = (key ^ (uint64_t)page) * VTPC_INDEX_MULTIPLIER;
+  return key ^ (key >> VTPC_INDEX_FOLD);
+}
+
+/* group_match — маска ячеек группы, метаданные которых равны value. */
+static uint32_t group_match(const uint8_t* ctrl, uint8_t value) {
+#ifdef __SSE2__
+  __m128i group = _mm_loadu_si128((const __m128i*)ctrl);
+  __m128i equal = _mm_cmpeq_epi8(group, _mm_set1_epi8((char)value));
+  return (uint32_t)_mm_movemask_epi8(equal);
+#else
+  uint32_t mask = 0;
+  for (unsigned i = 0; i < VTPC_INDEX_GROUP; ++i) {
+    mask |= (uint32_t)(ctrl[i] == value) << i;
+  }
+  return mask;
+#endif
+}
+
+/* group_free — маска пустых и удалённых ячеек группы. */
+static uint32_t group_free(const uint8_t* ctrl) {
+#ifdef __SSE2__
+  __m128i group = _mm_loadu_si128((const __m128i*)ctrl);
+  return (uint32_t)_mm_movemask_epi8(group);
+#else
+  uint32_t mask = 0;
+  for (unsigned i = 0; i < VTPC_INDEX_GROUP; ++i) {
+    mask |= (uint32_t)(ctrl[i] >> VTPC_INDEX_H2_BITS) << i;
+  }
+  return mask;
+#endif
+}
+
+/* index_set_ctrl — записывает метаданные ячейки; первая группа дублируется за
+ * концом таблицы, чтобы группа, начатая у конца, читалась одним сравнением. */
+static void index_set_ctrl(
+    struct vtpc_index* index, size_t slot, uint8_t ctrl
+) {
+  index->ctrl[slot] = ctrl;
+  if (slot < VTPC_INDEX_GROUP) {
+    index->ctrl[index->mask + 1 + slot] = ctrl;
+  }
+}
+
+/* index_max_growth — сколько ячеек может быть занято ключами и надгробиями. */
+static size_t index_max_growth(const struct vtpc_index* index) {
+  size_t slots = index->mask + 1;
+  return slots - slots / 8;
+}
+
+/* index_probe — ячейка ключа или SIZE_MAX. Группы перебираются с растущим
+ * шагом, что при степени двойки обходит всю таблицу. Ключ обычно лежит в
+ * первых ячейках своей группы, поэтому их строка запрашивается сразу, не
+ * дожидаясь сравнения метаданных: иначе попадание ждёт два промаха подряд. */
+static size_t index_probe(
+    const struct vtpc_index* index, const void* file, off_t page
+) {
+  uint64_t hash = index_hash(file, page);
+  uint8_t h2 = (uint8_t)(hash & VTPC_INDEX_H2_MASK);
+  size_t pos = (size_t)(hash >> VTPC_INDEX_H2_BITS) & index->mask;
+  __builtin_prefetch(&index->entries[pos]);
+  for (size_t step = VTPC_INDEX_GROUP;; step += VTPC_INDEX_GROUP) {
+    const uint8_t* group = index->ctrl + pos;
+    for (uint32_t match = group_match(group, h2); match; match &= match - 1) {
+      size_t slot = (pos + (size_t)__builtin_ctz(match)) & index->mask;
+      const struct vtpc_index_entry* entry = &index->entries[slot];
+      if (entry->file == file && entry->index == page) {
+        return slot;
+      }
+    }
+    if (group_match(group, VTPC_INDEX_EMPTY)) {
+      return SIZE_MAX;
+    }
+    pos = (pos + step) & index->mask;
+  }
+}
+
+/* index_find_free — первая пустая или удалённая ячейка на пути ключа. */
+static size_t index_find_free(const struct vtpc_index* index, uint64_t hash) {
+  size_t pos = (size_t)(hash >> VTPC_INDEX_H2_BITS) & index->mask;
+  for (size_t step = VTPC_INDEX_GROUP;; step += VTPC_INDEX_GROUP) {
+    uint32_t free = group_free(index->ctrl + pos);
+    if (free) {
+      return (pos + (size_t)__builtin_ctz(free)) & index->mask;
+    }
+    pos = (pos + step) & index->mask;
+  }
+}
+
+static void index_put(
+    struct vtpc_index* index,
+    size_t slot,
+    uint64_t hash,
+    const void* file,
+    off_t page,
+    void* value
+) {
+  if (index->ctrl[slot] == VTPC_INDEX_EMPTY) {
+    --index->growth_left;
+  }
+  index_set_ctrl(index, slot, (uint8_t)(hash & VTPC_INDEX_H2_MASK));
+  index->entries[slot] = (struct vtpc_index_entry){
+      .file = file,
+      .index = page,
+      .value = value,
+  };
+  ++index->size;
+}
+
+/* index_rebuild — избавляется от надгробий, заново раскладывая ключи по
+ * таблице того же размера. */
+static void index_rebuild(struct vtpc_index* index) {
+  size_t count = 0;
+  for (size_t slot = 0; slot <= index->mask; ++slot) {
+    if (!(index->ctrl[slot] & VTPC_INDEX_EMPTY)) {
+      index->scratch[count++] = index->entries[slot];
+    }
+  }
+
+  memset(index->ctrl, VTPC_INDEX_EMPTY, index->mask + 1 + VTPC_INDEX_GROUP);
+  index->size = 0;
+  index->growth_left = index_max_growth(index);
+  for (size_t i = 0; i < count; ++i) {
+    const struct vtpc_index_entry* entry = &index->scratch[i];
+    uint64_t hash = index_hash(entry->file, entry->index);
+    size_t slot = index_find_free(index, hash);
+    index_put(index, slot, hash, entry->file, entry->index, entry->value);
+  }
+}
+
+int vtpc_index_init(struct vtpc_index* index, size_t capacity) {
+  memset(index, 0, sizeof(*index));
+
+  size_t slots = VTPC_INDEX_GROUP;
+  while (slots < capacity * 2) {
+    slots <<= 1U;
+  }
+  index->ctrl = malloc(slots + VTPC_INDEX_GROUP);
+  index->entries = calloc(slots, sizeof(*index->entries));
+  index->scratch = calloc(capacity ? capacity : 1, sizeof(*index->scratch));
+  if (!index->ctrl || !index->entries || !index->scratch) {
+    vtpc_index_destroy(index);
+    errno = ENOMEM;
+    return -1;
+  }
+
+  memset(index->ctrl, VTPC_INDEX_EMPTY, slots + VTPC_INDEX_GROUP);
+  index->mask = slots - 1;
+  index->capacity = capacity;
+  index->growth_left = index_max_growth(index);
+  return 0;
+}
+
+void vtpc_index_destroy(struct vtpc_index* index) {
+  free(index->ctrl);
+  free(index->entries);
+  free(index->scratch);
+  memset(index, 0, sizeof(*index));
+}
+
+void* vtpc_index_find(
+    const struct vtpc_index* index, const void* file, off_t page
+) {
+  size_t slot = index_probe(index, file, page);
+  return slot == SIZE_MAX ? NULL : index->entries[slot].value;
+}
+
+void vtpc_index_insert(
+    struct vtpc_index* index, const void* file, off_t page, void* value
+) {
+  uint64_t hash = index_hash(file, page);
+  size_t slot = index_find_free(index, hash);
+  if (index->growth_left == 0 && index->ctrl[slot] == VTPC_INDEX_EMPTY) {
+    index_rebuild(index);
+    slot = index_find_free(index, hash);
+  }
+  index_put(index, slot, hash, file, page, value);
+}
+
+void vtpc_index_remove(struct vtpc_index* index, const void* file, off_t page) {
+  size_t slot = index_probe(index, file, page);
+  if (slot != SIZE_MAX) {
+    index_set_ctrl(index, slot, VTPC_INDEX_DELETED);
+    --index->size;
+  }
+}
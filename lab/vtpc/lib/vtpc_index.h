@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/* vtpc_index_entry — ключ (файл, номер страницы) и связанное с ним значение. */
+struct vtpc_index_entry {
+  const void* file;
+  off_t index;
+  void* value;
+};
+
+/*
+ * vtpc_index — индекс страниц с открытой адресацией в духе SwissTable. На
+ * каждую ячейку приходится байт метаданных: старший бит отмечает пустую или
+ * удалённую ячейку, остальные семь хранят младшие биты хэша ключа. Поиск
+ * сравнивает метаданные группами по VTPC_INDEX_GROUP ячеек и читает ключ
+ * только при совпадении. Таблица выделяется один раз под заданную ёмкость.
+ */
+struct vtpc_index {
+  uint8_t* ctrl;                    /* метаданные и копия первой группы */
+  struct vtpc_index_entry* entries; /* ячейки */
+  struct vtpc_index_entry* scratch; /* буфер для перестройки */
+  size_t mask;                      /* число ячеек минус один */
+  size_t capacity;                  /* наибольшее число ключей */
+  size_t size;                      /* число ключей */
+  size_t growth_left;               /* пустые ячейки до перестройки */
+};
+
+#define VTPC_INDEX_GROUP 16
+
+/* vtpc_index_init(index, capacity) — выделяет таблицу на capacity ключей. */
+int vtpc_index_init(struct vtpc_index* index, size_t capacity);
+
+void vtpc_index_destroy(struct vtpc_index* index);
+
+/* vtpc_index_find — значение ключа или NULL. */
+void* vtpc_index_find(
+    const struct vtpc_index* index, const void* file, off_t page
+);
+
+/* vtpc_index_insert — добавляет ключ, которого в таблице нет. */
+void vtpc_index_insert(
+    struct vtpc_index* index, const void* file, off_t page, void* value
+);
+
+/* vtpc_index_remove — удаляет ключ, оставляя на его месте надгробие. */
+void vtpc_index_remove(struct vtpc_index* index, const void* file, off_t page);
@@ -0,0 +1,191 @@
+#define _GNU_SOURCE
+#include "vtpc_l2.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vtpc_dev.h"
+
+#define VTPC_L2_MODE 0600
+
+/* l2_key — ключ индекса для номера файла. */
+static const void* l2_key(uint64_t file) {
+  return (const void*)(uintptr_t)file;
+}
+
+static void l2_slot_release(struct vtpc_l2* l2, size_t slot) {
+  struct vtpc_l2_slot* entry = &l2->slots[slot];
+  if (entry->used) {
+    vtpc_index_remove(&l2->index, l2_key(entry->file), entry->page);
+    entry->used = 0;
+    --l2->used_pages;
+  }
+}
+
+int vtpc_l2_open(struct vtpc_l2* l2, const char* path, size_t pages) {
+  memset(l2, 0, sizeof(*l2));
+  l2->fd = -1;
+  if (pages == 0) {
+    return 0;
+  }
+  if (!path || pages > (size_t)INT64_MAX / VTPC_PAGE_SIZE) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  void* data = NULL;
+  l2->slots = calloc(pages, sizeof(*l2->slots));
+  if (posix_memalign(
+          &data, VTPC_PAGE_SIZE, (size_t)VTPC_L2_STAGING * VTPC_PAGE_SIZE
+      ) != 0) {
+    data = NULL;
+  }
+  l2->staging_data = data;
+  if (!l2->slots || !l2->staging_data ||
+      vtpc_index_init(&l2->index, pages) != 0) {
+    vtpc_l2_close(l2);
+    errno = ENOMEM;
+    return -1;
+  }
+  for (size_t i = 0; i < VTPC_L2_STAGING; ++i) {
+    l2->staged[i].data = l2->staging_data + i * VTPC_PAGE_SIZE;
+  }
+
+  int fd = vtpc_dev_posix.open(path, O_RDWR | O_CREAT | O_TRUNC, VTPC_L2_MODE);
+  if (fd < 0) {
+    int saved = errno;
+    vtpc_l2_close(l2);
+    errno = saved;
+    return -1;
+  }
+  int error = posix_fallocate(fd, 0, (off_t)(pages * VTPC_PAGE_SIZE));
+  if (error != 0) {
+    vtpc_dev_posix.close(fd);
+    vtpc_l2_close(l2);
+    errno = error;
+    return -1;
+  }
+  l2->fd = fd;
+  l2->pages = pages;
+  return 0;
+}
+
+void vtpc_l2_close(struct vtpc_l2* l2) {
+  if (l2->fd >= 0) {
+    vtpc_dev_posix.close(l2->fd);
+  }
+  vtpc_index_destroy(&l2->index);
+  free(l2->slots);
+  free(l2->staging_data);
+  memset(l2, 0, sizeof(*l2));
+  l2->fd = -1;
+}
+
+ssize_t vtpc_l2_lookup(struct vtpc_l2* l2, uint64_t file, off_t page) {
+  if (l2->fd < 0) {
+    return -1;
+  }
+  void* value = vtpc_index_find(&l2->index, l2_key(file), page);
+  if (!value) {
+    ++l2->misses;
+    return -1;
+  }
+  ++l2->hits;
+  return (ssize_t)((uintptr_t)value - 1);
+}
+
+int vtpc_l2_read_slot(const struct vtpc_l2* l2, size_t slot, char* data) {
+  off_t offset = (off_t)(slot * VTPC_PAGE_SIZE);
+  ssize_t got = vtpc_dev_posix.pread(l2->fd, data, VTPC_PAGE_SIZE, offset);
+  if (got != VTPC_PAGE_SIZE) {
+    if (got >= 0) {
+      errno = EIO;
+    }
+    return -1;
+  }
+  return 0;
+}
+
+void vtpc_l2_invalidate(struct vtpc_l2* l2, uint64_t file, off_t page) {
+  if (l2->fd < 0) {
+    return;
+  }
+  void* value = vtpc_index_find(&l2->index, l2_key(file), page);
+  if (value) {
+    l2_slot_release(l2, (size_t)((uintptr_t)value - 1));
+  }
+  for (size_t i = 0; i < l2->staged_count; ++i) {
+    struct vtpc_l2_staged* staged =
+        &l2->staged[(l2->staged_head + i) % VTPC_L2_STAGING];
+    if (staged->file == file && staged->page == page) {
+      staged->canceled = 1;
+    }
+  }
+}
+
+void vtpc_l2_stage(
+    struct vtpc_l2* l2, uint64_t file, off_t page, const char* data
+) {
+  if (l2->fd < 0 || l2->staged_count == VTPC_L2_STAGING ||
+      vtpc_index_find(&l2->index, l2_key(file), page)) {
+    return;
+  }
+  struct vtpc_l2_staged* staged =
+      &l2->staged[(l2->staged_head + l2->staged_count) % VTPC_L2_STAGING];
+  staged->file = file;
+  staged->page = page;
+  staged->canceled = 0;
+  memcpy(staged->data, data, VTPC_PAGE_SIZE);
+  ++l2->staged_count;
+}
+
+int vtpc_l2_store_begin(struct vtpc_l2* l2, struct vtpc_l2_store* store) {
+  if (l2->staged_count == 0 || l2->writing) {
+    return 0;
+  }
+  store->staged = &l2->staged[l2->staged_head];
+  store->slot = l2->hand;
+  l2->hand = (l2->hand + 1) % l2->pages;
+  l2_slot_release(l2, store->slot);
+  l2->writing = store->staged;
+  return 1;
+}
+
+int vtpc_l2_store_write(const struct vtpc_l2* l2, struct vtpc_l2_store* store) {
+  off_t offset = (off_t)(store->slot * VTPC_PAGE_SIZE);
+  ssize_t written = vtpc_dev_posix.pwrite(
+      l2->fd, store->staged->data, VTPC_PAGE_SIZE, offset
+  );
+  if (written != VTPC_PAGE_SIZE) {
+    if (written >= 0) {
+      errno = EIO;
+    }
+    return -1;
+  }
+  return 0;
+}
+
+void vtpc_l2_store_end(
+    struct vtpc_l2* l2, struct vtpc_l2_store* store, int result
+) {
+  struct vtpc_l2_staged* staged = store->staged;
+  const void* key = l2_key(staged->file);
+  if (result == 0 && !staged->canceled &&
+      !vtpc_index_find(&l2->index, key, staged->page)) {
+    struct vtpc_l2_slot* slot = &l2->slots[store->slot];
+    slot->file = staged->file;
+    slot->page = staged->page;
+    slot->used = 1;
+    vtpc_index_insert(
+        &l2->index, key, staged->page, (void*)(uintptr_t)(store->slot + 1)
+    );
+    ++l2->used_pages;
+    ++l2->writes;
+  }
+
+  l2->writing = NULL;
+  l2->staged_head = (l2->staged_head + 1) % VTPC_L2_STAGING;
+  --l2->staged_count;
+}
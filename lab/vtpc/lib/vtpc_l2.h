@@ -0,0 +1,90 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "vtpc_index.h"
+
+/* Сколько вытесненных страниц может ждать записи во второй уровень. */
+#define VTPC_L2_STAGING 32
+
+/* vtpc_l2_slot — страница файла (file, page), лежащая в ячейке файла L2. */
+struct vtpc_l2_slot {
+  uint64_t file;
+  off_t page;
+  int used;
+};
+
+/* vtpc_l2_staged — копия вытесненной страницы, ожидающая записи. */
+struct vtpc_l2_staged {
+  uint64_t file;
+  off_t page;
+  int canceled; /* страница изменилась, копия устарела */
+  char* data;
+};
+
+/*
+ * vtpc_l2 — второй уровень кэша в заранее выделенном файле на быстром
+ * локальном диске. Чистые страницы, вытесненные из памяти, копируются в
+ * очередь и записываются фоновым потоком; при промахе в памяти страница
+ * сначала ищется здесь. Файлы различаются номерами, которые не повторяются,
+ * поэтому страницы закрытого файла просто вытесняются со временем. Все
+ * функции, кроме vtpc_l2_store_write и vtpc_l2_read_slot, вызываются под
+ * блокировкой кэша.
+ */
+struct vtpc_l2 {
+  int fd; /* -1, если второй уровень выключен */
+  size_t pages;
+  struct vtpc_index index; /* (файл, страница) -> номер ячейки + 1 */
+  struct vtpc_l2_slot* slots;
+  size_t hand; /* следующая ячейка для записи, по кругу */
+  char* staging_data;
+  struct vtpc_l2_staged staged[VTPC_L2_STAGING];
+  size_t staged_head;
+  size_t staged_count;
+  struct vtpc_l2_staged* writing; /* копия, которую сейчас пишет поток */
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t writes;
+  size_t used_pages;
+};
+
+/* vtpc_l2_store — запись одной копии, выполняемая без блокировки кэша. */
+struct vtpc_l2_store {
+  struct vtpc_l2_staged* staged;
+  size_t slot;
+};
+
+/* vtpc_l2_open(l2, path, pages) — создаёт файл второго уровня на pages
+ * страниц; при pages == 0 уровень выключен. */
+int vtpc_l2_open(struct vtpc_l2* l2, const char* path, size_t pages);
+
+void vtpc_l2_close(struct vtpc_l2* l2);
+
+/* vtpc_l2_lookup — ячейка страницы или -1; считает попадание или промах. */
+ssize_t vtpc_l2_lookup(struct vtpc_l2* l2, uint64_t file, off_t page);
+
+/* vtpc_l2_read_slot — читает страницу из ячейки slot в data. */
+int vtpc_l2_read_slot(const struct vtpc_l2* l2, size_t slot, char* data);
+
+/* vtpc_l2_invalidate — забывает копию страницы, которая изменилась в памяти. */
+void vtpc_l2_invalidate(struct vtpc_l2* l2, uint64_t file, off_t page);
+
+/* vtpc_l2_stage — ставит копию вытесненной страницы в очередь на запись;
+ * при переполненной очереди копия отбрасывается. */
+void vtpc_l2_stage(
+    struct vtpc_l2* l2, uint64_t file, off_t page, const char* data
+);
+
+/* vtpc_l2_store_begin — снимает копию с очереди и выбирает для неё ячейку;
+ * возвращает 0, если очередь пуста. */
+int vtpc_l2_store_begin(struct vtpc_l2* l2, struct vtpc_l2_store* store);
+
+int vtpc_l2_store_write(const struct vtpc_l2* l2, struct vtpc_l2_store* store);
+
+/* vtpc_l2_store_end — вносит записанную копию в индекс, если за время записи
+ * она не устарела. */
+void vtpc_l2_store_end(
+    struct vtpc_l2* l2, struct vtpc_l2_store* store, int result
+);
@@ -0,0 +1,100 @@
+#define _GNU_SOURCE
+#include "vtpc_monitor.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define VTPC_MONITOR_MAGIC 0x7674706331ULL /* "vtpc1" */
+#define VTPC_MONITOR_MODE 0444
+#define VTPC_MONITOR_NAME_MAX 32
+#define VTPC_MONITOR_RETRIES 1000
+
+static char monitor_name[VTPC_MONITOR_NAME_MAX];
+
+static void monitor_format_name(char* name, pid_t pid) {
+  snprintf(name, VTPC_MONITOR_NAME_MAX, "/vtpc.%ld", (long)pid);
+}
+
+static void monitor_unlink(void) {
+  shm_unlink(monitor_name);
+}
+
+struct vtpc_monitor_page* vtpc_monitor_open(void) {
+  monitor_format_name(monitor_name, getpid());
+  shm_unlink(monitor_name);
+  int fd = shm_open(monitor_name, O_RDWR | O_CREAT | O_EXCL, VTPC_MONITOR_MODE);
+  if (fd < 0) {
+    return NULL;
+  }
+
+  size_t size = sizeof(struct vtpc_monitor_page);
+  void* map = MAP_FAILED;
+  if (ftruncate(fd, (off_t)size) == 0) {
+    map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  int saved = errno;
+  close(fd);
+  if (map == MAP_FAILED) {
+    shm_unlink(monitor_name);
+    errno = saved;
+    return NULL;
+  }
+
+  struct vtpc_monitor_page* page = map;
+  atexit(monitor_unlink);
+  __atomic_store_n(&page->magic, VTPC_MONITOR_MAGIC, __ATOMIC_RELEASE);
+  return page;
+}
+
+void vtpc_monitor_publish(
+    struct vtpc_monitor_page* page, const struct vtpc_monitor* data
+) {
+  uint64_t seq = __atomic_load_n(&page->seq, __ATOMIC_RELAXED);
+  __atomic_store_n(&page->seq, seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  memcpy(&page->data, data, sizeof(*data));
+  __atomic_store_n(&page->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+int vtpc_monitor_read(pid_t pid, struct vtpc_monitor* monitor) {
+  char name[VTPC_MONITOR_NAME_MAX];
+  monitor_format_name(name, pid);
+  int fd = shm_open(name, O_RDONLY, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  size_t size = sizeof(struct vtpc_monitor_page);
+  void* map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    return -1;
+  }
+
+  const struct vtpc_monitor_page* page = map;
+  int result = -1;
+  errno = ENOENT;
+  if (__atomic_load_n(&page->magic, __ATOMIC_ACQUIRE) == VTPC_MONITOR_MAGIC) {
+    errno = EAGAIN;
+    for (size_t i = 0; i < VTPC_MONITOR_RETRIES; ++i) {
+      uint64_t before = __atomic_load_n(&page->seq, __ATOMIC_ACQUIRE);
+      if (before == 0 || before % 2 != 0) {
+        sched_yield();
+        continue;
+      }
+      memcpy(monitor, &page->data, sizeof(*monitor));
+      __atomic_thread_fence(__ATOMIC_ACQUIRE);
+      if (__atomic_load_n(&page->seq, __ATOMIC_RELAXED) == before) {
+        result = 0;
+        break;
+      }
+    }
+  }
+  munmap(map, size);
+  return result;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "vtpc.h"
+
+/* vtpc_monitor_page — содержимое разделяемой памяти /vtpc.<pid>. */
+struct vtpc_monitor_page {
+  uint64_t magic;
+  uint64_t seq; /* нечётное значение — снимок сейчас переписывается */
+  struct vtpc_monitor data;
+};
+
+/* vtpc_monitor_open — создаёт страницу /vtpc.<pid> и удаляет её при выходе из
+ * процесса; возвращает NULL с errno при ошибке. */
+struct vtpc_monitor_page* vtpc_monitor_open(void);
+
+/* vtpc_monitor_publish — переписывает снимок без блокировок: читатели
+ * повторяют чтение, если seq изменился. Писатель всегда один. */
+void vtpc_monitor_publish(
+    struct vtpc_monitor_page* page, const struct vtpc_monitor* data
+);
@@ -0,0 +1,549 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "vtpc_dev.h"
+
+#define SIM_NSEC_PER_SEC 1000000000ULL
+#define SIM_DEV_ID 0x5654 /* st_dev всех файлов симулятора */
+#define SIM_TABLE_INITIAL 16
+#define SIM_FILE_MODE 0644
+
+/* sim_file — файл на симулируемом устройстве; живёт до конца процесса. */
+struct sim_file {
+  char* path;
+  char* data;
+  size_t size;
+  size_t capacity;
+  ino_t ino;
+};
+
+struct sim {
+  pthread_mutex_t lock;
+  int started;
+  struct vtpc_sim_config config;
+  struct sim_file** files;
+  size_t file_count;
+  size_t file_capacity;
+  struct sim_file** fds;
+  size_t fd_count;
+  uint64_t* channels; /* момент освобождения каждого слота очереди */
+  uint64_t start_ns;
+  uint64_t virtual_ns; /* виртуальные часы подачи запросов */
+  uint64_t last_end;   /* самое позднее завершение запроса */
+  const struct sim_file* head_file;
+  uint64_t head_pos;
+  struct vtpc_sim_stats stats;
+};
+
+static struct sim sim = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+/* Завершение последнего запроса потока: синхронный вызывающий не подаст
+ * следующий запрос раньше, чем дождётся предыдущего. */
+static __thread uint64_t sim_thread_end;
+
+/* ------------------------------ Время ------------------------------ */
+
+static uint64_t monotonic_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * SIM_NSEC_PER_SEC + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t sim_now(void) {
+  if (sim.config.clock == VTPC_SIM_CLOCK_VIRTUAL) {
+    return sim.virtual_ns;
+  }
+  return monotonic_ns() - sim.start_ns;
+}
+
+static uint64_t sim_service_ns(
+    const struct sim_file* file, off_t offset, size_t count
+) {
+  const struct vtpc_sim_config* cfg = &sim.config;
+  uint64_t ns = cfg->latency_ns;
+
+  uint64_t pos = (uint64_t)offset;
+  if (file != sim.head_file || pos != sim.head_pos) {
+    double ratio = 1.0;
+    if (file == sim.head_file && cfg->seek_span > 0) {
+      uint64_t distance =
+          pos > sim.head_pos ? pos - sim.head_pos : sim.head_pos - pos;
+      if (distance < cfg->seek_span) {
+        ratio = (double)distance / (double)cfg->seek_span;
+      }
+    }
+    uint64_t range = 0;
+    if (cfg->seek_max_ns > cfg->seek_min_ns) {
+      range = cfg->seek_max_ns - cfg->seek_min_ns;
+    }
+    ns += cfg->seek_min_ns + (uint64_t)((double)range * ratio);
+  }
+
+  if (cfg->bandwidth > 0) {
+    ns += (uint64_t)(
+        (double)count * (double)SIM_NSEC_PER_SEC / (double)cfg->bandwidth
+    );
+  }
+  return ns;
+}
+
+/*
+ * sim_submit(file, offset, count) — ставит запрос в очередь устройства и
+ * возвращает момент его завершения. Запрос занимает слот очереди, который
+ * освободится раньше остальных, и начинается не раньше момента подачи.
+ * Виртуальные часы подачи отделены от моментов завершения и доходят лишь до
+ * начала обслуживания, а сам поток подаёт запрос не раньше завершения своего
+ * предыдущего. Поэтому запросы разных потоков обслуживаются параллельно, пока в
+ * очереди есть свободные слоты, а без них ждут, и ожидание входит в задержку.
+ * Вызывается под sim.lock.
+ */
+static uint64_t sim_submit(
+    const struct sim_file* file, off_t offset, size_t count
+) {
+  uint64_t submit = sim_now();
+  if (sim.config.clock == VTPC_SIM_CLOCK_VIRTUAL && sim_thread_end > submit) {
+    submit = sim_thread_end;
+  }
+
+  size_t slot = 0;
+  for (size_t i = 1; i < sim.config.queue_depth; ++i) {
+    if (sim.channels[i] < sim.channels[slot]) {
+      slot = i;
+    }
+  }
+
+  uint64_t start = submit > sim.channels[slot] ? submit : sim.channels[slot];
+  uint64_t service = sim_service_ns(file, offset, count);
+  uint64_t end = start + service;
+  sim.channels[slot] = end;
+  sim.head_file = file;
+  sim.head_pos = (uint64_t)offset + count;
+
+  uint64_t latency = end - submit;
+  sim.stats.busy_ns += service;
+  sim.stats.latency_ns += latency;
+  if (latency > sim.stats.max_latency_ns) {
+    sim.stats.max_latency_ns = latency;
+  }
+  if (end > sim.last_end) {
+    sim.last_end = end;
+  }
+  if (sim.config.clock == VTPC_SIM_CLOCK_VIRTUAL && start > sim.virtual_ns) {
+    sim.virtual_ns = start;
+  }
+  sim_thread_end = end;
+  return end;
+}
+
+/* sim_wait(end) — в режиме реального времени дожидается завершения запроса.
+ * Вызывается без sim.lock, чтобы другие запросы могли встать в очередь. */
+static void sim_wait(uint64_t end) {
+  if (sim.config.clock != VTPC_SIM_CLOCK_WALL) {
+    return;
+  }
+
+  uint64_t deadline = sim.start_ns + end;
+  struct timespec ts = {
+      .tv_sec = (time_t)(deadline / SIM_NSEC_PER_SEC),
+      .tv_nsec = (long)(deadline % SIM_NSEC_PER_SEC),
+  };
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+  }
+}
+
+/* ------------------------------ Файлы ------------------------------ */
+
+static int sim_reserve(struct sim_file* file, size_t size) {
+  if (size <= file->capacity) {
+    return 0;
+  }
+
+  size_t capacity = file->capacity ? file->capacity : VTPC_PAGE_SIZE;
+  while (capacity < size) {
+    capacity *= 2;
+  }
+  char* data = realloc(file->data, capacity);
+  if (!data) {
+    errno = ENOMEM;
+    return -1;
+  }
+  file->data = data;
+  file->capacity = capacity;
+  return 0;
+}
+
+static int sim_resize(struct sim_file* file, size_t size) {
+  if (sim_reserve(file, size) != 0) {
+    return -1;
+  }
+  if (size > file->size) {
+    memset(file->data + file->size, 0, size - file->size);
+  }
+  file->size = size;
+  return 0;
+}
+
+/*
+ * sim_path — абсолютный путь без «.», «..» и повторных «/». Кэш открывает файл
+ * заново по абсолютному пути, а пользователь мог передать относительный, так
+ * что сравниваются только нормализованные пути. Возвращает NULL с errno.
+ */
+static char* sim_path(const char* path) {
+  char* cwd = path[0] == '/' ? strdup("") : getcwd(NULL, 0);
+  if (!cwd) {
+    errno = ENOMEM;
+    return NULL;
+  }
+  size_t cwd_len = strlen(cwd);
+  size_t path_len = strlen(path);
+  char* joined = malloc(cwd_len + path_len + 2);
+  char* result = malloc(cwd_len + path_len + 2);
+  if (!joined || !result) {
+    free(cwd);
+    free(joined);
+    free(result);
+    errno = ENOMEM;
+    return NULL;
+  }
+  memcpy(joined, cwd, cwd_len);
+  joined[cwd_len] = '/';
+  memcpy(joined + cwd_len + 1, path, path_len + 1);
+  free(cwd);
+
+  size_t len = 0;
+  const char* part = joined;
+  while (*part) {
+    while (*part == '/') {
+      ++part;
+    }
+    size_t part_len = strcspn(part, "/");
+    if (part_len == 0 || (part_len == 1 && part[0] == '.')) {
+      part += part_len;
+      continue;
+    }
+    if (part_len == 2 && part[0] == '.' && part[1] == '.') {
+      while (len > 0 && result[len - 1] != '/') {
+        --len;
+      }
+      if (len > 0) {
+        --len;
+      }
+    } else {
+      result[len++] = '/';
+      memcpy(result + len, part, part_len);
+      len += part_len;
+    }
+    part += part_len;
+  }
+  if (len == 0) {
+    result[len++] = '/';
+  }
+  result[len] = '\0';
+  free(joined);
+  return result;
+}
+
+/* sim_lookup — файл по нормализованному пути. */
+static struct sim_file* sim_lookup(const char* path) {
+  for (size_t i = 0; i < sim.file_count; ++i) {
+    if (strcmp(sim.files[i]->path, path) == 0) {
+      return sim.files[i];
+    }
+  }
+  return NULL;
+}
+
+static struct sim_file* sim_create(const char* path) {
+  if (sim.file_count == sim.file_capacity) {
+    size_t capacity =
+        sim.file_capacity ? sim.file_capacity * 2 : SIM_TABLE_INITIAL;
+    struct sim_file** files = realloc(sim.files, capacity * sizeof(*files));
+    if (!files) {
+      errno = ENOMEM;
+      return NULL;
+    }
+    sim.files = files;
+    sim.file_capacity = capacity;
+  }
+
+  struct sim_file* file = calloc(1, sizeof(*file));
+  if (!file) {
+    errno = ENOMEM;
+    return NULL;
+  }
+  file->path = strdup(path);
+  if (!file->path) {
+    free(file);
+    errno = ENOMEM;
+    return NULL;
+  }
+  file->ino = (ino_t)(sim.file_count + 1);
+  sim.files[sim.file_count++] = file;
+  return file;
+}
+
+static int sim_fd_install(struct sim_file* file) {
+  for (size_t i = 0; i < sim.fd_count; ++i) {
+    if (!sim.fds[i]) {
+      sim.fds[i] = file;
+      return (int)i;
+    }
+  }
+
+  size_t count = sim.fd_count ? sim.fd_count * 2 : SIM_TABLE_INITIAL;
+  struct sim_file** fds = realloc(sim.fds, count * sizeof(*fds));
+  if (!fds) {
+    errno = ENOMEM;
+    return -1;
+  }
+  memset(fds + sim.fd_count, 0, (count - sim.fd_count) * sizeof(*fds));
+
+  int fd = (int)sim.fd_count;
+  fds[fd] = file;
+  sim.fds = fds;
+  sim.fd_count = count;
+  return fd;
+}
+
+static struct sim_file* sim_fd_get(int fd) {
+  if (fd < 0 || (size_t)fd >= sim.fd_count || !sim.fds[fd]) {
+    errno = EBADF;
+    return NULL;
+  }
+  return sim.fds[fd];
+}
+
+/* ------------------------------ Операции ------------------------------ */
+
+static int sim_open(const char* user_path, int flags, int access) {
+  (void)access;
+
+  char* path = sim_path(user_path);
+  if (!path) {
+    return -1;
+  }
+  pthread_mutex_lock(&sim.lock);
+  int fd = -1;
+  struct sim_file* file = sim_lookup(path);
+  if (file && (flags & O_CREAT) && (flags & O_EXCL)) {
+    errno = EEXIST;
+  } else if (!file && !(flags & O_CREAT)) {
+    errno = ENOENT;
+  } else {
+    if (!file) {
+      file = sim_create(path);
+    }
+    if (file && (flags & O_TRUNC)) {
+      file->size = 0;
+    }
+    if (file) {
+      fd = sim_fd_install(file);
+    }
+  }
+  pthread_mutex_unlock(&sim.lock);
+  free(path);
+  return fd;
+}
+
+static int sim_close(int fd) {
+  pthread_mutex_lock(&sim.lock);
+  int result = -1;
+  if (sim_fd_get(fd)) {
+    sim.fds[fd] = NULL;
+    result = 0;
+  }
+  pthread_mutex_unlock(&sim.lock);
+  return result;
+}
+
+static void sim_fill_stat(const struct sim_file* file, struct stat* st) {
+  memset(st, 0, sizeof(*st));
+  st->st_dev = SIM_DEV_ID;
+  st->st_ino = file->ino;
+  st->st_mode = S_IFREG | SIM_FILE_MODE;
+  st->st_nlink = 1;
+  st->st_size = (off_t)file->size;
+  st->st_blksize = VTPC_PAGE_SIZE;
+}
+
+static int sim_fstat(int fd, struct stat* st) {
+  pthread_mutex_lock(&sim.lock);
+  int result = -1;
+  const struct sim_file* file = sim_fd_get(fd);
+  if (file) {
+    sim_fill_stat(file, st);
+    result = 0;
+  }
+  pthread_mutex_unlock(&sim.lock);
+  return result;
+}
+
+static int sim_stat(const char* user_path, struct stat* st) {
+  char* path = sim_path(user_path);
+  if (!path) {
+    return -1;
+  }
+  pthread_mutex_lock(&sim.lock);
+  int result = -1;
+  const struct sim_file* file = sim_lookup(path);
+  if (file) {
+    sim_fill_stat(file, st);
+    result = 0;
+  } else {
+    errno = ENOENT;
+  }
+  pthread_mutex_unlock(&sim.lock);
+  free(path);
+  return result;
+}
+
+static ssize_t sim_pread(int fd, void* buf, size_t count, off_t offset) {
+  pthread_mutex_lock(&sim.lock);
+  const struct sim_file* file = sim_fd_get(fd);
+  if (!file || offset < 0) {
+    if (file) {
+      errno = EINVAL;
+    }
+    pthread_mutex_unlock(&sim.lock);
+    return -1;
+  }
+
+  size_t got = 0;
+  if ((size_t)offset < file->size) {
+    got = file->size - (size_t)offset;
+    if (got > count) {
+      got = count;
+    }
+    memcpy(buf, file->data + offset, got);
+  }
+  uint64_t end = sim_submit(file, offset, got);
+  ++sim.stats.reads;
+  sim.stats.bytes_read += got;
+  pthread_mutex_unlock(&sim.lock);
+
+  sim_wait(end);
+  return (ssize_t)got;
+}
+
+static ssize_t sim_pwrite(int fd, const void* buf, size_t count, off_t offset) {
+  pthread_mutex_lock(&sim.lock);
+  struct sim_file* file = sim_fd_get(fd);
+  if (!file || offset < 0) {
+    if (file) {
+      errno = EINVAL;
+    }
+    pthread_mutex_unlock(&sim.lock);
+    return -1;
+  }
+
+  size_t end_pos = (size_t)offset + count;
+  if (end_pos > file->size && sim_resize(file, end_pos) != 0) {
+    pthread_mutex_unlock(&sim.lock);
+    return -1;
+  }
+  memcpy(file->data + offset, buf, count);
+  uint64_t end = sim_submit(file, offset, count);
+  ++sim.stats.writes;
+  sim.stats.bytes_written += count;
+  pthread_mutex_unlock(&sim.lock);
+
+  sim_wait(end);
+  return (ssize_t)count;
+}
+
+static int sim_ftruncate(int fd, off_t size) {
+  pthread_mutex_lock(&sim.lock);
+  int result = -1;
+  struct sim_file* file = sim_fd_get(fd);
+  if (file && size < 0) {
+    errno = EINVAL;
+  } else if (file) {
+    result = sim_resize(file, (size_t)size);
+  }
+  pthread_mutex_unlock(&sim.lock);
+  return result;
+}
+
+/* sim_fallocate — файлы симулятора живут в памяти, выделять на диске нечего. */
+static int sim_fallocate(int fd, int mode, off_t offset, off_t len) {
+  (void)mode;
+  (void)offset;
+  (void)len;
+  pthread_mutex_lock(&sim.lock);
+  const struct sim_file* file = sim_fd_get(fd);
+  pthread_mutex_unlock(&sim.lock);
+  if (file) {
+    errno = EOPNOTSUPP;
+  }
+  return -1;
+}
+
+static int sim_fsync(int fd) {
+  pthread_mutex_lock(&sim.lock);
+  const struct sim_file* file = sim_fd_get(fd);
+  if (!file) {
+    pthread_mutex_unlock(&sim.lock);
+    return -1;
+  }
+  uint64_t end = sim_submit(sim.head_file, (off_t)sim.head_pos, 0);
+  pthread_mutex_unlock(&sim.lock);
+
+  sim_wait(end);
+  return 0;
+}
+
+const struct vtpc_dev vtpc_dev_sim = {
+    .open = sim_open,
+    .close = sim_close,
+    .fstat = sim_fstat,
+    .stat = sim_stat,
+    .pread = sim_pread,
+    .pwrite = sim_pwrite,
+    .ftruncate = sim_ftruncate,
+    .fallocate = sim_fallocate,
+    .fsync = sim_fsync,
+};
+
+int vtpc_sim_setup(const struct vtpc_sim_config* config) {
+  pthread_mutex_lock(&sim.lock);
+  if (sim.started) {
+    pthread_mutex_unlock(&sim.lock);
+    errno = EBUSY;
+    return -1;
+  }
+
+  sim.config = *config;
+  if (sim.config.queue_depth == 0) {
+    sim.config.queue_depth = 1;
+  }
+  sim.channels = calloc(sim.config.queue_depth, sizeof(*sim.channels));
+  if (!sim.channels) {
+    pthread_mutex_unlock(&sim.lock);
+    errno = ENOMEM;
+    return -1;
+  }
+  sim.start_ns = monotonic_ns();
+  sim.started = 1;
+  pthread_mutex_unlock(&sim.lock);
+  return 0;
+}
+
+void vtpc_sim_read_stats(struct vtpc_sim_stats* stats) {
+  pthread_mutex_lock(&sim.lock);
+  *stats = sim.stats;
+  stats->clock_ns = sim.config.clock == VTPC_SIM_CLOCK_VIRTUAL ? sim.last_end
+                                                                : sim_now();
+  pthread_mutex_unlock(&sim.lock);
+}
@@ -0,0 +1,184 @@
+#include <sys/types.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "check.hpp"
+
+extern "C" {
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "vtpc.h"
+}
+
+namespace {
+
+using vt::check;
+using vt::expect;
+
+constexpr size_t files = 100000;
+constexpr size_t dirs = 256;
+constexpr size_t file_size = 256;
+constexpr size_t max_fds = 256;
+constexpr const char* root = "/tmp/vtpc_files";
+
+auto path_of(size_t i) -> std::string {
+  return std::string(root) + "/" + std::to_string(i % dirs) + "/" +
+         std::to_string(i);
+}
+
+auto fill_of(size_t i) -> char {
+  return static_cast<char>('a' + i % 26);  // NOLINT
+}
+
+auto report(
+    std::string_view name, std::chrono::steady_clock::time_point start
+) -> void {
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  const double seconds = std::chrono::duration<double>(elapsed).count();
+  std::cout << name << ": " << static_cast<double>(files) / seconds
+            << " files/s\n";
+}
+
+auto read_check(int fd, size_t i, ssize_t (*read_fn)(int, void*, size_t))
+    -> void {
+  char buf[file_size];
+  check(read_fn(fd, buf, sizeof(buf)) == file_size, "read");
+  expect(buf[0] == fill_of(i) && buf[file_size - 1] == fill_of(i), "bad data");
+}
+
+}  // namespace
+
+auto main() -> int try {
+  const struct vtpc_config config = {
+      .cache_pages = 1024,  // NOLINT
+      .readahead_pages = 0,
+      .max_fds = max_fds,
+  };
+  check(vtpc_configure(&config) == 0, "vtpc_configure");
+
+  std::filesystem::remove_all(root);
+  for (size_t i = 0; i < dirs; ++i) {
+    std::filesystem::create_directories(
+        std::string(root) + "/" + std::to_string(i)
+    );
+  }
+  for (size_t i = 0; i < files; ++i) {
+    std::ofstream(path_of(i)) << std::string(file_size, fill_of(i));
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < files; ++i) {
+    const int fd = open(path_of(i).c_str(), O_RDONLY);  // NOLINT
+    check(fd >= 0, "open");
+    read_check(fd, i, read);
+    close(fd);
+  }
+  report("libc open/read/close", start);
+
+  start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < files; ++i) {
+    const int fd = vtpc_open(path_of(i).c_str(), O_RDONLY, 0);
+    check(fd >= 0, "vtpc_open");
+    read_check(fd, i, vtpc_read);
+    check(vtpc_close(fd) == 0, "vtpc_close");
+  }
+  report("vtpc open/read/close", start);
+
+  // Все файлы открыты одновременно: хэндлов больше, чем дескрипторов ОС.
+  std::vector<int> fds(files);
+  start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < files; ++i) {
+    fds[i] = vtpc_open(path_of(i).c_str(), O_RDONLY, 0);
+    check(fds[i] >= 0, "vtpc_open");
+  }
+  for (size_t i = 0; i < files; ++i) {
+    read_check(fds[i], i, vtpc_read);
+  }
+  struct vtpc_stats stats{};
+  check(vtpc_stats(&stats) == 0, "vtpc_stats");
+  for (const int fd : fds) {
+    check(vtpc_close(fd) == 0, "vtpc_close");
+  }
+  report("vtpc open all/read/close all", start);
+
+  std::cout << "open fds: " << stats.open_fds
+            << ", reopens: " << stats.fd_reopens << '\n';
+  expect(stats.open_fds <= max_fds, "descriptor limit exceeded");
+  expect(stats.fd_reopens >= files - max_fds, "files were not reopened");
+
+  // Закрытый номер не должен попасть в хэндл, открытый в той же ячейке.
+  const int first = vtpc_open(path_of(0).c_str(), O_RDONLY, 0);
+  check(first >= 0 && vtpc_close(first) == 0, "vtpc_open");
+  const int second = vtpc_open(path_of(1).c_str(), O_RDONLY, 0);
+  check(second >= 0, "vtpc_open");
+  expect(first != second, "closed handle number was reused");
+  char byte = 0;
+  expect(vtpc_read(first, &byte, 1) < 0 && errno == EBADF, "stale handle");
+  check(vtpc_close(second) == 0, "vtpc_close");
+
+  // Файл с грязными страницами держит дескриптор, даже когда LRU вытесняет
+  // остальные, и переименование не мешает обратной записи.
+  const std::string moved = path_of(0) + ".moved";
+  const int dirty = vtpc_open(path_of(0).c_str(), O_RDWR, 0);
+  check(dirty >= 0, "vtpc_open");
+  const std::string data(file_size, 'Z');
+  check(vtpc_write(dirty, data.data(), data.size()) == file_size, "write");
+  std::filesystem::rename(path_of(0), moved);
+  std::vector<int> others(max_fds + 1);
+  for (size_t i = 0; i < others.size(); ++i) {
+    others[i] = vtpc_open(path_of(i + 1).c_str(), O_RDONLY, 0);
+    check(others[i] >= 0, "vtpc_open");
+    read_check(others[i], i + 1, vtpc_read);
+  }
+  check(vtpc_fsync(dirty) == 0, "vtpc_fsync after rename");
+  check(vtpc_close(dirty) == 0, "vtpc_close");
+  for (const int fd : others) {
+    check(vtpc_close(fd) == 0, "vtpc_close");
+  }
+  std::string on_disk;
+  std::ifstream(moved) >> on_disk;
+  expect(on_disk == data, "dirty pages lost after rename");
+
+  // Файл с закрытым по LRU дескриптором удаляют, а его inode достаётся новому
+  // файлу: новый не должен получить страницы старого.
+  const std::string reused = std::string(root) + "/reused";
+  std::ofstream(reused) << std::string(file_size, 'A');
+  const int old_fd = vtpc_open(reused.c_str(), O_RDONLY, 0);
+  check(old_fd >= 0, "vtpc_open");
+  char buf[file_size];
+  check(vtpc_read(old_fd, buf, sizeof(buf)) == file_size, "read");
+  for (size_t i = 0; i < others.size(); ++i) {
+    others[i] = vtpc_open(path_of(i + 1).c_str(), O_RDONLY, 0);
+    check(others[i] >= 0, "vtpc_open");
+    read_check(others[i], i + 1, vtpc_read);
+  }
+  std::filesystem::remove(reused);
+  std::ofstream(reused) << std::string(file_size, 'B');
+  const int new_fd = vtpc_open(reused.c_str(), O_RDONLY, 0);
+  check(new_fd >= 0, "vtpc_open");
+  check(vtpc_read(new_fd, buf, sizeof(buf)) == file_size, "read");
+  expect(
+      buf[0] == 'B' && buf[file_size - 1] == 'B',
+      "reused inode served stale pages"
+  );
+  check(vtpc_close(new_fd) == 0 && vtpc_close(old_fd) == 0, "vtpc_close");
+  for (const int fd : others) {
+    check(vtpc_close(fd) == 0, "vtpc_close");
+  }
+
+  std::filesystem::remove_all(root);
+  return 0;
+} catch (const std::exception& e) {
+  std::cerr << "exception: " << e.what() << '\n';
+  return 1;
+}
@@ -0,0 +1,245 @@
+#include <sys/types.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "cmp_file.hpp"
+#include "exception.hpp"
+#include "file.hpp"
+#include "io_file.hpp"
+
+extern "C" {
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "vtpc.h"
+}
+
+// bench_harness — накладные расходы тестовой обвязки на одну операцию.
+// Один и тот же цикл мелких чтений из закэшированного файла выполняется
+// прямыми вызовами vtpc_read, через io_file<vtpc_io> без виртуальных вызовов,
+// через vt::file, через диспетчеризацию std::function (как в прежнем io_file)
+// и через cmp_file поверх libc и vtpc. Колонка overhead_ns — разница с
+// прямыми вызовами того же бэкенда; для cmp_file это прямые чтения libc и
+// vtpc, выполняемые друг за другом в одном цикле (строка libc+vtpc raw):
+// сумма двух отдельных замеров не учитывает, что в общем цикле вызовы
+// вытесняют друг у друга кэши и предсказатель переходов. Разброс чтения
+// libc от прогона к прогону больше самой обвязки cmp_file, поэтому её замеры
+// чередуются с базой и берётся лучший из rounds.
+
+namespace {
+
+constexpr size_t file_pages = 16;
+constexpr int rounds = 5;
+constexpr double nano = 1e9;
+
+struct options {
+  size_t block = 64;       // NOLINT
+  size_t ops = 1U << 20U;  // NOLINT
+};
+
+// function_file — прежняя диспетчеризация через std::function, для сравнения.
+class function_file final : public vt::file {
+public:
+  using file::read;
+  using file::write;
+
+  explicit function_file(int fd) : fd_(fd) {
+  }
+
+  auto read(char* buffer, size_t count) -> void override {
+    vt::robust_do(read_, fd_, buffer, count);
+  }
+
+  auto write(const char* buffer, size_t count) -> void override {
+    vt::robust_do(write_, fd_, buffer, count);
+  }
+
+  auto seek(off_t offset) -> void override {
+    if (lseek_(fd_, offset, SEEK_SET) == -1) {
+      throw vt::file_exception(-1) << "seek failed";
+    }
+  }
+
+  auto sync() -> void override {
+    (void)fsync_(fd_);
+  }
+
+  auto tell() -> off_t override {
+    return lseek_(fd_, 0, SEEK_CUR);
+  }
+
+private:
+  int fd_;
+  std::function<ssize_t(int, void*, size_t)> read_ = ::vtpc_read;
+  std::function<ssize_t(int, const void*, size_t)> write_ = ::vtpc_write;
+  std::function<off_t(int, off_t, int)> lseek_ = ::vtpc_lseek;
+  std::function<int(int)> fsync_ = ::vtpc_fsync;
+};
+
+// measure — наносекунды на одно чтение блока; step читает блок по номеру.
+template <class F>
+auto measure(const options& opts, F step) -> double {
+  const size_t blocks = file_pages * VTPC_PAGE_SIZE / opts.block;
+  for (size_t i = 0; i < blocks; ++i) {
+    step(i);
+  }
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < opts.ops; ++i) {
+    step(i % blocks);
+  }
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count() * nano / static_cast<double>(opts.ops);
+}
+
+// file_step — чтение блока через vt::file; переход в начало при i == 0.
+template <class File>
+auto file_step(File& file, std::vector<char>& buffer) {
+  return [&file, &buffer](size_t i) {
+    if (i == 0) {
+      file.seek(0);
+    }
+    file.read(buffer.data(), buffer.size());
+  };
+}
+
+template <ssize_t (*Read)(int, void*, size_t), off_t (*Seek)(int, off_t, int)>
+auto raw_step(int fd, std::vector<char>& buffer) {
+  return [fd, &buffer](size_t i) {
+    if (i == 0) {
+      (void)Seek(fd, 0, SEEK_SET);
+    }
+    if (Read(fd, buffer.data(), buffer.size()) !=
+        static_cast<ssize_t>(buffer.size())) {
+      throw vt::exception() << "short read";
+    }
+  };
+}
+
+auto parse(int argc, char** argv) -> options {
+  options opts;
+  const std::vector<std::string_view> args(argv + 1, argv + argc);
+  for (size_t i = 0; i < args.size(); ++i) {
+    const std::string_view key = args[i];
+    if (i + 1 == args.size()) {
+      throw vt::exception() << "missing value for '" << key << "'";
+    }
+    const std::string value(args[++i]);
+    char* end = nullptr;
+    const size_t number = std::strtoull(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0') {
+      throw vt::exception() << "bad number '" << value << "'";
+    }
+    if (key == "--block") {
+      opts.block = number;
+    } else if (key == "--ops") {
+      opts.ops = number;
+    } else {
+      throw vt::exception() << "unknown option '" << key
+                            << "'; usage: bench_harness [--block N] [--ops N]";
+    }
+  }
+  if (opts.block == 0 || opts.block > file_pages * VTPC_PAGE_SIZE ||
+      opts.ops == 0) {
+    throw vt::exception() << "bad options";
+  }
+  return opts;
+}
+
+auto prepare(std::string_view path) -> void {
+  std::filesystem::remove(path);
+  vt::io_file<vt::libc_io> file(path);
+  file.write(std::string(file_pages * VTPC_PAGE_SIZE, 'x'));
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) -> int try {
+  const options opts = parse(argc, argv);
+  const std::string libc_path = "/tmp/bench_harness_a";
+  const std::string vtpc_path = "/tmp/bench_harness_b";
+  prepare(libc_path);
+  prepare(vtpc_path);
+  std::vector<char> buffer(opts.block);
+  std::vector<char> other(opts.block);
+
+  struct row {
+    std::string_view layer;
+    double ns;
+    double base;
+  };
+  std::vector<row> rows;
+
+  const int libc_fd = ::open(libc_path.c_str(), O_RDWR);
+  const int vtpc_fd = ::vtpc_open(vtpc_path.c_str(), O_RDWR, 0);
+  if (libc_fd < 0 || vtpc_fd < 0) {
+    throw vt::exception() << "open failed";
+  }
+  const auto libc_step = raw_step<::read, ::lseek>(libc_fd, buffer);
+  const auto vtpc_step = raw_step<::vtpc_read, ::vtpc_lseek>(vtpc_fd, buffer);
+  const auto other_step = raw_step<::vtpc_read, ::vtpc_lseek>(vtpc_fd, other);
+  const auto pair_step = [&](size_t i) {
+    libc_step(i);
+    other_step(i);
+  };
+  const double libc_raw = measure(opts, libc_step);
+  const double vtpc_raw = measure(opts, vtpc_step);
+  rows.push_back({"libc raw", libc_raw, libc_raw});
+  rows.push_back({"vtpc raw", vtpc_raw, vtpc_raw});
+  {
+    function_file file(vtpc_fd);
+    rows.push_back(
+        {"vtpc std::function", measure(opts, file_step(file, buffer)), vtpc_raw}
+    );
+  }
+
+  {
+    vt::io_file<vt::vtpc_io> file(vtpc_path);
+    rows.push_back(
+        {"vtpc io_file", measure(opts, file_step(file, buffer)), vtpc_raw}
+    );
+  }
+  {
+    const std::unique_ptr<vt::file> file = vt::file::open_vtpc(vtpc_path);
+    rows.push_back(
+        {"vtpc vt::file", measure(opts, file_step(*file, buffer)), vtpc_raw}
+    );
+  }
+  {
+    vt::cmp_file file(
+        vt::file::open_libc(libc_path), vt::file::open_vtpc(vtpc_path)
+    );
+    double pair_raw = std::numeric_limits<double>::infinity();
+    double ns = std::numeric_limits<double>::infinity();
+    for (int round = 0; round < rounds; ++round) {
+      pair_raw = std::min(pair_raw, measure(opts, pair_step));
+      ns = std::min(ns, measure(opts, file_step(file, buffer)));
+    }
+    rows.push_back({"libc+vtpc raw", pair_raw, pair_raw});
+    rows.push_back({"cmp_file", ns, pair_raw});
+  }
+  (void)::close(libc_fd);
+  (void)::vtpc_close(vtpc_fd);
+
+  std::cout << "layer,block,ns_per_op,overhead_ns\n";
+  for (const row& row : rows) {
+    std::cout << row.layer << ',' << opts.block << ',' << row.ns << ','
+              << row.ns - row.base << '\n';
+  }
+  return 0;
+} catch (const std::exception& e) {
+  std::cerr << "exception: " << e.what() << '\n';
+  return 1;
+}
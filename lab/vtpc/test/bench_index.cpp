@@ -0,0 +1,214 @@
+#include <sys/types.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string_view>
+#include <vector>
+
+#include "check.hpp"
+
+extern "C" {
+#include "vtpc_index.h"
+}
+
+namespace {
+
+using vt::expect;
+
+constexpr size_t pages = (1U << 20U);
+constexpr size_t files = 64;
+constexpr size_t lookups = (1U << 22U);
+constexpr size_t churn = pages;
+constexpr size_t seed = 1;
+constexpr int rounds = 7;
+constexpr uint64_t multiplier = 0x9E3779B97F4A7C15ULL;
+constexpr unsigned shift = 32;
+
+struct page_key {
+  const void* file;
+  off_t index;
+};
+
+// Узел цепочки лежит в отдельном дескрипторе, как vtpc_page до перехода
+// на открытую адресацию; хэш тот же, что у vtpc_index.
+struct node {
+  page_key key;
+  node* next;
+  char payload[64];  // NOLINT
+};
+
+class chained_index {
+public:
+  explicit chained_index(size_t capacity) {
+    size_t buckets = 1;
+    while (buckets < capacity * 2) {
+      buckets <<= 1U;
+    }
+    buckets_.resize(buckets);
+    mask_ = buckets - 1;
+  }
+
+  auto find(const void* file, off_t index) const -> node* {
+    node* entry = buckets_[hash(file, index)];
+    while (entry && (entry->key.file != file || entry->key.index != index)) {
+      entry = entry->next;
+    }
+    return entry;
+  }
+
+  auto insert(node* entry) -> void {
+    node*& head = buckets_[hash(entry->key.file, entry->key.index)];
+    entry->next = head;
+    head = entry;
+  }
+
+  auto remove(node* entry) -> void {
+    node** link = &buckets_[hash(entry->key.file, entry->key.index)];
+    while (*link != entry) {
+      link = &(*link)->next;
+    }
+    *link = entry->next;
+  }
+
+private:
+  [[nodiscard]] auto hash(const void* file, off_t index) const -> size_t {
+    uint64_t key = reinterpret_cast<uintptr_t>(file) * multiplier;
+    key = (key ^ static_cast<uint64_t>(index)) * multiplier;
+    return static_cast<size_t>(key ^ (key >> shift)) & mask_;
+  }
+
+  std::vector<node*> buckets_;
+  size_t mask_ = 0;
+};
+
+// measure — наносекунды на поиск; expected — сколько ключей должно найтись.
+template <typename Find>
+auto measure(const std::vector<page_key>& probes, size_t expected, Find find)
+    -> double {
+  size_t found = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (const page_key& probe : probes) {
+    found += find(probe) ? 1 : 0;
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  expect(found == expected, "lookup results differ from the keys");
+
+  const auto ns = std::chrono::duration<double, std::nano>(elapsed).count();
+  return ns / static_cast<double>(probes.size());
+}
+
+// compare — лучший из rounds чередующихся прогонов каждой таблицы, чтобы
+// порядок запуска и шум соседей по машине не решали исход сравнения.
+auto compare(
+    std::string_view name,
+    const std::vector<page_key>& probes,
+    size_t expected,
+    const chained_index& chained,
+    const struct vtpc_index& index
+) -> void {
+  double chained_ns = std::numeric_limits<double>::max();
+  double swiss_ns = std::numeric_limits<double>::max();
+  for (int round = 0; round < rounds; ++round) {
+    chained_ns = std::min(
+        chained_ns,
+        measure(
+            probes,
+            expected,
+            [&](const page_key& probe) {
+              return chained.find(probe.file, probe.index) != nullptr;
+            }
+        )
+    );
+    swiss_ns = std::min(
+        swiss_ns,
+        measure(
+            probes,
+            expected,
+            [&](const page_key& probe) {
+              return vtpc_index_find(&index, probe.file, probe.index) !=
+                     nullptr;
+            }
+        )
+    );
+  }
+  std::cout << name << ": chained " << chained_ns << " ns/lookup, swiss "
+            << swiss_ns << " ns/lookup\n";
+}
+
+}  // namespace
+
+auto main() -> int try {
+  std::vector<char> file_ids(files);
+  std::vector<std::unique_ptr<node>> nodes;
+  nodes.reserve(pages);
+  for (size_t i = 0; i < pages; ++i) {
+    nodes.push_back(std::make_unique<node>());
+    nodes.back()->key = {
+        .file = &file_ids[i % files],
+        .index = static_cast<off_t>(i / files),
+    };
+  }
+
+  std::default_random_engine random(seed);  // NOLINT
+  std::shuffle(nodes.begin(), nodes.end(), random);
+
+  chained_index chained(pages);
+  struct vtpc_index index{};
+  expect(vtpc_index_init(&index, pages) == 0, "vtpc_index_init");
+  for (const auto& entry : nodes) {
+    chained.insert(entry.get());
+    vtpc_index_insert(&index, entry->key.file, entry->key.index, entry.get());
+  }
+
+  // Перемешиваем удаления и вставки, чтобы в таблице появились надгробия.
+  for (size_t i = 0; i < churn; ++i) {
+    node* entry = nodes[i].get();
+    chained.remove(entry);
+    vtpc_index_remove(&index, entry->key.file, entry->key.index);
+    entry->key.index += static_cast<off_t>(pages);
+    chained.insert(entry);
+    vtpc_index_insert(&index, entry->key.file, entry->key.index, entry);
+  }
+  expect(index.size == pages, "vtpc_index lost keys");
+
+  std::vector<page_key> probes;
+  probes.reserve(lookups);
+  std::uniform_int_distribution<size_t> node_dist(0, pages - 1);
+  for (size_t i = 0; i < lookups / 2; ++i) {
+    const page_key present = nodes[node_dist(random)]->key;
+    probes.push_back(present);
+    const off_t absent = present.index + 2 * static_cast<off_t>(pages);
+    probes.push_back({present.file, absent});
+  }
+  std::shuffle(probes.begin(), probes.end(), random);
+
+  for (const page_key& probe : probes) {
+    expect(
+        chained.find(probe.file, probe.index) ==
+            vtpc_index_find(&index, probe.file, probe.index),
+        "vtpc_index disagrees with the chained index"
+    );
+  }
+
+  std::vector<page_key> hits;
+  std::vector<page_key> misses;
+  for (const page_key& probe : probes) {
+    (chained.find(probe.file, probe.index) ? hits : misses).push_back(probe);
+  }
+  compare("mixed", probes, hits.size(), chained, index);
+  compare("hits", hits, hits.size(), chained, index);
+  compare("misses", misses, 0, chained, index);
+
+  vtpc_index_destroy(&index);
+  return 0;
+} catch (const std::exception& e) {
+  std::cerr << "exception: " << e.what() << '\n';
+  return 1;
+}
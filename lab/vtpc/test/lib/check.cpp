@@ -0,0 +1,24 @@
+#include "check.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <string_view>
+
+#include "exception.hpp"
+
+namespace vt {
+
+auto check(bool ok, std::string_view what) -> void {
+  if (!ok) {
+    throw vt::exception() << what << ": "
+                          << strerror(errno);  // NOLINT(concurrency-mt-unsafe)
+  }
+}
+
+auto expect(bool ok, std::string_view what) -> void {
+  if (!ok) {
+    throw vt::exception() << what;
+  }
+}
+
+}  // namespace vt
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string_view>
+
+namespace vt {
+
+// check — бросает vt::exception с what и текстом errno, если !ok; для
+// вызовов, сообщающих об ошибке через errno.
+auto check(bool ok, std::string_view what) -> void;
+
+// expect — бросает vt::exception с what, если !ok; для проверок результата.
+auto expect(bool ok, std::string_view what) -> void;
+
+}  // namespace vt
@@ -2,11 +2,11 @@
 
 #include <sys/types.h>
 
+#include <algorithm>
 #include <cstddef>
 #include <cstring>
 #include <memory>
 #include <optional>
-#include <string>
 #include <utility>
 
 #include "exception.hpp"
@@ -53,16 +53,25 @@ cmp_file::cmp_file(std::unique_ptr<file> lhs, std::unique_ptr<file> rhs)
 }
 
 auto cmp_file::read(char* buffer, size_t count) -> void {
-  std::string lhs(count, ' ');
-  std::string rhs(count, ' ');
+  if (scratch_.size() < count) {
+    scratch_.resize(count);
+  }
+  char* rhs = scratch_.data();
   Compare(
-      [&] { lhs_->read(lhs.data(), count); },
-      [&] { file_->read(rhs.data(), count); }
+      [&] { lhs_->read(buffer, count); }, [&] { file_->read(rhs, count); }
   );
-  if (lhs != rhs) {
-    throw vt::cmp_file_exception() << "'" << lhs << "' != '" << rhs << "'";
+  if (std::memcmp(buffer, rhs, count) == 0) [[likely]] {
+    return;
   }
-  memcpy(buffer, lhs.data(), count);
+
+  const auto [lhs_end, rhs_end] = std::mismatch(buffer, buffer + count, rhs);
+  const auto at = lhs_end - buffer;
+  const auto byte = [](char c) {
+    return static_cast<unsigned>(static_cast<unsigned char>(c));
+  };
+  throw vt::cmp_file_exception()
+      << "read of " << count << " bytes differs at byte " << at << ": "
+      << byte(*lhs_end) << " != " << byte(*rhs_end);
 }
 
 auto cmp_file::write(const char* buffer, size_t count) -> void {
@@ -79,4 +88,15 @@ auto cmp_file::sync() -> void {
   Compare([&] { lhs_->sync(); }, [this] { file_->sync(); });
 }
 
+auto cmp_file::tell() -> off_t {
+  off_t lhs = 0;
+  off_t rhs = 0;
+  Compare([&] { lhs = lhs_->tell(); }, [&] { rhs = file_->tell(); });
+  if (lhs != rhs) {
+    throw vt::cmp_file_exception()
+        << "offsets differ: " << lhs << " != " << rhs;
+  }
+  return lhs;
+}
+
 }  // namespace vt
@@ -4,6 +4,7 @@
 
 #include <cstddef>
 #include <memory>
+#include <vector>
 
 #include "exception.hpp"
 #include "file.hpp"
@@ -24,10 +25,12 @@ public:
   auto write(const char* buffer, size_t count) -> void override;
   auto seek(off_t offset) -> void override;
   auto sync() -> void override;
+  auto tell() -> off_t override;
 
 private:
   std::unique_ptr<file> lhs_;
   std::unique_ptr<file> file_;
+  std::vector<char> scratch_;  // чтение из rhs, растёт и не освобождается
 };
 
 }  // namespace vt
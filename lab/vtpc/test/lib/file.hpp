@@ -28,6 +28,7 @@ public:
   virtual auto write(const char* buffer, size_t count) -> void = 0;
   virtual auto seek(off_t offset) -> void = 0;
   virtual auto sync() -> void = 0;
+  virtual auto tell() -> off_t = 0;
 
   auto write(std::string_view text) -> void {
     write(text.data(), text.size());
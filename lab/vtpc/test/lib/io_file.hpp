@@ -0,0 +1,171 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "exception.hpp"
+#include "file.hpp"
+
+extern "C" {
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "vtpc.h"
+}
+
+namespace vt {
+
+// Политики ввода-вывода для io_file: набор статических функций с сигнатурами
+// системных вызовов. Политика — параметр шаблона, поэтому вызовы
+// подставляются на месте, а не идут через указатели на функции.
+
+struct libc_io {
+  static auto open(const char* path, int mode, int access) -> int {
+    return ::open(path, mode, access);
+  }
+  static auto close(int fd) -> int {
+    return ::close(fd);
+  }
+  static auto read(int fd, void* buf, size_t count) -> ssize_t {
+    return ::read(fd, buf, count);
+  }
+  static auto write(int fd, const void* buf, size_t count) -> ssize_t {
+    return ::write(fd, buf, count);
+  }
+  static auto lseek(int fd, off_t offset, int whence) -> off_t {
+    return ::lseek(fd, offset, whence);
+  }
+  static auto fsync(int fd) -> int {
+    return ::fsync(fd);
+  }
+};
+
+struct vtpc_io {
+  static auto open(const char* path, int mode, int access) -> int {
+    return ::vtpc_open(path, mode, access);
+  }
+  static auto close(int fd) -> int {
+    return ::vtpc_close(fd);
+  }
+  static auto read(int fd, void* buf, size_t count) -> ssize_t {
+    return ::vtpc_read(fd, buf, count);
+  }
+  static auto write(int fd, const void* buf, size_t count) -> ssize_t {
+    return ::vtpc_write(fd, buf, count);
+  }
+  static auto lseek(int fd, off_t offset, int whence) -> off_t {
+    return ::vtpc_lseek(fd, offset, whence);
+  }
+  static auto fsync(int fd) -> int {
+    return ::vtpc_fsync(fd);
+  }
+};
+
+constexpr auto io_flags = O_RDWR | O_CREAT;
+constexpr auto io_access = 0777;
+
+template <class A, class T>
+void robust_do(A action, int fd, T* buf, size_t count) {
+  using B = std::conditional_t<
+      std::is_const_v<std::remove_pointer_t<T>>,
+      const char,
+      char>;
+
+  size_t total = 0;
+  while (total < count) {
+    const size_t tail_count = count - total;
+    B* tail_buf = reinterpret_cast<B*>(buf) + total;  // NOLINT
+    const ssize_t local = action(fd, tail_buf, tail_count);
+    if (local < 0) [[unlikely]] {
+      throw vt::file_exception(local)
+          << "failed to read/write " << count << " bytes from file with fd "
+          << fd << ": " << strerror(errno);  // NOLINT(concurrency-mt-unsafe);
+    }
+    if (local == 0) [[unlikely]] {
+      throw vt::file_exception(0)
+          << "failed to read/write " << count << " bytes from file with fd "
+          << fd << ": " << "EOF after reading " << total << " bytes";
+    }
+
+    total += local;
+  }
+}
+
+// io_file — файл поверх политики IO. Класс финальный: через ссылку на
+// io_file<IO> вызовы не виртуальные, что нужно для замеров накладных
+// расходов самой обвязки.
+template <class IO>
+class io_file final : public file {
+public:
+  using file::read;
+  using file::write;
+
+  explicit io_file(std::string_view path)
+      : fd_(IO::open(std::string(path).c_str(), io_flags, io_access)) {
+    if (fd_ < 0) {
+      throw vt::file_exception(fd_)
+          << "failed to open file '" << path << "'" << ": "
+          << strerror(errno);  // NOLINT(concurrency-mt-unsafe);
+    }
+  }
+
+  io_file(const io_file&) = delete;
+  auto operator=(const io_file&) -> io_file& = delete;
+  io_file(io_file&&) = delete;
+  auto operator=(io_file&&) -> io_file& = delete;
+
+  ~io_file() override {
+    (void)IO::close(fd_);
+  }
+
+  void read(char* buffer, size_t count) override {
+    const auto read = [](int fd, char* buf, size_t count) {
+      return IO::read(fd, buf, count);
+    };
+    robust_do(read, fd_, buffer, count);
+  }
+
+  void write(const char* buffer, size_t count) override {
+    const auto write = [](int fd, const char* buf, size_t count) {
+      return IO::write(fd, buf, count);
+    };
+    robust_do(write, fd_, buffer, count);
+  }
+
+  void seek(off_t offset) override {
+    if (IO::lseek(fd_, offset, SEEK_SET) == -1) [[unlikely]] {
+      throw vt::file_exception(-1)
+          << "failed to seek to offset " << offset << "file with fd " << fd_
+          << ": " << strerror(errno);  // NOLINT(concurrency-mt-unsafe)
+    }
+  }
+
+  void sync() override {
+    if (IO::fsync(fd_) == -1) [[unlikely]] {
+      throw vt::file_exception(-1)
+          << "failed to fsync file with fd " << fd_ << ": "
+          << strerror(errno);  // NOLINT(concurrency-mt-unsafe)
+    }
+  }
+
+  auto tell() -> off_t override {
+    const off_t offset = IO::lseek(fd_, 0, SEEK_CUR);
+    if (offset == -1) [[unlikely]] {
+      throw vt::file_exception(-1)
+          << "failed to get offset of file with fd " << fd_ << ": "
+          << strerror(errno);  // NOLINT(concurrency-mt-unsafe)
+    }
+    return offset;
+  }
+
+private:
+  int fd_;
+};
+
+}  // namespace vt
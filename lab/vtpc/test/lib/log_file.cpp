@@ -3,35 +3,72 @@
 #include <sys/types.h>
 
 #include <cstddef>
-#include <iostream>
+#include <cstdint>
 #include <memory>
+#include <string_view>
 #include <utility>
 
 #include "file.hpp"
+#include "trace.hpp"
 
 namespace vt {
 
-log_file::log_file(std::unique_ptr<file> file) : file_(std::move(file)) {
+log_file::log_file(std::unique_ptr<file> file, std::string_view trace_path)
+    : file_(std::move(file)), trace_(trace_path) {
+}
+
+template <class F>
+auto log_file::record(trace_op op, uint64_t offset, uint64_t length, F action)
+    -> void {
+  trace_record record = {
+      .offset = offset,
+      .length = length,
+      .time_ns = trace_.now_ns(),
+      .result = 0,
+      .op = op,
+      .reserved = {},
+  };
+  try {
+    action();
+  } catch (const vt::file_exception& e) {
+    record.result = static_cast<int32_t>(e.code());
+    trace_.append(record);
+    resync();
+    throw;
+  }
+  trace_.append(record);
+}
+
+// resync — берёт позицию у файла. Если и это не удалось, остаётся прежняя:
+// исключение операции важнее.
+auto log_file::resync() noexcept -> void {
+  try {
+    pos_ = file_->tell();
+  } catch (const vt::exception&) {  // NOLINT(bugprone-empty-catch)
+  }
 }
 
 auto log_file::read(char* buffer, size_t count) -> void {
-  std::cerr << "[vt] read count " << count << "\n";
-  file_->read(buffer, count);
+  record(trace_op::read, pos_, count, [&] { file_->read(buffer, count); });
+  pos_ += static_cast<off_t>(count);
 }
 
 auto log_file::write(const char* buffer, size_t count) -> void {
-  std::cerr << "[vt] write count " << count << "\n";
-  file_->write(buffer, count);
+  record(trace_op::write, pos_, count, [&] { file_->write(buffer, count); });
+  pos_ += static_cast<off_t>(count);
 }
 
 auto log_file::seek(off_t offset) -> void {
-  std::cerr << "[vt] seek offset " << offset << "\n";
-  file_->seek(offset);
+  record(trace_op::seek, offset, 0, [&] { file_->seek(offset); });
+  pos_ = offset;
 }
 
 auto log_file::sync() -> void {
-  std::cerr << "[vt] sync\n";
-  file_->sync();
+  record(trace_op::sync, 0, 0, [&] { file_->sync(); });
+}
+
+auto log_file::tell() -> off_t {
+  return file_->tell();
 }
 
 }  // namespace vt
@@ -3,27 +3,42 @@
 #include <sys/types.h>
 
 #include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <string_view>
 
 #include "file.hpp"
+#include "trace.hpp"
 
 namespace vt {
 
+// log_file — пишет каждую операцию над файлом в двоичную трассу (trace.hpp),
+// которую затем проигрывает replay. Позицию для записей трасса ведёт сама,
+// а после неудачной операции, которая могла сдвинуть её на часть запроса,
+// берёт у файла.
 class log_file final : public file {
 public:
   using file::read;
   using file::write;
 
-  explicit log_file(std::unique_ptr<file> file);
+  log_file(std::unique_ptr<file> file, std::string_view trace_path);
   ~log_file() override = default;
 
   auto read(char* buffer, size_t count) -> void override;
   auto write(const char* buffer, size_t count) -> void override;
   auto seek(off_t offset) -> void override;
   auto sync() -> void override;
+  auto tell() -> off_t override;
 
 private:
+  template <class F>
+  auto record(trace_op op, uint64_t offset, uint64_t length, F action)
+      -> void;
+  auto resync() noexcept -> void;
+
   std::unique_ptr<file> file_;
+  trace_writer trace_;
+  off_t pos_ = 0;
 };
 
 }  // namespace vt
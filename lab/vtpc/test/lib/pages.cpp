@@ -0,0 +1,47 @@
+#include "pages.hpp"
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <string>
+
+#include "check.hpp"
+
+extern "C" {
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "vtpc.h"
+}
+
+namespace vt {
+
+auto open_filled(const char* path, size_t pages) -> int {
+  const int fd = vtpc_open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);  // NOLINT
+  check(fd >= 0, "vtpc_open");
+
+  std::string page(VTPC_PAGE_SIZE, 'x');
+  for (size_t i = 0; i < pages; ++i) {
+    check(
+        vtpc_write(fd, page.data(), page.size()) ==
+            static_cast<ssize_t>(page.size()),
+        "vtpc_write"
+    );
+  }
+  check(vtpc_fsync(fd) == 0, "vtpc_fsync");
+  return fd;
+}
+
+auto read_all(int fd, size_t pages) -> void {
+  std::string page(VTPC_PAGE_SIZE, ' ');
+  check(vtpc_lseek(fd, 0, SEEK_SET) == 0, "vtpc_lseek");
+  for (size_t i = 0; i < pages; ++i) {
+    check(
+        vtpc_read(fd, page.data(), page.size()) ==
+            static_cast<ssize_t>(page.size()),
+        "vtpc_read"
+    );
+  }
+}
+
+}  // namespace vt
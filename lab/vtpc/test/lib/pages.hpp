@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+
+namespace vt {
+
+// open_filled — создаёт через vtpc файл из pages страниц 'x', сбрасывает его
+// на диск и возвращает открытый на чтение и запись хэндл.
+auto open_filled(const char* path, size_t pages) -> int;
+
+// read_all — читает хэндл vtpc с начала pages целыми страницами.
+auto read_all(int fd, size_t pages) -> void;
+
+}  // namespace vt
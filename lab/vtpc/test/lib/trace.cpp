@@ -0,0 +1,131 @@
+#include "trace.hpp"
+
+#include <sys/types.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "exception.hpp"
+
+extern "C" {
+#include <fcntl.h>
+#include <unistd.h>
+}
+
+namespace vt {
+
+namespace {
+
+constexpr size_t trace_buffer_records = 4096;
+constexpr auto trace_access = 0644;
+
+auto steady_ns() -> uint64_t {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()
+  )
+      .count();
+}
+
+auto write_all(int fd, const void* data, size_t size) -> void {
+  const auto* bytes = static_cast<const char*>(data);
+  size_t done = 0;
+  while (done < size) {
+    const ssize_t written = ::write(fd, bytes + done, size - done);
+    if (written <= 0) {
+      throw vt::exception()
+          << "failed to write trace: "
+          << strerror(errno);  // NOLINT(concurrency-mt-unsafe)
+    }
+    done += static_cast<size_t>(written);
+  }
+}
+
+}  // namespace
+
+trace_writer::trace_writer(std::string_view path)
+    : fd_(::open(
+          std::string(path).c_str(), O_WRONLY | O_CREAT | O_TRUNC, trace_access
+      )),
+      start_ns_(steady_ns()) {
+  if (fd_ < 0) {
+    throw vt::exception() << "failed to open trace '" << path
+                          << "': " << strerror(errno);  // NOLINT
+  }
+  buffer_.reserve(trace_buffer_records);
+  const trace_header header = {
+      .magic = trace_magic,
+      .version = trace_version,
+      .record_size = sizeof(trace_record),
+  };
+  write_all(fd_, &header, sizeof(header));
+}
+
+trace_writer::~trace_writer() {
+  try {
+    flush();
+  } catch (const vt::exception& e) {  // NOLINT
+    // Деструктор не бросает; недописанный хвост трассы теряется
+  }
+  (void)::close(fd_);
+}
+
+auto trace_writer::now_ns() const -> uint64_t {
+  return steady_ns() - start_ns_;
+}
+
+auto trace_writer::append(const trace_record& record) -> void {
+  buffer_.push_back(record);
+  if (buffer_.size() == trace_buffer_records) {
+    flush();
+  }
+}
+
+auto trace_writer::flush() -> void {
+  write_all(fd_, buffer_.data(), buffer_.size() * sizeof(trace_record));
+  buffer_.clear();
+}
+
+auto read_trace(std::string_view path) -> std::vector<trace_record> {
+  const int fd = ::open(std::string(path).c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw vt::exception() << "failed to open trace '" << path
+                          << "': " << strerror(errno);  // NOLINT
+  }
+
+  std::string data;
+  std::string chunk(trace_buffer_records * sizeof(trace_record), 0);
+  ssize_t got = 0;
+  while ((got = ::read(fd, chunk.data(), chunk.size())) > 0) {
+    data.append(chunk.data(), static_cast<size_t>(got));
+  }
+  const int saved = errno;
+  (void)::close(fd);
+  if (got < 0) {
+    throw vt::exception() << "failed to read trace '" << path
+                          << "': " << strerror(saved);  // NOLINT
+  }
+
+  trace_header header{};
+  if (data.size() < sizeof(header)) {
+    throw vt::exception() << "'" << path << "' is not a trace";
+  }
+  std::memcpy(&header, data.data(), sizeof(header));
+  const size_t body = data.size() - sizeof(header);
+  if (header.magic != trace_magic || header.version != trace_version ||
+      header.record_size != sizeof(trace_record) ||
+      body % sizeof(trace_record) != 0) {
+    throw vt::exception() << "'" << path << "' is not a trace";
+  }
+
+  std::vector<trace_record> records(body / sizeof(trace_record));
+  std::memcpy(records.data(), data.data() + sizeof(header), body);
+  return records;
+}
+
+}  // namespace vt
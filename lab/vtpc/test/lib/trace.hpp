@@ -0,0 +1,67 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace vt {
+
+// Трасса — заголовок trace_header и следом записи trace_record фиксированного
+// размера в порядке выполнения операций.
+
+enum class trace_op : uint8_t { read, write, seek, sync };
+
+struct trace_header {
+  uint64_t magic;
+  uint32_t version;
+  uint32_t record_size;
+};
+
+// trace_record — одна операция: offset — позиция чтения или записи либо
+// цель seek, time_ns — начало операции от открытия трассы, result — 0 или
+// код vt::file_exception.
+struct trace_record {
+  uint64_t offset;
+  uint64_t length;
+  uint64_t time_ns;
+  int32_t result;
+  trace_op op;
+  uint8_t reserved[3];
+};
+
+static_assert(sizeof(trace_record) == 32);
+
+constexpr uint64_t trace_magic = 0x31454341525456ULL;  // "VTRACE1"
+constexpr uint32_t trace_version = 1;
+
+// trace_writer — буферизованная запись трассы в файл; буфер сбрасывается
+// при заполнении и в деструкторе.
+class trace_writer {
+public:
+  explicit trace_writer(std::string_view path);
+  ~trace_writer();
+
+  trace_writer(const trace_writer&) = delete;
+  auto operator=(const trace_writer&) -> trace_writer& = delete;
+  trace_writer(trace_writer&&) = delete;
+  auto operator=(trace_writer&&) -> trace_writer& = delete;
+
+  // now_ns — время от открытия трассы.
+  [[nodiscard]] auto now_ns() const -> uint64_t;
+
+  auto append(const trace_record& record) -> void;
+  auto flush() -> void;
+
+private:
+  int fd_;
+  uint64_t start_ns_;
+  std::vector<trace_record> buffer_;
+};
+
+// read_trace — все записи трассы; бросает vt::exception, если файл не трасса.
+auto read_trace(std::string_view path) -> std::vector<trace_record>;
+
+}  // namespace vt
@@ -0,0 +1,192 @@
+#include <sys/types.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "cmp_file.hpp"
+#include "exception.hpp"
+#include "file.hpp"
+#include "trace.hpp"
+
+extern "C" {
+#include "vtpc.h"
+}
+
+// replay — проигрывает трассу vt::log_file на выбранном бэкенде: libc, vtpc
+// или cmp (vtpc, сверяемый с libc). С --timing fast операции идут без пауз,
+// с --timing original каждая начинается не раньше, чем в исходном прогоне.
+// Чтение и запись выполняются с записанной позиции: если текущая позиция
+// с ней расходится (например, после неудачной операции), сначала делается
+// seek. Печатает пропускную способность, число операций, чей результат
+// разошёлся с записанным, и наибольшее опоздание относительно исходного
+// времени.
+
+namespace {
+
+constexpr double micro = 1e6;
+constexpr double nano_per_micro = 1e3;
+
+struct options {
+  std::string trace;
+  std::string backend = "vtpc";
+  std::string timing = "fast";
+  std::string path = "/tmp/vtpc_replay";
+  size_t cache_pages = 4096;  // NOLINT
+};
+
+auto parse(int argc, char** argv) -> options {
+  options opts;
+  const std::vector<std::string_view> args(argv + 1, argv + argc);
+  for (size_t i = 0; i < args.size(); ++i) {
+    const std::string_view key = args[i];
+    if (!key.starts_with("--")) {
+      opts.trace = key;
+      continue;
+    }
+    if (i + 1 == args.size()) {
+      throw vt::exception() << "missing value for '" << key << "'";
+    }
+    const std::string value(args[++i]);
+    if (key == "--backend") {
+      opts.backend = value;
+    } else if (key == "--timing") {
+      opts.timing = value;
+    } else if (key == "--path") {
+      opts.path = value;
+    } else if (key == "--cache-pages") {
+      char* end = nullptr;
+      opts.cache_pages = std::strtoull(value.c_str(), &end, 10);
+      if (value.empty() || *end != '\0') {
+        throw vt::exception() << "bad number '" << value << "'";
+      }
+    } else {
+      throw vt::exception()
+          << "unknown option '" << key
+          << "'; usage: replay TRACE [--backend libc|vtpc|cmp] "
+             "[--timing fast|original] [--path PATH] [--cache-pages N]";
+    }
+  }
+  if (opts.trace.empty() ||
+      (opts.backend != "libc" && opts.backend != "vtpc" &&
+       opts.backend != "cmp") ||
+      (opts.timing != "fast" && opts.timing != "original")) {
+    throw vt::exception() << "bad options";
+  }
+  return opts;
+}
+
+// open_backend — создаёт файлы бэкенда заново.
+auto open_backend(const options& opts) -> std::unique_ptr<vt::file> {
+  const std::string libc_path = opts.path + ".libc";
+  std::filesystem::remove(opts.path);
+  std::filesystem::remove(libc_path);
+  if (opts.backend == "libc") {
+    return vt::file::open_libc(opts.path);
+  }
+  if (opts.backend == "vtpc") {
+    return vt::file::open_vtpc(opts.path);
+  }
+  return std::make_unique<vt::cmp_file>(
+      vt::file::open_libc(libc_path), vt::file::open_vtpc(opts.path)
+  );
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) -> int try {
+  const options opts = parse(argc, argv);
+  const std::vector<vt::trace_record> records = vt::read_trace(opts.trace);
+
+  struct vtpc_config config = VTPC_CONFIG_DEFAULT;
+  config.cache_pages = opts.cache_pages;
+  if (vtpc_configure(&config) != 0) {
+    throw vt::exception() << "vtpc_configure failed";
+  }
+
+  uint64_t max_length = 0;
+  for (const vt::trace_record& record : records) {
+    max_length = std::max(max_length, record.length);
+  }
+  std::string buffer(max_length, 0);
+  std::string data(max_length, 0);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<char>('a' + i % 26);  // NOLINT
+  }
+
+  auto file = open_backend(opts);
+  const bool original = opts.timing == "original";
+  size_t mismatches = 0;
+  uint64_t bytes = 0;
+  std::chrono::nanoseconds max_lag{0};
+  int64_t pos = 0;  // -1 — неизвестна после неудачной операции
+
+  const auto start = std::chrono::steady_clock::now();
+  for (const vt::trace_record& record : records) {
+    if (original) {
+      const auto due = start + std::chrono::nanoseconds(record.time_ns);
+      std::this_thread::sleep_until(due);
+      max_lag = std::max(max_lag, std::chrono::steady_clock::now() - due);
+    }
+
+    const bool io =
+        record.op == vt::trace_op::read || record.op == vt::trace_op::write;
+    const auto offset = static_cast<int64_t>(record.offset);
+    int32_t result = 0;
+    try {
+      if (io && pos != offset) {
+        file->seek(static_cast<off_t>(offset));
+        pos = offset;
+      }
+      if (record.op == vt::trace_op::read) {
+        file->read(buffer.data(), record.length);
+        pos += static_cast<int64_t>(record.length);
+      } else if (record.op == vt::trace_op::write) {
+        file->write(data.data(), record.length);
+        pos += static_cast<int64_t>(record.length);
+      } else if (record.op == vt::trace_op::seek) {
+        file->seek(static_cast<off_t>(offset));
+        pos = offset;
+      } else {
+        file->sync();
+      }
+    } catch (const vt::file_exception& e) {
+      result = static_cast<int32_t>(e.code());
+      pos = -1;
+    }
+    if (result != record.result) {
+      ++mismatches;
+    }
+    if (result == 0) {
+      bytes += record.length;
+    }
+  }
+  file.reset();
+  const double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+          .count();
+
+  const double ops = static_cast<double>(records.size());
+  std::cout << "backend,timing,ops,seconds,ops_per_sec,mb_per_sec,"
+               "mismatches,max_lag_us\n"
+            << opts.backend << ',' << opts.timing << ',' << records.size()
+            << ',' << seconds << ',' << ops / seconds << ','
+            << static_cast<double>(bytes) / seconds / micro << ','
+            << mismatches << ','
+            << static_cast<double>(max_lag.count()) / nano_per_micro << '\n';
+  return 0;
+} catch (const std::exception& e) {
+  std::cerr << "exception: " << e.what() << '\n';
+  return 1;
+}
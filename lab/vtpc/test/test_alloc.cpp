@@ -0,0 +1,178 @@
+#include <sys/types.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "check.hpp"
+#include "exception.hpp"
+
+extern "C" {
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "vtpc.h"
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* ptr);
+}
+
+namespace {
+
+using vt::check;
+using vt::expect;
+
+std::atomic<size_t> allocations{0};
+
+constexpr size_t seed = 1;
+constexpr size_t cache_pages = 16;
+constexpr size_t l2_pages = 64;
+constexpr size_t reclaim_low = 4;
+constexpr size_t reclaim_high = 8;
+constexpr size_t warmup_steps = (1U << 12U);
+constexpr size_t steps = (1U << 16U);
+constexpr size_t size = 64 * VTPC_PAGE_SIZE;
+constexpr auto monitor_interval =
+    std::chrono::milliseconds(VTPC_MONITOR_INTERVAL_MS);
+
+auto stats() -> struct vtpc_stats {
+  struct vtpc_stats stats{};
+  check(vtpc_stats(&stats) == 0, "vtpc_stats");
+  return stats;
+}
+
+auto snapshot() -> struct vtpc_monitor {
+  struct vtpc_monitor monitor{};
+  check(vtpc_monitor_read(getpid(), &monitor) == 0, "vtpc_monitor_read");
+  return monitor;
+}
+
+class workload {
+public:
+  explicit workload(int fd) : fd_(fd), buffer_(size / 4) {
+  }
+
+  auto run(size_t steps) -> void {
+    for (size_t i = 0; i < steps; ++i) {
+      const size_t point = action_dist_(random_);
+      if (point < 40) {  // NOLINT
+        vtpc_read(fd_, buffer_.data(), batch_dist_(random_));
+      } else if (point < 75) {  // NOLINT
+        const size_t batch = batch_dist_(random_);
+        std::fill_n(buffer_.begin(), batch, static_cast<char>('a' + i % 26));
+        vtpc_write(fd_, buffer_.data(), batch);
+      } else if (point < 95) {  // NOLINT
+        vtpc_lseek(fd_, offset_dist_(random_), SEEK_SET);
+      } else if (point < 98) {  // NOLINT
+        vtpc_fsync(fd_);
+      } else {
+        vtpc_fadvise(fd_, 0, 0, VTPC_FADV_DONTNEED);
+      }
+    }
+  }
+
+private:
+  int fd_;
+  std::vector<char> buffer_;
+  std::default_random_engine random_{seed};  // NOLINT
+  std::uniform_int_distribution<size_t> action_dist_{0, 100};  // NOLINT
+  std::uniform_int_distribution<off_t> offset_dist_{0, size};
+  std::uniform_int_distribution<size_t> batch_dist_{0, size / 4};
+};
+
+}  // namespace
+
+// NOLINTBEGIN
+extern "C" void* malloc(size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* ptr, size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_realloc(ptr, size);
+}
+
+extern "C" int posix_memalign(void** ptr, size_t alignment, size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  *ptr = __libc_memalign(alignment, size);
+  return *ptr ? 0 : ENOMEM;
+}
+
+extern "C" void free(void* ptr) {
+  __libc_free(ptr);
+}
+// NOLINTEND
+
+auto main() -> int try {
+  // Горячий путь проверяется со всеми фоновыми механизмами: вторым уровнем,
+  // фоновым освобождением и публикацией счётчиков для vtpc-top.
+  struct vtpc_config config = VTPC_CONFIG_DEFAULT;
+  config.cache_pages = cache_pages;
+  config.readahead_pages = cache_pages / 2;
+  config.l2_path = "/tmp/vtpc_alloc_l2";
+  config.l2_pages = l2_pages;
+  config.reclaim_low = reclaim_low;
+  config.reclaim_high = reclaim_high;
+  config.monitor = 1;
+  check(vtpc_configure(&config) == 0, "vtpc_configure");
+
+  const int fd = vtpc_open("/tmp/vtpc_alloc", O_RDWR | O_CREAT | O_TRUNC, 0644);
+  check(fd >= 0, "vtpc_open");
+  const std::vector<char> zeros(size);
+  check(
+      vtpc_write(fd, zeros.data(), zeros.size()) ==
+          static_cast<ssize_t>(zeros.size()),
+      "vtpc_write"
+  );
+  check(vtpc_fadvise(fd, 0, 0, VTPC_FADV_WILLNEED) == 0, "vtpc_fadvise");
+
+  workload load(fd);
+  load.run(warmup_steps);
+
+  const struct vtpc_stats stats_before = stats();
+  const struct vtpc_monitor monitor_before = snapshot();
+  const size_t before = allocations.load();
+  load.run(steps / 2);
+  // Пауза дольше интервала монитора: вторая половина опубликует снимок.
+  std::this_thread::sleep_for(2 * monitor_interval);
+  load.run(steps / 2);
+  const size_t after = allocations.load();
+  const struct vtpc_stats stats_after = stats();
+  const struct vtpc_monitor monitor_after = snapshot();
+
+  check(vtpc_close(fd) == 0, "vtpc_close");
+  if (after != before) {
+    throw vt::exception() << after - before
+                          << " allocations in the steady state";
+  }
+  expect(stats_after.l2_writes > stats_before.l2_writes, "L2 was not used");
+  expect(
+      stats_after.reclaimed_pages > stats_before.reclaimed_pages,
+      "background reclaim did not run"
+  );
+  expect(
+      monitor_after.time_ns > monitor_before.time_ns,
+      "monitor did not publish"
+  );
+  return 0;
+} catch (const std::exception& e) {
+  std::cerr << "exception: " << e.what() << '\n';
+  return 1;
+}
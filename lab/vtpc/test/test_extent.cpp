@@ -0,0 +1,145 @@
+#include <linux/fiemap.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include "check.hpp"
+
+extern "C" {
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "vtpc.h"
+}
+
+namespace {
+
+using vt::check;
+using vt::expect;
+
+constexpr size_t cache_pages = 64;
+constexpr size_t default_extent_pages = 256;
+constexpr size_t chunk = 1000;
+constexpr size_t file_size = 16U << 20U;
+constexpr size_t block_size = 512;
+constexpr size_t metadata_slack = 16 * VTPC_PAGE_SIZE;  // блоки дерева участков
+constexpr std::array<const char*, 2> paths = {
+    "/tmp/extent_a",
+    "/tmp/extent_b",
+};
+
+auto stat_of(const char* path) -> struct stat {
+  struct stat st{};
+  check(stat(path, &st) == 0, "stat");
+  return st;
+}
+
+// Число участков файла на диске по FIEMAP, как у filefrag.
+auto extents_of(const char* path) -> size_t {
+  const int fd = open(path, O_RDONLY);  // NOLINT
+  check(fd >= 0, "open");
+  struct fiemap map{};
+  map.fm_length = FIEMAP_MAX_OFFSET;
+  map.fm_flags = FIEMAP_FLAG_SYNC;
+  const int result = ioctl(fd, FS_IOC_FIEMAP, &map);  // NOLINT
+  close(fd);
+  check(result == 0, "FS_IOC_FIEMAP");
+  return map.fm_mapped_extents;
+}
+
+auto byte_at(size_t file, size_t offset) -> char {
+  return static_cast<char>('a' + (file * 7 + offset / chunk) % 26);  // NOLINT
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) -> int try {
+  const size_t extent_pages =
+      argc > 1 ? std::strtoul(argv[1], nullptr, 10)  // NOLINT
+               : default_extent_pages;
+  const struct vtpc_config config = {
+      .cache_pages = cache_pages,
+      .readahead_pages = 0,
+      .extent_pages = extent_pages,
+  };
+  check(vtpc_configure(&config) == 0, "vtpc_configure");
+
+  // Два файла дописываются поочерёдно, как два журнала: без предвыделения
+  // их блоки перемежаются на диске.
+  std::array<int, paths.size()> fds{};
+  for (size_t i = 0; i < paths.size(); ++i) {
+    fds[i] = vtpc_open(paths[i], O_RDWR | O_CREAT | O_TRUNC, 0644);  // NOLINT
+    check(fds[i] >= 0, "vtpc_open");
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  std::string data(chunk, '\0');
+  for (size_t offset = 0; offset < file_size; offset += chunk) {
+    for (size_t i = 0; i < paths.size(); ++i) {
+      data.assign(chunk, byte_at(i, offset));
+      check(
+          vtpc_write(fds[i], data.data(), data.size()) ==
+              static_cast<ssize_t>(data.size()),
+          "vtpc_write"
+      );
+    }
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  const double seconds = std::chrono::duration<double>(elapsed).count();
+
+  const size_t total = file_size / chunk * chunk + chunk;
+  const size_t used = (total + VTPC_PAGE_SIZE - 1) / VTPC_PAGE_SIZE *
+                      VTPC_PAGE_SIZE;
+  // До сброса файл на диске растёт целыми участками.
+  const struct stat before = stat_of(paths[0]);
+  if (extent_pages > 0) {
+    const size_t extent = extent_pages * VTPC_PAGE_SIZE;
+    expect(
+        before.st_size > 0 && static_cast<size_t>(before.st_size) % extent == 0,
+        "file did not grow by whole extents"
+    );
+  }
+
+  for (size_t i = 0; i < paths.size(); ++i) {
+    check(vtpc_fsync(fds[i]) == 0, "vtpc_fsync");
+    check(vtpc_close(fds[i]) == 0, "vtpc_close");
+  }
+
+  const double megabytes = static_cast<double>(paths.size() * total) / 1e6;
+  std::cout << "extent_pages " << extent_pages << ": " << megabytes / seconds
+            << " MB/s, extents " << extents_of(paths[0]) << " and "
+            << extents_of(paths[1]) << '\n';
+
+  for (size_t i = 0; i < paths.size(); ++i) {
+    const struct stat after = stat_of(paths[i]);
+    expect(static_cast<size_t>(after.st_size) == total, "wrong file size");
+    expect(
+        static_cast<size_t>(after.st_blocks) * block_size <=
+            used + metadata_slack,
+        "preallocated tail was not trimmed"
+    );
+
+    const int fd = open(paths[i], O_RDONLY);  // NOLINT
+    check(fd >= 0, "open");
+    std::string content(total, '\0');
+    const ssize_t got = pread(fd, content.data(), content.size(), 0);
+    close(fd);
+    check(got == static_cast<ssize_t>(total), "pread");
+    for (size_t offset = 0; offset < total; offset += chunk) {
+      expect(content[offset] == byte_at(i, offset), "file content differs");
+    }
+  }
+  return 0;
+} catch (const std::exception& e) {
+  std::cerr << "exception: " << e.what() << '\n';
+  return 1;
+}
@@ -0,0 +1,149 @@
+#include <sys/types.h>
+
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "check.hpp"
+#include "pages.hpp"
+
+extern "C" {
+#include <fcntl.h>
+
+#include "vtpc.h"
+}
+
+namespace {
+
+using vt::check;
+using vt::expect;
+using vt::open_filled;
+
+constexpr size_t cache_pages = 64;
+constexpr size_t readahead_pages = 8;
+constexpr size_t file_pages = 32;
+constexpr size_t noreuse_pages = 16;
+constexpr auto wait_limit = std::chrono::seconds(5);
+
+auto stats() -> struct vtpc_stats {
+  struct vtpc_stats stats{};
+  check(vtpc_stats(&stats) == 0, "vtpc_stats");
+  return stats;
+}
+
+auto read_pages(int fd, size_t first, size_t count) -> void {
+  std::string page(VTPC_PAGE_SIZE, ' ');
+  const auto offset = static_cast<off_t>(first * VTPC_PAGE_SIZE);
+  check(vtpc_lseek(fd, offset, SEEK_SET) == offset, "vtpc_lseek");
+  for (size_t i = 0; i < count; ++i) {
+    check(
+        vtpc_read(fd, page.data(), page.size()) ==
+            static_cast<ssize_t>(page.size()),
+        "vtpc_read"
+    );
+  }
+}
+
+auto drop(int fd) -> void {
+  check(vtpc_fadvise(fd, 0, 0, VTPC_FADV_DONTNEED) == 0, "DONTNEED");
+}
+
+auto wait_readahead(size_t pages) -> void {
+  const auto deadline = std::chrono::steady_clock::now() + wait_limit;
+  while (stats().readahead_pages < pages) {
+    expect(std::chrono::steady_clock::now() < deadline, "readahead stalled");
+    std::this_thread::yield();
+  }
+}
+
+auto test_dontneed(int fd) -> void {
+  drop(fd);
+  expect(stats().used_pages == 0, "DONTNEED kept clean pages");
+}
+
+auto test_willneed(int fd) -> void {
+  drop(fd);
+  const struct vtpc_stats before = stats();
+  check(
+      vtpc_fadvise(fd, 0, file_pages * VTPC_PAGE_SIZE, VTPC_FADV_WILLNEED) ==
+          0,
+      "WILLNEED"
+  );
+
+  wait_readahead(before.readahead_pages + file_pages);
+
+  read_pages(fd, 0, file_pages);
+  expect(stats().misses == before.misses, "WILLNEED pages were not used");
+}
+
+auto test_sequential(int fd) -> void {
+  drop(fd);
+  const struct vtpc_stats before = stats();
+  check(vtpc_fadvise(fd, 0, 0, VTPC_FADV_SEQUENTIAL) == 0, "SEQUENTIAL");
+  read_pages(fd, 0, 2);
+  wait_readahead(before.readahead_pages + readahead_pages);
+  read_pages(fd, 2, file_pages - 2);
+  expect(
+      stats().misses - before.misses < file_pages,
+      "SEQUENTIAL readahead was not used"
+  );
+}
+
+auto test_random(int fd) -> void {
+  drop(fd);
+  const struct vtpc_stats before = stats();
+  check(vtpc_fadvise(fd, 0, 0, VTPC_FADV_RANDOM) == 0, "RANDOM");
+  read_pages(fd, 0, file_pages);
+  const struct vtpc_stats after = stats();
+  expect(
+      after.readahead_pages == before.readahead_pages,
+      "RANDOM still issued readahead"
+  );
+  expect(after.misses - before.misses == file_pages, "RANDOM missed too few");
+}
+
+auto test_noreuse(int hot_fd, int cold_fd) -> void {
+  drop(cold_fd);
+  read_pages(hot_fd, 0, cache_pages);
+  read_pages(hot_fd, 0, cache_pages);
+
+  check(vtpc_fadvise(cold_fd, 0, 0, VTPC_FADV_NOREUSE) == 0, "NOREUSE");
+  read_pages(cold_fd, 0, noreuse_pages);
+
+  const struct vtpc_stats before = stats();
+  read_pages(hot_fd, 0, cache_pages);
+  const struct vtpc_stats after = stats();
+  expect(
+      after.misses - before.misses <= 1,
+      "NOREUSE pages pushed hot pages out"
+  );
+}
+
+}  // namespace
+
+auto main() -> int try {
+  const struct vtpc_config config = {
+      .cache_pages = cache_pages,
+      .readahead_pages = readahead_pages,
+  };
+  check(vtpc_configure(&config) == 0, "vtpc_configure");
+
+  const int fd = open_filled("/tmp/vtpc_fadvise", file_pages);
+  test_dontneed(fd);
+
+  const int hot_fd = open_filled("/tmp/vtpc_fadvise_hot", cache_pages);
+  test_willneed(fd);
+  test_sequential(fd);
+  test_random(fd);
+  test_noreuse(hot_fd, fd);
+
+  check(vtpc_close(hot_fd) == 0, "vtpc_close");
+  check(vtpc_close(fd) == 0, "vtpc_close");
+  return 0;
+} catch (const std::exception& e) {
+  std::cerr << "exception: " << e.what() << '\n';
+  return 1;
+}
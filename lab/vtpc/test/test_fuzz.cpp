@@ -0,0 +1,444 @@
+#include <sys/types.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "check.hpp"
+#include "cmp_file.hpp"
+#include "exception.hpp"
+#include "file.hpp"
+
+extern "C" {
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "vtpc.h"
+}
+
+// test_fuzz — дифференциальный фаззер vtpc против libc. Сиды из диапазона
+// [--first, --first + --seeds) делятся между --workers процессами, у каждого
+// процесса своя пара файлов. Сид задаёт последовательность из --steps
+// операций, которая прогоняется через cmp_file без пооперационного журнала.
+// Если vtpc и libc расходятся, последовательность сокращается (ddmin, затем
+// уменьшение размеров и смещений) до минимального воспроизводящего примера,
+// который печатается целиком.
+//
+// По умолчанию vtpc работает на VTPC_DEVICE_SIM с виртуальными часами, а файл
+// libc лежит в /dev/shm: ни одна операция, включая sync, не доходит до
+// настоящего диска. Файлы процесса создаются один раз и перед каждым прогоном
+// усекаются. --device posix проверяет путь через O_DIRECT на файлах в /tmp.
+// Если процесс падает или завершается по исключению, печатается сид, на
+// котором это случилось.
+
+namespace {
+
+using vt::check;
+
+constexpr size_t page = VTPC_PAGE_SIZE;
+
+struct options {
+  uint64_t first = 1;
+  size_t seeds = 1000;  // NOLINT
+  size_t steps = 256;   // NOLINT
+  size_t workers = std::max(1U, std::thread::hardware_concurrency());
+  size_t cache_pages = 4;
+  size_t file_pages = 8;
+  int device = VTPC_DEVICE_SIM;
+  std::string dir;  // пусто — /dev/shm для sim и /tmp для posix
+};
+
+enum class op_kind : uint8_t { read, write, seek, sync, reopen };
+
+struct op {
+  op_kind kind;
+  size_t value;  // размер для read и write, смещение для seek
+  uint8_t fill;  // первый байт записываемых данных
+};
+
+auto generate(const options& opts, uint64_t seed) -> std::vector<op> {
+  const size_t size = opts.file_pages * page;
+  std::mt19937_64 random(seed);
+  std::uniform_int_distribution<size_t> action_dist(0, 99);  // NOLINT
+  std::uniform_int_distribution<size_t> offset_dist(0, size);
+  std::uniform_int_distribution<size_t> batch_dist(0, 2 * page);
+  std::uniform_int_distribution<unsigned> fill_dist(0, UINT8_MAX);
+
+  std::vector<op> ops;
+  ops.reserve(opts.steps);
+  for (size_t i = 0; i < opts.steps; ++i) {
+    const size_t point = action_dist(random);
+    if (point < 35) {  // NOLINT
+      ops.push_back({op_kind::read, batch_dist(random), 0});
+    } else if (point < 70) {  // NOLINT
+      const size_t batch = batch_dist(random);
+      const auto fill = static_cast<uint8_t>(fill_dist(random));
+      ops.push_back({op_kind::write, batch, fill});
+    } else if (point < 92) {  // NOLINT
+      ops.push_back({op_kind::seek, offset_dist(random), 0});
+    } else if (point < 97) {  // NOLINT
+      ops.push_back({op_kind::sync, 0, 0});
+    } else {
+      ops.push_back({op_kind::reopen, 0, 0});
+    }
+  }
+  return ops;
+}
+
+auto describe(const op& op) -> std::string {
+  std::ostringstream out;
+  switch (op.kind) {
+    case op_kind::read:
+      out << "read " << op.value;
+      break;
+    case op_kind::write:
+      out << "write " << op.value << " fill " << static_cast<unsigned>(op.fill);
+      break;
+    case op_kind::seek:
+      out << "seek " << op.value;
+      break;
+    case op_kind::sync:
+      out << "sync";
+      break;
+    case op_kind::reopen:
+      out << "reopen";
+      break;
+  }
+  return out.str();
+}
+
+// runner — пара файлов процесса и буферы, общие для всех прогонов.
+class runner {
+public:
+  explicit runner(const options& opts) {
+    const std::string prefix =
+        opts.dir + "/vtpc_fuzz_" + std::to_string(getpid());
+    lhs_path_ = prefix + "_a";
+    rhs_path_ = prefix + "_b";
+    buffer_.resize(2 * page);
+    data_.resize(2 * page);
+  }
+
+  runner(const runner&) = delete;
+  auto operator=(const runner&) -> runner& = delete;
+  runner(runner&&) = delete;
+  auto operator=(runner&&) -> runner& = delete;
+
+  ~runner() {
+    file_.reset();
+    std::filesystem::remove(lhs_path_);
+    std::filesystem::remove(rhs_path_);
+  }
+
+  // run — прогоняет ops с пустых файлов; возвращает описание первого
+  // расхождения и запоминает номер операции, на которой оно случилось.
+  auto run(const std::vector<op>& ops) -> std::optional<std::string> {
+    file_.reset();
+    truncate();
+    open();
+
+    for (size_t i = 0; i < ops.size(); ++i) {
+      try {
+        apply(ops[i]);
+      } catch (const vt::cmp_file_exception& e) {
+        failed_at_ = i;
+        return e.what();
+      } catch (const vt::file_exception& e) {  // NOLINT
+        // Обе реализации вернули одну и ту же ошибку
+      }
+    }
+    return std::nullopt;
+  }
+
+  [[nodiscard]] auto failed_at() const -> size_t {
+    return failed_at_;
+  }
+
+private:
+  // truncate — опустошает оба файла, не удаляя их: создание и удаление файла
+  // на каждый прогон обходились дороже самих операций.
+  auto truncate() -> void {
+    constexpr int flags = O_RDWR | O_CREAT | O_TRUNC;
+    const int lhs = ::open(lhs_path_.c_str(), flags, 0600);  // NOLINT
+    check(lhs >= 0 && ::close(lhs) == 0, "truncate");
+    const int rhs = vtpc_open(rhs_path_.c_str(), flags, 0600);  // NOLINT
+    check(rhs >= 0 && vtpc_close(rhs) == 0, "vtpc truncate");
+  }
+
+  auto open() -> void {
+    file_ = std::make_unique<vt::cmp_file>(
+        vt::file::open_libc(lhs_path_), vt::file::open_vtpc(rhs_path_)
+    );
+  }
+
+  auto apply(const op& op) -> void {
+    switch (op.kind) {
+      case op_kind::read:
+        file_->read(buffer_.data(), op.value);
+        break;
+      case op_kind::write:
+        for (size_t i = 0; i < op.value; ++i) {
+          data_[i] = static_cast<char>(op.fill + i);
+        }
+        file_->write(data_.data(), op.value);
+        break;
+      case op_kind::seek:
+        file_->seek(static_cast<off_t>(op.value));
+        break;
+      case op_kind::sync:
+        file_->sync();
+        break;
+      case op_kind::reopen:
+        file_.reset();
+        open();
+        break;
+    }
+  }
+
+  std::string lhs_path_;
+  std::string rhs_path_;
+  std::unique_ptr<vt::cmp_file> file_;
+  std::string buffer_;
+  std::string data_;
+  size_t failed_at_ = 0;
+};
+
+// drop_ops — ddmin по операциям: выбрасывает куски всё меньшего размера, пока
+// расхождение воспроизводится.
+auto drop_ops(runner& run, std::vector<op>& ops) -> bool {
+  bool shrunk = false;
+  size_t chunks = 2;
+  while (ops.size() >= 2) {
+    const size_t chunk = (ops.size() + chunks - 1) / chunks;
+    bool reduced = false;
+    for (size_t begin = 0; begin < ops.size(); begin += chunk) {
+      std::vector<op> candidate(ops.begin(), ops.begin() + begin);
+      const size_t end = std::min(ops.size(), begin + chunk);
+      candidate.insert(candidate.end(), ops.begin() + end, ops.end());
+      if (run.run(candidate)) {
+        candidate.resize(run.failed_at() + 1);
+        ops = std::move(candidate);
+        chunks = std::max<size_t>(chunks - 1, 2);
+        reduced = true;
+        shrunk = true;
+        break;
+      }
+    }
+    if (!reduced) {
+      if (chunk == 1) {
+        break;
+      }
+      chunks = std::min(chunks * 2, ops.size());
+    }
+  }
+  return shrunk;
+}
+
+// shrink_values — по одной уменьшает размеры и смещения операций двоичным
+// поиском наименьшего значения, на котором расхождение ещё воспроизводится.
+auto shrink_values(runner& run, std::vector<op>& ops) -> bool {
+  bool shrunk = false;
+  for (op& op : ops) {
+    size_t low = 0;
+    size_t high = op.value;
+    while (low < high) {
+      const size_t saved = op.value;
+      op.value = low + (high - low) / 2;
+      if (run.run(ops) && run.failed_at() + 1 == ops.size()) {
+        high = op.value;
+        shrunk = true;
+      } else {
+        op.value = saved;
+        low = low + (high - low) / 2 + 1;
+      }
+    }
+  }
+  return shrunk;
+}
+
+// shrink — чередует оба сокращения, пока хоть одно что-то меняет.
+auto shrink(runner& run, std::vector<op> ops) -> std::vector<op> {
+  ops.resize(run.failed_at() + 1);
+  while (drop_ops(run, ops) || shrink_values(run, ops)) {
+  }
+  return ops;
+}
+
+// fuzz — сиды одного процесса; возвращает число расхождений. Текущий сид
+// записывается в current, который родитель читает, если процесс упал.
+auto fuzz(const options& opts, size_t worker, volatile uint64_t& current)
+    -> size_t {
+  struct vtpc_config config = VTPC_CONFIG_DEFAULT;
+  config.cache_pages = opts.cache_pages;
+  config.readahead_pages = 2;
+  config.device = opts.device;
+  config.sim = {
+      .clock = VTPC_SIM_CLOCK_VIRTUAL,
+      .queue_depth = 1,
+  };
+  check(vtpc_configure(&config) == 0, "vtpc_configure");
+
+  runner run(opts);
+  size_t failures = 0;
+  for (size_t i = worker; i < opts.seeds; i += opts.workers) {
+    const uint64_t seed = opts.first + i;
+    current = seed;
+    const std::vector<op> ops = generate(opts, seed);
+    const std::optional<std::string> diverged = run.run(ops);
+    if (!diverged) {
+      continue;
+    }
+
+    ++failures;
+    const size_t failed_at = run.failed_at();
+    const std::vector<op> minimal = shrink(run, ops);
+    const std::optional<std::string> reason = run.run(minimal);
+
+    std::ostringstream report;
+    report << "seed " << seed << " diverged at op " << failed_at << ": "
+           << *diverged << "\nminimal reproducer (" << minimal.size()
+           << " ops): " << reason.value_or("not reproduced") << '\n';
+    for (const op& op : minimal) {
+      report << "  " << describe(op) << '\n';
+    }
+    std::cerr << report.str() << std::flush;
+  }
+  return failures;
+}
+
+auto parse(int argc, char** argv) -> options {
+  options opts;
+  const std::vector<std::string_view> args(argv + 1, argv + argc);
+  for (size_t i = 0; i < args.size(); ++i) {
+    const std::string_view key = args[i];
+    if (i + 1 == args.size()) {
+      throw vt::exception() << "missing value for '" << key << "'";
+    }
+    const std::string value(args[++i]);
+    const auto number = [&] {
+      char* end = nullptr;
+      const unsigned long long result = std::strtoull(value.c_str(), &end, 10);
+      if (value.empty() || *end != '\0') {
+        throw vt::exception() << "bad number '" << value << "'";
+      }
+      return static_cast<size_t>(result);
+    };
+    if (key == "--first") {
+      opts.first = number();
+    } else if (key == "--seeds") {
+      opts.seeds = number();
+    } else if (key == "--steps") {
+      opts.steps = number();
+    } else if (key == "--workers") {
+      opts.workers = number();
+    } else if (key == "--cache-pages") {
+      opts.cache_pages = number();
+    } else if (key == "--file-pages") {
+      opts.file_pages = number();
+    } else if (key == "--device") {
+      if (value != "sim" && value != "posix") {
+        throw vt::exception() << "bad device '" << value << "'";
+      }
+      opts.device = value == "sim" ? VTPC_DEVICE_SIM : VTPC_DEVICE_POSIX;
+    } else if (key == "--dir") {
+      opts.dir = value;
+    } else {
+      throw vt::exception()
+          << "unknown option '" << key
+          << "'; usage: test_fuzz [--first N] [--seeds N] [--steps N] "
+             "[--workers N] [--cache-pages N] [--file-pages N] "
+             "[--device sim|posix] [--dir PATH]";
+    }
+  }
+  if (opts.dir.empty()) {
+    opts.dir = opts.device == VTPC_DEVICE_SIM ? "/dev/shm" : "/tmp";
+  }
+  if (opts.workers == 0 || opts.cache_pages == 0) {
+    throw vt::exception() << "bad options";
+  }
+  opts.workers = std::min(opts.workers, std::max<size_t>(opts.seeds, 1));
+  return opts;
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) -> int try {
+  const options opts = parse(argc, argv);
+
+  // Текущие сиды процессов лежат в общей памяти: упавший процесс не успеет
+  // сообщить свой сид сам.
+  void* shared = mmap(
+      nullptr, opts.workers * sizeof(uint64_t), PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_ANONYMOUS, -1, 0
+  );
+  check(shared != MAP_FAILED, "mmap");  // NOLINT
+  auto* current = static_cast<volatile uint64_t*>(shared);
+
+  // vtpc запускает фоновые потоки, поэтому процессы порождаются до первого
+  // обращения к кэшу, и каждый настраивает его сам.
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<pid_t> children;
+  for (size_t worker = 0; worker < opts.workers; ++worker) {
+    const pid_t pid = fork();
+    check(pid >= 0, "fork");
+    if (pid == 0) {
+      try {
+        _exit(fuzz(opts, worker, current[worker]) == 0 ? 0 : 1);  // NOLINT
+      } catch (const std::exception& e) {
+        std::cerr << "worker " << worker << ": " << e.what() << '\n';
+        _exit(2);
+      }
+    }
+    children.push_back(pid);
+  }
+
+  size_t failed = 0;
+  for (size_t worker = 0; worker < children.size(); ++worker) {
+    int status = 0;
+    check(waitpid(children[worker], &status, 0) == children[worker], "waitpid");
+    if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+      continue;
+    }
+    ++failed;
+    if (WIFEXITED(status) && WEXITSTATUS(status) == 1) {
+      continue;  // расхождения уже напечатаны вместе с сидами
+    }
+    const uint64_t seed = current[worker];  // NOLINT
+    std::cerr << "worker " << worker << " died on seed " << seed << " ("
+              << (WIFSIGNALED(status) ? "signal " : "exit code ")
+              << (WIFSIGNALED(status) ? WTERMSIG(status) : WEXITSTATUS(status))
+              << "), rerun with --first " << seed << " --seeds 1 --workers 1\n";
+  }
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  munmap(shared, opts.workers * sizeof(uint64_t));
+
+  const double ops = static_cast<double>(opts.seeds * opts.steps);
+  std::cout << "fuzz: " << opts.seeds << " seeds x " << opts.steps
+            << " ops in " << opts.workers << " workers, " << failed
+            << " workers failed";
+  if (failed == 0) {
+    // Упавший процесс не прогнал свои сиды, и скорость была бы завышена.
+    std::cout << ", " << ops / elapsed.count() << " ops/s";
+  }
+  std::cout << '\n';
+  return failed == 0 ? 0 : 1;
+} catch (const std::exception& e) {
+  std::cerr << "exception: " << e.what() << '\n';
+  return 1;
+}
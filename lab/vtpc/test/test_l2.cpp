@@ -0,0 +1,91 @@
+#include <sys/types.h>
+
+#include <cstddef>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+
+#include "check.hpp"
+#include "cmp_file.hpp"
+#include "exception.hpp"
+#include "file.hpp"
+
+extern "C" {
+#include "vtpc.h"
+}
+
+namespace {
+
+using vt::check;
+
+constexpr size_t seed = 1;
+constexpr size_t cache_pages = 16;
+constexpr size_t l2_pages = 256;
+constexpr size_t steps = (1U << 14U);
+constexpr size_t size = 64 * VTPC_PAGE_SIZE;
+
+auto stats() -> struct vtpc_stats {
+  struct vtpc_stats stats{};
+  check(vtpc_stats(&stats) == 0, "vtpc_stats");
+  return stats;
+}
+
+}  // namespace
+
+auto main() -> int try {
+  const struct vtpc_config config = {
+      .cache_pages = cache_pages,
+      .readahead_pages = 0,
+      .l2_path = "/tmp/vtpc_l2",
+      .l2_pages = l2_pages,
+  };
+  check(vtpc_configure(&config) == 0, "vtpc_configure");
+
+  std::filesystem::remove("/tmp/l2_a");
+  std::filesystem::remove("/tmp/l2_b");
+  auto libc = vt::file::open_libc("/tmp/l2_a");
+  auto vtpc = vt::file::open_vtpc("/tmp/l2_b");
+  vt::cmp_file file(std::move(libc), std::move(vtpc));
+
+  std::default_random_engine random(seed);  // NOLINT
+  std::uniform_int_distribution<size_t> action_dist(0, 100);  // NOLINT
+  std::uniform_int_distribution<off_t> offset_dist(0, size);
+  std::uniform_int_distribution<size_t> batch_dist(0, size / 16);  // NOLINT
+
+  file.seek(0);
+  file.write(std::string(size, ' '));
+
+  for (size_t i = 0; i < steps; ++i) {
+    try {
+      const size_t point = action_dist(random);
+      if (point < 60) {  // NOLINT
+        file.read(batch_dist(random));
+      } else if (point < 75) {  // NOLINT
+        const size_t batch = batch_dist(random);
+        file.write(std::string(batch, static_cast<char>('a' + i % 26)));
+      } else if (point < 99) {  // NOLINT
+        file.seek(offset_dist(random));
+      } else {
+        file.sync();
+      }
+    } catch (vt::file_exception& e) {  // NOLINT
+      // Do nothing
+    }
+  }
+
+  const struct vtpc_stats after = stats();
+  std::cout << "l2: " << after.l2_hits << " hits, " << after.l2_misses
+            << " misses, " << after.l2_writes << " writes, "
+            << after.l2_used_pages << " pages\n";
+  if (after.l2_writes == 0 || after.l2_hits == 0) {
+    throw vt::exception() << "second-level cache was never used";
+  }
+
+  return 0;
+} catch (const std::exception& e) {
+  std::cerr << "exception: " << e.what() << '\n';
+  return 1;
+}
@@ -0,0 +1,79 @@
+#include <sys/types.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <exception>
+#include <iostream>
+
+#include "check.hpp"
+#include "pages.hpp"
+
+extern "C" {
+#include "vtpc.h"
+}
+
+namespace {
+
+using vt::check;
+using vt::expect;
+using vt::open_filled;
+using vt::read_all;
+
+constexpr size_t cache_pages = 64;
+constexpr size_t locked_cap = 16;
+constexpr size_t header_pages = 8;
+constexpr size_t scan_pages = 256;
+
+auto stats() -> struct vtpc_stats {
+  struct vtpc_stats stats{};
+  check(vtpc_stats(&stats) == 0, "vtpc_stats");
+  return stats;
+}
+
+}  // namespace
+
+auto main() -> int try {
+  const struct vtpc_config config = {
+      .cache_pages = cache_pages,
+      .readahead_pages = 0,
+      .locked_pages = locked_cap,
+  };
+  check(vtpc_configure(&config) == 0, "vtpc_configure");
+
+  const int header_fd = open_filled("/tmp/vtpc_header", header_pages);
+  const int scan_fd = open_filled("/tmp/vtpc_scan", scan_pages);
+
+  check(vtpc_fadvise(header_fd, 0, 0, VTPC_FADV_DONTNEED) == 0, "DONTNEED");
+  check(vtpc_lock_range(header_fd, 0, 0) == 0, "vtpc_lock_range");
+  expect(stats().locked_pages == header_pages, "header is not locked");
+
+  check(vtpc_fadvise(header_fd, 0, 0, VTPC_FADV_DONTNEED) == 0, "DONTNEED");
+  read_all(scan_fd, scan_pages);
+  read_all(scan_fd, scan_pages);
+
+  const struct vtpc_stats before = stats();
+  read_all(header_fd, header_pages);
+  expect(stats().misses == before.misses, "locked header pages were evicted");
+
+  const auto scan_bytes = static_cast<off_t>(scan_pages * VTPC_PAGE_SIZE);
+  expect(
+      vtpc_lock_range(scan_fd, 0, scan_bytes) == -1 && errno == ENOMEM,
+      "lock over the cap succeeded"
+  );
+  expect(
+      stats().locked_pages == header_pages, "failed lock changed locked pages"
+  );
+
+  check(vtpc_lock_range(header_fd, 0, VTPC_PAGE_SIZE) == 0, "vtpc_lock_range");
+  check(vtpc_unlock_range(header_fd, 0, 0) == 0, "vtpc_unlock_range");
+  expect(stats().locked_pages == 1, "nested lock was lost");
+  check(vtpc_unlock_range(header_fd, 0, 0) == 0, "vtpc_unlock_range");
+  expect(stats().locked_pages == 0, "pages stayed locked");
+
+  check(vtpc_close(header_fd) == 0, "vtpc_close");
+  check(vtpc_close(scan_fd) == 0, "vtpc_close");
+  return 0;
+} catch (const std::exception& e) {
+  std::cerr << "exception: " << e.what() << '\n';
+  return 1;
+}
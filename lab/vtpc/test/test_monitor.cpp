@@ -0,0 +1,109 @@
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "check.hpp"
+
+extern "C" {
+#include <fcntl.h>
+
+#include "vtpc.h"
+}
+
+namespace {
+
+using vt::check;
+using vt::expect;
+
+constexpr size_t cache_pages = 32;
+constexpr size_t file_pages = 128;
+constexpr auto interval =
+    std::chrono::milliseconds(2 * VTPC_MONITOR_INTERVAL_MS);
+
+auto read_page(int fd, off_t index) -> void {
+  std::string page(VTPC_PAGE_SIZE, '\0');
+  check(
+      vtpc_lseek(fd, index * VTPC_PAGE_SIZE, SEEK_SET) >= 0, "vtpc_lseek"
+  );
+  check(vtpc_read(fd, page.data(), page.size()) >= 0, "vtpc_read");
+}
+
+}  // namespace
+
+auto main() -> int try {
+  const struct vtpc_config config = {
+      .cache_pages = cache_pages,
+      .readahead_pages = 0,
+      .monitor = 1,
+  };
+  check(vtpc_configure(&config) == 0, "vtpc_configure");
+
+  struct vtpc_monitor monitor{};
+  expect(
+      vtpc_monitor_read(getpid(), &monitor) != 0 && errno == ENOENT,
+      "snapshot published before the cache was used"
+  );
+
+  const int fd = vtpc_open(
+      "/tmp/monitor", O_RDWR | O_CREAT | O_TRUNC, 0644  // NOLINT
+  );
+  check(fd >= 0, "vtpc_open");
+  const std::string page(VTPC_PAGE_SIZE, 'm');
+  for (size_t i = 0; i < file_pages; ++i) {
+    check(vtpc_write(fd, page.data(), page.size()) >= 0, "vtpc_write");
+  }
+  check(vtpc_fsync(fd) == 0, "vtpc_fsync");
+  for (size_t i = 0; i < file_pages; ++i) {
+    read_page(fd, static_cast<off_t>(i));
+  }
+
+  // Снимок публикуется на следующем вызове API после интервала.
+  std::this_thread::sleep_for(interval);
+  read_page(fd, 0);
+
+  check(vtpc_monitor_read(getpid(), &monitor) == 0, "vtpc_monitor_read");
+  struct vtpc_stats stats{};
+  check(vtpc_stats(&stats) == 0, "vtpc_stats");
+
+  uint64_t latency_count = 0;
+  for (const uint64_t bucket : monitor.miss_latency) {
+    latency_count += bucket;
+  }
+  std::cout << "monitor: " << monitor.stats.hits << " hits, "
+            << monitor.stats.misses << " misses, " << monitor.miss_ns
+            << " ns in misses, " << monitor.stats.writebacks
+            << " writebacks\n";
+
+  expect(monitor.pid == getpid(), "snapshot has a foreign pid");
+  expect(monitor.capacity == cache_pages, "snapshot has a wrong capacity");
+  expect(
+      monitor.stats.hits == stats.hits && monitor.stats.misses == stats.misses,
+      "snapshot does not match vtpc_stats"
+  );
+  expect(monitor.stats.writebacks == stats.writebacks, "writebacks differ");
+  expect(
+      monitor.stats.misses > 0 && latency_count > 0 &&
+          latency_count <= monitor.stats.misses,
+      "miss latency histogram is empty"
+  );
+  expect(monitor.partition_count >= 1, "default partition is missing");
+  expect(
+      std::string_view(monitor.partitions[0].name) == "default",
+      "default partition has a wrong name"
+  );
+
+  check(vtpc_close(fd) == 0, "vtpc_close");
+  return 0;
+} catch (const std::exception& e) {
+  std::cerr << "exception: " << e.what() << '\n';
+  return 1;
+}
@@ -0,0 +1,78 @@
+#include <sys/types.h>
+
+#include <cstddef>
+#include <exception>
+#include <iostream>
+
+#include "check.hpp"
+#include "exception.hpp"
+#include "pages.hpp"
+
+extern "C" {
+#include "vtpc.h"
+}
+
+namespace {
+
+using vt::check;
+using vt::open_filled;
+using vt::read_all;
+
+constexpr size_t cache_pages = 64;
+constexpr size_t index_pages = 16;
+constexpr size_t scan_pages = 256;
+constexpr size_t scan_cap = 32;
+
+auto stats_of(int partition) -> struct vtpc_partition_stats {
+  struct vtpc_partition_stats stats{};
+  check(vtpc_partition_stats(partition, &stats) == 0, "vtpc_partition_stats");
+  return stats;
+}
+
+}  // namespace
+
+auto main() -> int try {
+  const vtpc_config config = {.cache_pages = cache_pages};
+  check(vtpc_configure(&config) == 0, "vtpc_configure");
+
+  const int index = vtpc_partition_create("index", index_pages, index_pages);
+  check(index >= 0, "vtpc_partition_create(index)");
+  const int scan = vtpc_partition_create("scan", 0, scan_cap);
+  check(scan >= 0, "vtpc_partition_create(scan)");
+  check(vtpc_partition_find("scan") == scan, "vtpc_partition_find");
+
+  const int index_fd = open_filled("/tmp/vtpc_index", index_pages);
+  const int scan_fd = open_filled("/tmp/vtpc_scan", scan_pages);
+  check(vtpc_set_partition(index_fd, index) == 0, "vtpc_set_partition");
+  check(vtpc_set_partition(scan_fd, scan) == 0, "vtpc_set_partition");
+
+  read_all(index_fd, index_pages);
+  const struct vtpc_partition_stats warm = stats_of(index);
+
+  read_all(scan_fd, scan_pages);
+  read_all(scan_fd, scan_pages);
+
+  read_all(index_fd, index_pages);
+  const struct vtpc_partition_stats hot = stats_of(index);
+  if (hot.misses != warm.misses) {
+    throw vt::exception() << "index pages were evicted by the scan: "
+                          << hot.misses - warm.misses << " new misses";
+  }
+
+  const struct vtpc_partition_stats cold = stats_of(scan);
+  if (cold.used_pages > scan_cap) {
+    throw vt::exception() << "scan partition holds " << cold.used_pages
+                          << " pages over its cap of " << scan_cap;
+  }
+
+  std::cout << "index: hits " << hot.hits << ", misses " << hot.misses << '\n'
+            << "scan: hits " << cold.hits << ", misses " << cold.misses
+            << ", evictions " << cold.evictions << '\n';
+
+  check(vtpc_close(index_fd) == 0, "vtpc_close");
+  check(vtpc_close(scan_fd) == 0, "vtpc_close");
+  return 0;
+} catch (const std::exception& e) {
+  std::cerr << "exception: " << e.what() << '\n';
+  return 1;
+}
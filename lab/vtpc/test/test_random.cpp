@@ -23,7 +23,8 @@ auto main() -> int try {
     auto libc = vt::file::open_libc("/tmp/a");
     auto vtpc = vt::file::open_vtpc("/tmp/b");
     auto cmp = std::make_unique<vt::cmp_file>(std::move(libc), std::move(vtpc));
-    auto log = std::make_unique<vt::log_file>(std::move(cmp));
+    auto log =
+        std::make_unique<vt::log_file>(std::move(cmp), "/tmp/random.trace");
     return log;
   }();
 
@@ -0,0 +1,186 @@
+#include <sys/types.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "check.hpp"
+#include "cmp_file.hpp"
+#include "exception.hpp"
+#include "file.hpp"
+
+extern "C" {
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "vtpc.h"
+}
+
+namespace {
+
+using vt::check;
+
+constexpr size_t seed = 1;
+constexpr size_t cache_pages = 64;
+constexpr size_t reclaim_low = 8;
+constexpr size_t reclaim_high = 16;
+constexpr size_t steps = (1U << 14U);
+constexpr size_t size = 256 * VTPC_PAGE_SIZE;
+constexpr auto wait_limit = std::chrono::seconds(5);
+
+auto stats() -> struct vtpc_stats {
+  struct vtpc_stats stats{};
+  check(vtpc_stats(&stats) == 0, "vtpc_stats");
+  return stats;
+}
+
+auto configure(size_t high) -> void {
+  const struct vtpc_config config = {
+      .cache_pages = cache_pages,
+      .readahead_pages = 0,
+      .reclaim_low = high == 0 ? 0 : reclaim_low,
+      .reclaim_high = high,
+  };
+  check(vtpc_configure(&config) == 0, "vtpc_configure");
+}
+
+auto open_pair(const char* libc_path, const char* vtpc_path) -> vt::cmp_file {
+  std::filesystem::remove(libc_path);
+  std::filesystem::remove(vtpc_path);
+  return {vt::file::open_libc(libc_path), vt::file::open_vtpc(vtpc_path)};
+}
+
+// workload — смесь чтений и записей поверх vtpc, сверяемая с libc; возвращает
+// p99 задержки чтения.
+auto workload(vt::cmp_file& file) -> std::chrono::nanoseconds {
+  std::default_random_engine random(seed);  // NOLINT
+  std::uniform_int_distribution<size_t> action_dist(0, 100);  // NOLINT
+  std::uniform_int_distribution<off_t> offset_dist(0, size);
+  std::uniform_int_distribution<size_t> batch_dist(0, size / 64);  // NOLINT
+
+  file.seek(0);
+  file.write(std::string(size, ' '));
+
+  std::vector<std::chrono::nanoseconds> reads;
+  for (size_t i = 0; i < steps; ++i) {
+    try {
+      const size_t point = action_dist(random);
+      if (point < 50) {  // NOLINT
+        const size_t batch = batch_dist(random);
+        const auto start = std::chrono::steady_clock::now();
+        file.read(batch);
+        reads.emplace_back(std::chrono::steady_clock::now() - start);
+      } else if (point < 90) {  // NOLINT
+        const size_t batch = batch_dist(random);
+        file.write(std::string(batch, static_cast<char>('a' + i % 26)));
+      } else {
+        file.seek(offset_dist(random));
+      }
+    } catch (vt::file_exception& e) {  // NOLINT
+      // Do nothing
+    }
+    // На одном ядре фоновый поток иначе получает процессор только по
+    // истечении кванта, и резерв пустеет быстрее, чем он его пополняет.
+    std::this_thread::yield();
+  }
+
+  std::sort(reads.begin(), reads.end());
+  return reads[reads.size() * 99 / 100];  // NOLINT
+}
+
+// p99_without_reclaim — p99 той же нагрузки без фонового освобождения.
+// vtpc настраивается один раз за процесс, поэтому замер идёт в дочернем
+// процессе, порождённом до первого обращения к кэшу.
+auto p99_without_reclaim() -> std::chrono::nanoseconds {
+  void* shared = mmap(
+      nullptr, sizeof(int64_t), PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_ANONYMOUS, -1, 0
+  );
+  check(shared != MAP_FAILED, "mmap");  // NOLINT
+  auto* result = static_cast<int64_t*>(shared);
+
+  const pid_t pid = fork();
+  check(pid >= 0, "fork");
+  if (pid == 0) {
+    try {
+      configure(0);
+      auto file = open_pair("/tmp/reclaim_off_a", "/tmp/reclaim_off_b");
+      *result = workload(file).count();
+      _exit(0);  // NOLINT
+    } catch (const std::exception& e) {
+      std::cerr << "without reclaim: " << e.what() << '\n';
+      _exit(1);  // NOLINT
+    }
+  }
+
+  int status = 0;
+  check(waitpid(pid, &status, 0) == pid, "waitpid");
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    throw vt::exception() << "run without reclaim failed";
+  }
+  const std::chrono::nanoseconds p99(*result);
+  munmap(shared, sizeof(int64_t));
+  return p99;
+}
+
+}  // namespace
+
+auto main() -> int try {
+  const auto p99_off = p99_without_reclaim();
+  configure(reclaim_high);
+  auto file = open_pair("/tmp/reclaim_a", "/tmp/reclaim_b");
+  const auto p99 = workload(file);
+
+  const auto deadline = std::chrono::steady_clock::now() + wait_limit;
+  while (stats().free_pages <= reclaim_low) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      throw vt::exception() << "free reserve was not refilled: "
+                            << stats().free_pages << " free pages";
+    }
+    std::this_thread::yield();
+  }
+
+  const struct vtpc_stats after = stats();
+  if (after.reclaimed_pages == 0) {
+    throw vt::exception() << "background reclaim never ran";
+  }
+  // Промахи вытесняют сами, только когда резерв исчерпан, — это должно быть
+  // исключением, а основную работу делает фоновый поток.
+  const uint64_t direct = after.evictions - after.reclaimed_pages;
+  if (direct * 3 >= after.evictions) {
+    throw vt::exception() << "background reclaim did only "
+                          << after.reclaimed_pages << " of "
+                          << after.evictions << " evictions, " << direct
+                          << " were done on the miss path";
+  }
+  // Без фонового освобождения промах сам сбрасывает грязную жертву, поэтому
+  // с ним хвост задержек чтения должен быть не хуже; запас — на шум.
+  if (p99 * 2 > p99_off * 3) {
+    throw vt::exception() << "reclaim made p99 read latency worse: "
+                          << p99.count() << " ns vs " << p99_off.count()
+                          << " ns without it";
+  }
+
+  using std::chrono::microseconds;
+  std::cout << "reclaimed " << after.reclaimed_pages << " of "
+            << after.evictions << " evictions (" << direct
+            << " on the miss path), p99 read "
+            << std::chrono::duration_cast<microseconds>(p99).count()
+            << " us, without reclaim "
+            << std::chrono::duration_cast<microseconds>(p99_off).count()
+            << " us\n";
+  return 0;
+} catch (const std::exception& e) {
+  std::cerr << "exception: " << e.what() << '\n';
+  return 1;
+}
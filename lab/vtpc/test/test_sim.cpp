@@ -0,0 +1,246 @@
+#include <sys/types.h>
+
+#include <barrier>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "check.hpp"
+#include "cmp_file.hpp"
+#include "exception.hpp"
+#include "file.hpp"
+
+extern "C" {
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "vtpc.h"
+}
+
+namespace {
+
+using vt::check;
+
+constexpr size_t cache_pages = 16;
+constexpr size_t steps = (1U << 13U);
+constexpr size_t size = 64 * VTPC_PAGE_SIZE;
+constexpr size_t queue_threads = 4;
+constexpr size_t queue_pages = 64;
+
+// Модель диска: задержка, позиционирование и полоса одного HDD.
+auto disk_config(unsigned queue_depth) -> struct vtpc_config {
+  return {
+      .cache_pages = cache_pages,
+      .readahead_pages = 0,
+      .device = VTPC_DEVICE_SIM,
+      .sim =
+          {
+              .clock = VTPC_SIM_CLOCK_VIRTUAL,
+              .latency_ns = 100'000,
+              .seek_min_ns = 500'000,
+              .seek_max_ns = 8'000'000,
+              .seek_span = 1U << 30U,
+              .bandwidth = 150U << 20U,
+              .queue_depth = queue_depth,
+          },
+  };
+}
+
+auto configure(unsigned queue_depth) -> void {
+  const struct vtpc_config config = disk_config(queue_depth);
+  check(vtpc_configure(&config) == 0, "vtpc_configure");
+}
+
+auto device_stats() -> struct vtpc_sim_stats {
+  struct vtpc_sim_stats stats{};
+  check(vtpc_sim_stats(&stats) == 0, "vtpc_sim_stats");
+  return stats;
+}
+
+auto run(const char* libc_path, const char* sim_path, size_t seed)
+    -> struct vtpc_sim_stats {
+  std::filesystem::remove(libc_path);
+  const struct vtpc_sim_stats before = device_stats();
+  size_t bytes = 0;
+  {
+    auto libc = vt::file::open_libc(libc_path);
+    auto vtpc = vt::file::open_vtpc(sim_path);
+    vt::cmp_file file(std::move(libc), std::move(vtpc));
+
+    std::default_random_engine random(seed);  // NOLINT
+    std::uniform_int_distribution<size_t> action_dist(0, 100);  // NOLINT
+    std::uniform_int_distribution<off_t> offset_dist(0, size);
+    std::uniform_int_distribution<size_t> batch_dist(0, size / 16);  // NOLINT
+
+    file.seek(0);
+    file.write(std::string(size, ' '));
+
+    for (size_t i = 0; i < steps; ++i) {
+      try {
+        const size_t point = action_dist(random);
+        if (point < 50) {  // NOLINT
+          const size_t batch = batch_dist(random);
+          file.read(batch);
+          bytes += batch;
+        } else if (point < 75) {  // NOLINT
+          const size_t batch = batch_dist(random);
+          file.write(std::string(batch, static_cast<char>('a' + i % 26)));
+          bytes += batch;
+        } else if (point < 99) {  // NOLINT
+          file.seek(offset_dist(random));
+        } else {
+          file.sync();
+        }
+      } catch (vt::file_exception& e) {  // NOLINT
+        // Do nothing
+      }
+    }
+  }
+  const struct vtpc_sim_stats after = device_stats();
+
+  struct vtpc_sim_stats delta = after;
+  delta.reads -= before.reads;
+  delta.writes -= before.writes;
+  delta.bytes_read -= before.bytes_read;
+  delta.bytes_written -= before.bytes_written;
+  delta.busy_ns -= before.busy_ns;
+  delta.latency_ns -= before.latency_ns;
+  delta.clock_ns -= before.clock_ns;
+
+  const double seconds = static_cast<double>(delta.clock_ns) / 1e9;  // NOLINT
+  const uint64_t ios = delta.reads + delta.writes;
+  std::cout << sim_path << ": " << ios << " device I/Os, " << seconds
+            << " s device time, "
+            << static_cast<double>(bytes) / seconds / (1U << 20U)
+            << " MiB/s, avg latency "
+            << (ios ? delta.latency_ns / ios : 0) << " ns\n";
+  return delta;
+}
+
+// queue_reads — потоки по очереди, шаг за шагом, читают каждый свой файл, так
+// что на каждом шаге у устройства queue_threads запросов. Возвращает время
+// устройства на чтение.
+auto queue_reads() -> uint64_t {
+  const std::string page(VTPC_PAGE_SIZE, 'q');
+  std::vector<int> fds;
+  for (size_t t = 0; t < queue_threads; ++t) {
+    const std::string path = "/sim/queue" + std::to_string(t);
+    const int fd = vtpc_open(path.c_str(), O_CREAT | O_RDWR, 0);
+    check(fd >= 0, "vtpc_open");
+    for (size_t i = 0; i < queue_pages; ++i) {
+      check(
+          vtpc_write(fd, page.data(), page.size()) == VTPC_PAGE_SIZE,
+          "vtpc_write"
+      );
+    }
+    check(vtpc_fsync(fd) == 0, "vtpc_fsync");
+    fds.push_back(fd);
+  }
+
+  const uint64_t before = device_stats().clock_ns;
+  std::barrier step(static_cast<std::ptrdiff_t>(queue_threads));
+  std::vector<std::thread> threads;
+  for (const int fd : fds) {
+    threads.emplace_back([fd, &step] {
+      char buf[VTPC_PAGE_SIZE];
+      for (size_t i = 0; i < queue_pages; ++i) {
+        vtpc_lseek(fd, static_cast<off_t>(i * VTPC_PAGE_SIZE), SEEK_SET);
+        (void)vtpc_read(fd, buf, sizeof(buf));
+        step.arrive_and_wait();
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  for (const int fd : fds) {
+    vtpc_close(fd);
+  }
+  return device_stats().clock_ns - before;
+}
+
+// queue_time — время queue_reads при глубине очереди queue_depth. vtpc
+// настраивается один раз за процесс, поэтому замер идёт в дочернем процессе,
+// порождённом до первого обращения к кэшу.
+auto queue_time(unsigned queue_depth) -> uint64_t {
+  void* shared = mmap(
+      nullptr, sizeof(uint64_t), PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_ANONYMOUS, -1, 0
+  );
+  check(shared != MAP_FAILED, "mmap");  // NOLINT
+  auto* result = static_cast<uint64_t*>(shared);
+
+  const pid_t pid = fork();
+  check(pid >= 0, "fork");
+  if (pid == 0) {
+    try {
+      configure(queue_depth);
+      *result = queue_reads();
+      _exit(0);  // NOLINT
+    } catch (const std::exception& e) {
+      std::cerr << "queue depth " << queue_depth << ": " << e.what() << '\n';
+      _exit(1);  // NOLINT
+    }
+  }
+
+  int status = 0;
+  if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) ||
+      WEXITSTATUS(status) != 0) {
+    throw vt::exception() << "queue depth " << queue_depth << " run failed";
+  }
+  const uint64_t time = *result;
+  munmap(shared, sizeof(uint64_t));
+  return time;
+}
+
+}  // namespace
+
+auto main() -> int try {
+  // Запросы разных потоков обслуживаются параллельно, если позволяет очередь.
+  const uint64_t serial = queue_time(1);
+  const uint64_t parallel = queue_time(queue_threads);
+  std::cout << "queue depth 1: " << static_cast<double>(serial) / 1e9  // NOLINT
+            << " s, queue depth " << queue_threads << ": "
+            << static_cast<double>(parallel) / 1e9  // NOLINT
+            << " s device time\n";
+  if (parallel * 2 > serial) {
+    throw vt::exception() << "queue depth does not speed up parallel reads";
+  }
+
+  configure(1);
+
+  const struct vtpc_sim_stats first = run("/tmp/sim_a", "/sim/a", 1);
+  const struct vtpc_sim_stats second = run("/tmp/sim_b", "/sim/b", 1);
+  if (first.reads != second.reads || first.writes != second.writes ||
+      first.busy_ns != second.busy_ns || first.clock_ns != second.clock_ns) {
+    throw vt::exception() << "identical runs produced different device timings";
+  }
+
+  // Кэш открывает файл заново по абсолютному пути, а симулятор должен узнать
+  // в нём файл, открытый по относительному.
+  check(chdir("/") == 0, "chdir");
+  {
+    auto relative = vt::file::open_vtpc("sim/./c/../c");
+    relative->write("relative");
+    relative->sync();
+  }
+  auto absolute = vt::file::open_vtpc("/sim/c");
+  if (absolute->read(8) != "relative") {  // NOLINT
+    throw vt::exception() << "relative and absolute paths differ";
+  }
+
+  return 0;
+} catch (const std::exception& e) {
+  std::cerr << "exception: " << e.what() << '\n';
+  return 1;
+}
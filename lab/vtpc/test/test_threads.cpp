@@ -0,0 +1,399 @@
+#include <sys/types.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "check.hpp"
+#include "exception.hpp"
+
+extern "C" {
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "vtpc.h"
+}
+
+// test_threads — масштабируемость и стресс vtpc под несколькими потоками.
+// Для каждого числа потоков от 1 до --threads потоки в течение --duration-ms
+// читают и пишут блоки своего личного файла и общих файлов. В общих файлах
+// блок принадлежит потоку с номером block % threads: писать его может только
+// владелец, а читать — любой, поэтому несколько потоков делят одну страницу.
+// Каждая запись заполняет блок записями {номер блока, версия}, и с --verify
+// любое чтение проверяет, что блок не разорван и версия не из будущего, а в
+// конце файлы сверяются с моделью — сначала через vtpc, потом после закрытия
+// через libc.
+
+namespace {
+
+using vt::check;
+
+constexpr size_t record_size = 2 * sizeof(uint64_t);
+constexpr double percent = 100.0;
+constexpr double p99 = 0.99;
+constexpr double p999 = 0.999;
+
+struct options {
+  size_t threads = std::max(1U, std::thread::hardware_concurrency());
+  size_t duration_ms = 500;
+  size_t read_ratio = 70;  // NOLINT
+  size_t shared_files = 2;
+  size_t file_blocks = 512;
+  size_t block = 1024;
+  size_t cache_pages = 256;
+  uint64_t seed = 1;
+  bool verify = false;
+  std::string dir = "/tmp";
+};
+
+// target — файл нагрузки и модель его содержимого: последние записанные
+// версии блоков. Версию блока меняет только его владелец, а другие потоки
+// читают её лишь для сравнения с прочитанной.
+struct target {
+  std::string path;
+  bool shared;
+  std::vector<std::atomic<uint64_t>> versions;
+
+  target(std::string path, bool shared, size_t blocks)
+      : path(std::move(path)), shared(shared), versions(blocks) {
+  }
+};
+
+struct thread_result {
+  uint64_t ops = 0;
+  std::vector<uint64_t> latency_ns;
+};
+
+auto fill_block(std::string& buf, uint64_t block, uint64_t version) -> void {
+  for (size_t pos = 0; pos + record_size <= buf.size(); pos += record_size) {
+    std::memcpy(buf.data() + pos, &block, sizeof(block));
+    std::memcpy(buf.data() + pos + sizeof(block), &version, sizeof(version));
+  }
+}
+
+// block_version — версия целого блока или исключение, если блок разорван.
+auto block_version(const std::string& buf, uint64_t block) -> uint64_t {
+  uint64_t version = 0;
+  for (size_t pos = 0; pos + record_size <= buf.size(); pos += record_size) {
+    uint64_t got_block = 0;
+    uint64_t got_version = 0;
+    std::memcpy(&got_block, buf.data() + pos, sizeof(got_block));
+    std::memcpy(
+        &got_version, buf.data() + pos + sizeof(block), sizeof(version)
+    );
+    if (got_block != block || (pos > 0 && got_version != version)) {
+      throw vt::exception() << "block " << block << " is torn at byte " << pos;
+    }
+    version = got_version;
+  }
+  return version;
+}
+
+auto block_io(
+    ssize_t (*io)(int, void*, size_t),
+    int fd,
+    std::string& buf,
+    const options& opts,
+    size_t block
+) -> void {
+  const auto offset = static_cast<off_t>(block * opts.block);
+  check(vtpc_lseek(fd, offset, SEEK_SET) == offset, "vtpc_lseek");
+  check(
+      io(fd, buf.data(), buf.size()) == static_cast<ssize_t>(buf.size()),
+      "vtpc_read/vtpc_write"
+  );
+}
+
+auto write_io(int fd, void* buf, size_t count) -> ssize_t {
+  return vtpc_write(fd, buf, count);
+}
+
+auto worker(
+    const options& opts,
+    size_t threads,
+    size_t id,
+    std::vector<target>& targets,
+    const std::atomic<bool>& stop,
+    thread_result& res
+) -> void {
+  std::vector<int> fds;
+  for (const target& file : targets) {
+    const int fd = vtpc_open(file.path.c_str(), O_RDWR, 0);
+    check(fd >= 0, "vtpc_open");
+    fds.push_back(fd);
+  }
+
+  std::mt19937_64 random(opts.seed * threads + id);
+  std::uniform_int_distribution<size_t> ratio_dist(0, 99);  // NOLINT
+  std::uniform_int_distribution<size_t> file_dist(0, opts.shared_files);
+  std::uniform_int_distribution<size_t> block_dist(0, opts.file_blocks - 1);
+  std::string buf(opts.block, '\0');
+
+  while (!stop.load(std::memory_order_relaxed)) {
+    // Номер 0 — личный файл потока, остальные — общие.
+    const size_t pick = file_dist(random);
+    const size_t index = pick == 0 ? opts.shared_files + id : pick - 1;
+    target& file = targets[index];
+    const int fd = fds[index];
+    const size_t block = block_dist(random);
+    const bool owned = !file.shared || block % threads == id;
+    const bool write = owned && ratio_dist(random) >= opts.read_ratio;
+
+    const auto start = std::chrono::steady_clock::now();
+    if (write) {
+      const uint64_t version =
+          file.versions[block].load(std::memory_order_relaxed) + 1;
+      fill_block(buf, block, version);
+      block_io(write_io, fd, buf, opts, block);
+      file.versions[block].store(version, std::memory_order_release);
+    } else {
+      const uint64_t before =
+          file.versions[block].load(std::memory_order_acquire);
+      block_io(vtpc_read, fd, buf, opts, block);
+      if (opts.verify) {
+        const uint64_t version = block_version(buf, block);
+        const uint64_t after =
+            file.versions[block].load(std::memory_order_acquire);
+        if (version < before || version > after + 1 ||
+            (owned && version != after)) {
+          throw vt::exception()
+              << file.path << " block " << block << ": read version "
+              << version << ", model " << before << ".." << after;
+        }
+      }
+    }
+    const auto end = std::chrono::steady_clock::now();
+    res.latency_ns.push_back(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+            .count()
+    ));
+    ++res.ops;
+  }
+
+  for (const int fd : fds) {
+    check(vtpc_close(fd) == 0, "vtpc_close");
+  }
+}
+
+// verify_files — сверяет каждый блок с моделью через функцию чтения read.
+template <typename Read>
+auto verify_files(const options& opts, std::vector<target>& targets, Read read)
+    -> void {
+  std::string buf(opts.block, '\0');
+  for (target& file : targets) {
+    for (size_t block = 0; block < opts.file_blocks; ++block) {
+      read(file, block, buf);
+      const uint64_t expected = file.versions[block].load();
+      const uint64_t version = block_version(buf, block);
+      if (version != expected) {
+        throw vt::exception() << file.path << " block " << block
+                              << ": version " << version << " instead of "
+                              << expected;
+      }
+    }
+  }
+}
+
+auto run(const options& opts, size_t threads) -> void {
+  std::vector<target> targets;
+  targets.reserve(opts.shared_files + threads);
+  for (size_t i = 0; i < opts.shared_files; ++i) {
+    targets.emplace_back(
+        opts.dir + "/threads_shared_" + std::to_string(i),
+        true,
+        opts.file_blocks
+    );
+  }
+  for (size_t i = 0; i < threads; ++i) {
+    targets.emplace_back(
+        opts.dir + "/threads_private_" + std::to_string(i),
+        false,
+        opts.file_blocks
+    );
+  }
+
+  // Исходное содержимое — версия 0 каждого блока. Хэндл держится открытым до
+  // конца прогона, чтобы страницы файла пережили потоки.
+  std::vector<int> keep;
+  std::string buf(opts.block, '\0');
+  for (const target& file : targets) {
+    const int flags = O_RDWR | O_CREAT | O_TRUNC;
+    const int fd = vtpc_open(file.path.c_str(), flags, 0644);  // NOLINT
+    check(fd >= 0, "vtpc_open");
+    for (size_t block = 0; block < opts.file_blocks; ++block) {
+      fill_block(buf, block, 0);
+      block_io(write_io, fd, buf, opts, block);
+    }
+    keep.push_back(fd);
+  }
+
+  std::atomic<bool> stop{false};
+  std::vector<thread_result> results(threads);
+  std::vector<std::thread> workers;
+  std::mutex error_lock;
+  std::string error;
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t id = 0; id < threads; ++id) {
+    workers.emplace_back([&, id] {
+      try {
+        worker(opts, threads, id, targets, stop, results[id]);
+      } catch (const std::exception& e) {
+        const std::lock_guard<std::mutex> guard(error_lock);
+        error = e.what();
+      }
+    });
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(opts.duration_ms));
+  stop = true;
+  for (std::thread& thread : workers) {
+    thread.join();
+  }
+  const double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start
+  )
+                             .count();
+  if (!error.empty()) {
+    throw vt::exception() << error;
+  }
+
+  if (opts.verify) {
+    verify_files(opts, targets, [&](target& file, size_t block, auto& out) {
+      const auto index = static_cast<size_t>(&file - targets.data());
+      block_io(vtpc_read, keep[index], out, opts, block);
+    });
+  }
+  for (const int fd : keep) {
+    check(vtpc_close(fd) == 0, "vtpc_close");
+  }
+  if (opts.verify) {
+    verify_files(opts, targets, [&](target& file, size_t block, auto& out) {
+      const int fd = open(file.path.c_str(), O_RDONLY);  // NOLINT
+      check(fd >= 0, "open");
+      const auto offset = static_cast<off_t>(block * opts.block);
+      const ssize_t got = pread(fd, out.data(), out.size(), offset);
+      close(fd);
+      check(got == static_cast<ssize_t>(out.size()), "pread");
+    });
+  }
+  for (const target& file : targets) {
+    std::filesystem::remove(file.path);
+  }
+
+  // Справедливость — индекс Джайна по числу операций потоков: 1 — поровну.
+  uint64_t total = 0;
+  double squares = 0;
+  uint64_t min_ops = UINT64_MAX;
+  uint64_t max_ops = 0;
+  std::vector<uint64_t> latency;
+  for (const thread_result& res : results) {
+    total += res.ops;
+    squares += static_cast<double>(res.ops) * static_cast<double>(res.ops);
+    min_ops = std::min(min_ops, res.ops);
+    max_ops = std::max(max_ops, res.ops);
+    latency.insert(latency.end(), res.latency_ns.begin(), res.latency_ns.end());
+  }
+  std::sort(latency.begin(), latency.end());
+  const auto quantile = [&](double q) -> double {
+    if (latency.empty()) {
+      return 0;
+    }
+    const double size = static_cast<double>(latency.size());
+    const size_t index =
+        std::min(static_cast<size_t>(q * size), latency.size() - 1);
+    return static_cast<double>(latency[index]) / 1e3;  // NOLINT
+  };
+  const auto sum = static_cast<double>(total);
+  const double jain =
+      squares > 0 ? sum * sum / (static_cast<double>(threads) * squares) : 0;
+
+  std::cout << threads << ',' << static_cast<double>(total) / seconds << ','
+            << jain << ',' << min_ops << ',' << max_ops << ','
+            << quantile(p99) << ',' << quantile(p999) << '\n';
+}
+
+auto parse(int argc, char** argv) -> options {
+  options opts;
+  const std::vector<std::string_view> args(argv + 1, argv + argc);
+  for (size_t i = 0; i < args.size(); ++i) {
+    const std::string_view key = args[i];
+    if (key == "--verify") {
+      opts.verify = true;
+      continue;
+    }
+    if (i + 1 == args.size()) {
+      throw vt::exception() << "missing value for '" << key << "'";
+    }
+    const std::string value(args[++i]);
+    const auto number = [&] {
+      char* end = nullptr;
+      const unsigned long long result = std::strtoull(value.c_str(), &end, 10);
+      if (value.empty() || *end != '\0') {
+        throw vt::exception() << "bad number '" << value << "'";
+      }
+      return static_cast<size_t>(result);
+    };
+    if (key == "--threads") {
+      opts.threads = number();
+    } else if (key == "--duration-ms") {
+      opts.duration_ms = number();
+    } else if (key == "--read-ratio") {
+      opts.read_ratio = number();
+    } else if (key == "--shared-files") {
+      opts.shared_files = number();
+    } else if (key == "--file-blocks") {
+      opts.file_blocks = number();
+    } else if (key == "--block") {
+      opts.block = number();
+    } else if (key == "--cache-pages") {
+      opts.cache_pages = number();
+    } else if (key == "--seed") {
+      opts.seed = number();
+    } else if (key == "--dir") {
+      opts.dir = value;
+    } else {
+      throw vt::exception()
+          << "unknown option '" << key
+          << "'; usage: test_threads [--threads N] [--duration-ms N] "
+             "[--read-ratio 0..100] [--shared-files N] [--file-blocks N] "
+             "[--block N] [--cache-pages N] [--seed N] [--dir PATH] "
+             "[--verify]";
+    }
+  }
+  if (opts.threads == 0 || opts.file_blocks == 0 ||
+      static_cast<double>(opts.read_ratio) > percent ||
+      opts.block < record_size || opts.block % record_size != 0) {
+    throw vt::exception() << "bad options";
+  }
+  return opts;
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) -> int try {
+  const options opts = parse(argc, argv);
+  struct vtpc_config config = VTPC_CONFIG_DEFAULT;
+  config.cache_pages = opts.cache_pages;
+  check(vtpc_configure(&config) == 0, "vtpc_configure");
+
+  std::cout << "threads,ops_per_sec,fairness,min_ops,max_ops,p99_us,p999_us\n";
+  for (size_t threads = 1; threads <= opts.threads; ++threads) {
+    run(opts, threads);
+  }
+  return 0;
+} catch (const std::exception& e) {
+  std::cerr << "exception: " << e.what() << '\n';
+  return 1;
+}
@@ -0,0 +1,435 @@
+#include <sys/types.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "exception.hpp"
+#include "file.hpp"
+
+extern "C" {
+#include "vtpc.h"
+}
+
+// vtpc_bench — сравнение vtpc и libc на типовых нагрузках. Все нагрузки
+// работают с заранее заполненным файлом блоками по block байт; генератор
+// случайных чисел пересоздаётся с тем же seed перед каждым прогоном, поэтому
+// обе реализации видят одну и ту же последовательность смещений.
+
+namespace {
+
+constexpr double zipf_theta = 0.99;
+constexpr double hot_share = 0.8;
+constexpr double percent = 100.0;
+constexpr double micro = 1e6;
+constexpr double p50 = 0.50;
+constexpr double p99 = 0.99;
+constexpr double p999 = 0.999;
+
+struct options {
+  size_t file_size = 64U << 20U;
+  size_t cache_pages = 4096;
+  size_t block = VTPC_PAGE_SIZE;
+  size_t ops = 100000;
+  uint64_t seed = 1;
+  std::string format = "csv";
+  std::string workload = "all";
+  std::string backend = "both";
+  std::string dir = "/tmp";
+};
+
+struct result {
+  std::string workload;
+  std::string backend;
+  size_t ops = 0;
+  size_t block = 0;
+  double seconds = 0;
+  double hit_ratio = -1;  // у libc счётчиков попаданий нет
+  std::vector<double> latency_us;
+};
+
+// Генератор Зипфа по методу Грея и др. (как в YCSB): ранги 0..n-1, ранг 0
+// самый популярный.
+class zipf_dist {
+public:
+  explicit zipf_dist(size_t n) : n_(n) {
+    for (size_t i = 1; i <= n; ++i) {
+      zetan_ += 1.0 / std::pow(static_cast<double>(i), zipf_theta);
+    }
+    const double zeta2 = 1.0 + 1.0 / std::pow(2.0, zipf_theta);
+    alpha_ = 1.0 / (1.0 - zipf_theta);
+    eta_ = (1.0 - std::pow(2.0 / static_cast<double>(n), 1.0 - zipf_theta)) /
+           (1.0 - zeta2 / zetan_);
+  }
+
+  auto operator()(std::mt19937_64& random) const -> size_t {
+    const double u = std::uniform_real_distribution<double>(0, 1)(random);
+    const double uz = u * zetan_;
+    if (uz < 1.0) {
+      return 0;
+    }
+    if (uz < 1.0 + std::pow(0.5, zipf_theta)) {
+      return 1;
+    }
+    const double rank = static_cast<double>(n_) *
+                        std::pow(eta_ * u - eta_ + 1.0, alpha_);
+    return std::min(static_cast<size_t>(rank), n_ - 1);
+  }
+
+private:
+  size_t n_;
+  double zetan_ = 0;
+  double alpha_ = 0;
+  double eta_ = 0;
+};
+
+// Одна операция нагрузки над файлом; step — её номер.
+using operation = std::function<void(vt::file&, size_t step)>;
+
+struct workload {
+  std::string_view name;
+  std::function<operation(const options&, std::mt19937_64&)> make;
+};
+
+auto block_offset(const options& opts, size_t block) -> off_t {
+  return static_cast<off_t>(block * opts.block);
+}
+
+auto blocks_of(const options& opts) -> size_t {
+  return opts.file_size / opts.block;
+}
+
+auto workloads() -> std::vector<workload> {
+  return {
+      {"seq-read",
+       [](const options& opts, std::mt19937_64&) -> operation {
+         return [&opts, buf = std::string(opts.block, '\0')](
+                    vt::file& file, size_t step
+                ) mutable {
+           if (step % blocks_of(opts) == 0) {
+             file.seek(0);
+           }
+           file.read(buf.data(), buf.size());
+         };
+       }},
+      {"seq-write",
+       [](const options& opts, std::mt19937_64&) -> operation {
+         return [&opts, buf = std::string(opts.block, 'w')](
+                    vt::file& file, size_t step
+                ) {
+           if (step % blocks_of(opts) == 0) {
+             file.seek(0);
+           }
+           file.write(buf.data(), buf.size());
+         };
+       }},
+      {"uniform",
+       [](const options& opts, std::mt19937_64& random) -> operation {
+         return [&opts, &random, buf = std::string(opts.block, '\0')](
+                    vt::file& file, size_t
+                ) mutable {
+           std::uniform_int_distribution<size_t> dist(0, blocks_of(opts) - 1);
+           file.seek(block_offset(opts, dist(random)));
+           file.read(buf.data(), buf.size());
+         };
+       }},
+      {"zipf",
+       [](const options& opts, std::mt19937_64& random) -> operation {
+         return [&opts,
+                 &random,
+                 zipf = std::make_shared<zipf_dist>(blocks_of(opts)),
+                 buf = std::string(opts.block, '\0')](
+                    vt::file& file, size_t
+                ) mutable {
+           file.seek(block_offset(opts, (*zipf)(random)));
+           file.read(buf.data(), buf.size());
+         };
+       }},
+      // Горячий набор по Зипфу вперемешку с длинным последовательным
+      // проходом, который вытесняет его из кэша без LRU-защиты.
+      {"scan-hot",
+       [](const options& opts, std::mt19937_64& random) -> operation {
+         return [&opts,
+                 &random,
+                 zipf = std::make_shared<zipf_dist>(blocks_of(opts)),
+                 scan = size_t{0},
+                 buf = std::string(opts.block, '\0')](
+                    vt::file& file, size_t
+                ) mutable {
+           size_t block = 0;
+           if (std::uniform_real_distribution<double>(0, 1)(random) <
+               hot_share) {
+             block = (*zipf)(random);
+           } else {
+             block = scan;
+             scan = (scan + 1) % blocks_of(opts);
+           }
+           file.seek(block_offset(opts, block));
+           file.read(buf.data(), buf.size());
+         };
+       }},
+      {"rmw",
+       [](const options& opts, std::mt19937_64& random) -> operation {
+         return [&opts, &random, buf = std::string(opts.block, '\0')](
+                    vt::file& file, size_t
+                ) mutable {
+           std::uniform_int_distribution<size_t> dist(0, blocks_of(opts) - 1);
+           const off_t offset = block_offset(opts, dist(random));
+           file.seek(offset);
+           file.read(buf.data(), buf.size());
+           ++buf[0];
+           file.seek(offset);
+           file.write(buf.data(), buf.size());
+         };
+       }},
+  };
+}
+
+auto hit_stats() -> struct vtpc_stats {
+  struct vtpc_stats stats{};
+  if (vtpc_stats(&stats) != 0) {
+    throw vt::exception() << "vtpc_stats failed";
+  }
+  return stats;
+}
+
+auto run(
+    const options& opts,
+    const workload& load,
+    std::string_view backend,
+    vt::file& file
+) -> result {
+  std::mt19937_64 random(opts.seed);
+  operation op = load.make(opts, random);
+
+  result res{
+      .workload = std::string(load.name),
+      .backend = std::string(backend),
+      .ops = opts.ops,
+      .block = opts.block,
+  };
+  res.latency_us.reserve(opts.ops);
+  const bool vtpc = backend == "vtpc";
+  struct vtpc_stats before{};
+  if (vtpc) {
+    before = hit_stats();
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t step = 0; step < opts.ops; ++step) {
+    const auto op_start = std::chrono::steady_clock::now();
+    op(file, step);
+    const auto op_end = std::chrono::steady_clock::now();
+    res.latency_us.push_back(
+        std::chrono::duration<double, std::micro>(op_end - op_start).count()
+    );
+  }
+  file.sync();
+  res.seconds = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start
+  )
+                    .count();
+
+  if (vtpc) {
+    const struct vtpc_stats after = hit_stats();
+    const auto hits = static_cast<double>(after.hits - before.hits);
+    const auto misses = static_cast<double>(after.misses - before.misses);
+    res.hit_ratio = hits + misses > 0 ? hits / (hits + misses) : 0;
+  }
+  std::sort(res.latency_us.begin(), res.latency_us.end());
+  return res;
+}
+
+auto quantile(const std::vector<double>& sorted, double q) -> double {
+  if (sorted.empty()) {
+    return 0;
+  }
+  const double size = static_cast<double>(sorted.size());
+  const auto index = static_cast<size_t>(q * size);
+  return sorted[std::min(index, sorted.size() - 1)];
+}
+
+auto print_csv(const std::vector<result>& results) -> void {
+  std::cout << "workload,backend,ops,seconds,ops_per_sec,mb_per_sec,"
+               "hit_ratio,p50_us,p99_us,p999_us\n";
+  for (const result& res : results) {
+    const double ops_per_sec = static_cast<double>(res.ops) / res.seconds;
+    std::cout << res.workload << ',' << res.backend << ',' << res.ops << ','
+              << res.seconds << ',' << ops_per_sec << ','
+              << ops_per_sec * static_cast<double>(res.block) / micro << ',';
+    if (res.hit_ratio >= 0) {
+      std::cout << res.hit_ratio * percent;
+    }
+    std::cout << ',' << quantile(res.latency_us, p50) << ','
+              << quantile(res.latency_us, p99) << ','
+              << quantile(res.latency_us, p999) << '\n';
+  }
+}
+
+auto print_json(const std::vector<result>& results, const options& opts)
+    -> void {
+  std::cout << "{\"file_size\": " << opts.file_size
+            << ", \"cache_pages\": " << opts.cache_pages
+            << ", \"block\": " << opts.block << ", \"seed\": " << opts.seed
+            << ", \"results\": [";
+  for (size_t i = 0; i < results.size(); ++i) {
+    const result& res = results[i];
+    const double ops_per_sec = static_cast<double>(res.ops) / res.seconds;
+    const double mb_per_sec = ops_per_sec * static_cast<double>(res.block) /
+                              micro;
+    std::cout << (i ? ", " : "") << "{\"workload\": \"" << res.workload
+              << "\", \"backend\": \"" << res.backend
+              << "\", \"ops\": " << res.ops
+              << ", \"seconds\": " << res.seconds
+              << ", \"ops_per_sec\": " << ops_per_sec
+              << ", \"mb_per_sec\": " << mb_per_sec
+              << ", \"hit_ratio\": ";
+    if (res.hit_ratio >= 0) {
+      std::cout << res.hit_ratio * percent;
+    } else {
+      std::cout << "null";
+    }
+    std::cout << ", \"p50_us\": " << quantile(res.latency_us, p50)
+              << ", \"p99_us\": " << quantile(res.latency_us, p99)
+              << ", \"p999_us\": " << quantile(res.latency_us, p999) << '}';
+  }
+  std::cout << "]}\n";
+}
+
+// parse_size — число с необязательным суффиксом K, M или G.
+auto parse_size(std::string_view text) -> size_t {
+  std::string digits(text);
+  size_t shift = 0;
+  const std::string_view suffixes = "KMG";
+  const size_t suffix = digits.empty() ? std::string_view::npos
+                                       : suffixes.find(digits.back());
+  if (suffix != std::string_view::npos) {
+    shift = (suffix + 1) * 10;  // NOLINT
+    digits.pop_back();
+  }
+  char* end = nullptr;
+  const unsigned long long value = std::strtoull(digits.c_str(), &end, 10);
+  if (digits.empty() || *end != '\0') {
+    throw vt::exception() << "bad number '" << text << "'";
+  }
+  return static_cast<size_t>(value) << shift;
+}
+
+auto parse(int argc, char** argv) -> options {
+  options opts;
+  const std::vector<std::string_view> args(argv + 1, argv + argc);
+  for (size_t i = 0; i < args.size(); ++i) {
+    const std::string_view key = args[i];
+    if (i + 1 == args.size()) {
+      throw vt::exception() << "missing value for '" << key << "'";
+    }
+    const std::string_view value = args[++i];
+    if (key == "--file-size") {
+      opts.file_size = parse_size(value);
+    } else if (key == "--cache-pages") {
+      opts.cache_pages = parse_size(value);
+    } else if (key == "--block") {
+      opts.block = parse_size(value);
+    } else if (key == "--ops") {
+      opts.ops = parse_size(value);
+    } else if (key == "--seed") {
+      opts.seed = parse_size(value);
+    } else if (key == "--format") {
+      opts.format = value;
+    } else if (key == "--workload") {
+      opts.workload = value;
+    } else if (key == "--backend") {
+      opts.backend = value;
+    } else if (key == "--dir") {
+      opts.dir = value;
+    } else {
+      throw vt::exception()
+          << "unknown option '" << key
+          << "'; usage: vtpc_bench [--file-size N] [--cache-pages N] "
+             "[--block N] [--ops N] [--seed N] [--format csv|json] "
+             "[--workload all|seq-read|seq-write|uniform|zipf|scan-hot|rmw] "
+             "[--backend both|libc|vtpc] [--dir PATH]";
+    }
+  }
+  if (opts.block == 0 || opts.file_size < opts.block || opts.ops == 0 ||
+      (opts.format != "csv" && opts.format != "json")) {
+    throw vt::exception() << "bad options";
+  }
+  return opts;
+}
+
+// open_backend — создаёт файл заново и заполняет его до file_size.
+auto open_backend(
+    std::string_view backend, const std::string& path, const options& opts
+) -> std::unique_ptr<vt::file> {
+  std::filesystem::remove(path);
+  auto file = backend == "libc" ? vt::file::open_libc(path)
+                                : vt::file::open_vtpc(path);
+  const std::string block(opts.block, 'x');
+  file->seek(0);
+  for (size_t done = 0; done + opts.block <= opts.file_size;
+       done += opts.block) {
+    file->write(block.data(), block.size());
+  }
+  file->sync();
+  return file;
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) -> int try {
+  const options opts = parse(argc, argv);
+
+  // Параметры по умолчанию, кроме ёмкости кэша.
+  struct vtpc_config config = VTPC_CONFIG_DEFAULT;
+  config.cache_pages = opts.cache_pages;
+  if (vtpc_configure(&config) != 0) {
+    throw vt::exception() << "vtpc_configure failed";
+  }
+
+  std::vector<std::string_view> backends;
+  if (opts.backend == "both" || opts.backend == "libc") {
+    backends.emplace_back("libc");
+  }
+  if (opts.backend == "both" || opts.backend == "vtpc") {
+    backends.emplace_back("vtpc");
+  }
+
+  std::vector<result> results;
+  for (const workload& load : workloads()) {
+    if (opts.workload != "all" && opts.workload != load.name) {
+      continue;
+    }
+    for (const std::string_view backend : backends) {
+      const std::string path =
+          opts.dir + "/vtpc_bench_" + std::string(backend);
+      auto file = open_backend(backend, path, opts);
+      results.push_back(run(opts, load, backend, *file));
+    }
+  }
+  if (results.empty()) {
+    throw vt::exception() << "no such workload '" << opts.workload << "'";
+  }
+
+  if (opts.format == "json") {
+    print_json(results, opts);
+  } else {
+    print_csv(results);
+  }
+  return 0;
+} catch (const std::exception& e) {
+  std::cerr << "exception: " << e.what() << '\n';
+  return 1;
+}
@@ -1,17 +1,36 @@
 #define _GNU_SOURCE  // включаем расширенные GNU-возможности до подключения заголовков, чтобы активировать нестандартные функции GNU C Library
 #define _POSIX_C_SOURCE 200809L  // фиксируем уровень POSIX для доступа к современным API (например, getline и clock_gettime), гарантируя совместимость прототипов
 #include "io-loader.h"  // подгружаем объявление публичных функций и констант этого модуля, формируя связку с заголовком библиотеки
+#include "vtpc.h"  // кэш страниц из lab/vtpc, через который работает --engine vtpc
 
+#include <errno.h>  // коды ошибок, которые асинхронные движки возвращают как -errno в результатах операций
 #include <fcntl.h>  // даёт доступ к open, fcntl и файловым флагам, необходимым для настройки поведения файловых дескрипторов
+#include <math.h>  // pow, log и sqrt для неравномерных распределений блоков
+#include <pthread.h>  // потоки и барьеры POSIX, на которых построен многопоточный режим нагрузки
 #include <stdint.h>  // предоставляет целочисленные типы с фиксированной шириной, чтобы выражать размеры и смещения без неопределённости
 #include <stdio.h>  // подключает стандартный ввод/вывод, включая printf и fprintf, используемые для информационных и диагностических сообщений
+#include <limits.h>  // IOV_MAX — предел числа буферов в одном preadv/pwritev
 #include <stdlib.h>  // содержит функции преобразования строк и управления памятью, что важно при разборе аргументов и выделении буферов
 #include <string.h>  // предоставляет строковые утилиты, такие как strcmp и strchr, применяемые при сопоставлении ключей командной строки
+#include <sys/mman.h>  // mmap и madvise для --engine mmap и отображения колец io_uring
+#include <sys/resource.h>  // getrusage: число страничных отказов процесса для отчёта
 #include <sys/stat.h>  // нужен для структуры stat и fstat, чтобы получать метаданные о файле и его размере
 #include <sys/types.h>  // объявляет базовые системные типы (off_t и др.), обеспечивая переносимость расчётов смещений
+#include <sys/uio.h>  // preadv/pwritev и preadv2/pwritev2 для пакетов --batch
 #include <time.h>  // обеспечивает работу с временем и clock_gettime, которые используются при замерах производительности операций
 #include <unistd.h>  // даёт POSIX-функции уровня системы (close, pread, pwrite), формируя базовые операции ввода-вывода
 
+#if defined(__x86_64__)  // аппаратная CRC32C
+#include <nmmintrin.h>  // _mm_crc32_u64 из SSE4.2 для --verify
+#endif  // конец подключения SSE4.2
+
+#if defined(__linux__)  // асинхронные движки опираются на интерфейсы ядра Linux
+#include <linux/aio_abi.h>  // структуры iocb и io_event интерфейса Linux AIO без библиотеки libaio
+#include <linux/io_uring.h>  // структуры колец и записей io_uring без библиотеки liburing
+#include <sys/prctl.h>  // PR_SET_TIMERSLACK для точных пробуждений открытого цикла
+#include <sys/syscall.h>  // номера системных вызовов io_uring_* и io_*, у которых нет обёрток в libc
+#endif  // конец подключения заголовков Linux
+
 #define NSEC_PER_SEC 1000000000L  // число наносекунд в одной секунде для расчётов времени, удобное при нормализации длительности операций
 
 /*
@@ -35,6 +54,16 @@
  */
 const int FILE_MODE_PERMISSIONS = 0666;  // режим доступа при создании файлов (rw-rw-rw-); используется для open(O_CREAT)
 const int MIN_ARG_COUNT = 9;  // минимальное число аргументов командной строки для запуска, покрывающее обязательные ключи
+const double BYTES_PER_MB = 1e6;  // байт в мегабайте для вывода пропускной способности в MB/s
+const double NSEC_PER_USEC = 1e3;  // наносекунд в микросекунде для вывода задержек
+const int MAX_IODEPTH = 4096;  // верхняя граница --iodepth, ограничивающая память под буферы и кольца
+const size_t VTPC_CACHE_PAGES = 1024;  // ёмкость кэша vtpc по умолчанию: 4 МиБ страницами по 4 КиБ
+const uint64_t RATE_SPIN_NS = 20000;  // за сколько до срока операции открытого цикла поток перестаёт спать и опрашивает часы и завершения
+const size_t VERIFY_REPORT_LIMIT = 10;  // сколько испорченных блоков поток описывает в stderr, остальные только считаются
+const uint32_t CRC32C_POLY = 0x82F63B78U;  // отражённый многочлен Castagnoli
+const uint64_t SPLITMIX_STEP = 0x9E3779B97F4A7C15ULL;  // шаг «золотого сечения» генератора splitmix64, которым раскладывается --seed
+const double PARETO_DEFAULT_H = 0.2;  // доля горячих блоков pareto по умолчанию: 80% обращений в 20% блоков
+const double NORMAL_DEFAULT_SIGMA = 1.0 / 6.0;  // sigma normal по умолчанию: ±3 sigma покрывают весь диапазон
 
 // ------------------------------ ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ ------------------------------  // служебные функции модуля
 /*
@@ -50,7 +79,14 @@ void usage(const char* program_name) {  // объявляем функцию п
       "Usage: %s --rw read|write --block_size <n> --block_count <n> --file "  // первая строка подсказки с обязательными ключами и порядком следования
       "<path>\n"  // продолжаем сообщение переносом строки, чтобы вынести путь на отдельную строку
       "       [--range A-B] [--direct on|off] [--type sequence|random] "  // описываем необязательные параметры запуска и допустимые значения
-      "[--repetitions N]\n",  // завершаем подсказку и готовим форматы для числовых аргументов
+      "[--repetitions N]\n"  // продолжаем подсказку ключом числа повторов
+      "       [--threads N] [--slice disjoint|shared]\n"  // многопоточный режим: число потоков и способ деления диапазона между ними
+      "       [--engine psync|io_uring|libaio|vtpc|mmap] [--iodepth N] [--cache_pages N]\n"  // движок ввода-вывода, глубина очереди и ёмкость кэша vtpc
+      "       [--madvise normal|random|sequential|willneed|hugepage] [--populate]\n"  // совет ядру и предзагрузка отображения для --engine mmap
+      "       [--batch N] [--rwf hipri|nowait[,...]] [--verify]\n"  // пакеты векторных вызовов psync, их флаги и проверка данных
+      "       [--rate N[iops|mb]] [--rwmixread P] [--seed N]\n"  // открытый цикл, доля чтений и воспроизводимость случайных блоков
+      "       [--dist uniform|zipf:THETA|pareto[:H]|hotspot:A/B|normal[:SIGMA]]\n"  // распределение случайных блоков
+      "       [--output-format text|json]\n",  // формат отчёта: для человека или для дашбордов
       program_name  // подставляем имя программы в шаблон, чтобы строка была актуальна при любых именах бинарника
   );  // завершаем вызов fprintf, что отправляет данные в буфер stderr
 }  // конец функции usage, возвращающей управление без дополнительного значения
@@ -88,6 +124,1417 @@ int parse_range(const char* range_str, off_t* start_val, off_t* end_val) {  // 
   return 0;  // уведомляем об успешном разборе диапазона, позволяя вызывающему коду использовать полученные границы
 }  // завершение parse_range, обеспечивающее корректное состояние строки range_str к моменту выхода
 
+// monotonic_seconds() — текущее время CLOCK_MONOTONIC в секундах с дробной частью
+double monotonic_seconds(void) {  // отметки в виде double удобно вычитать и сравнивать между потоками
+  struct timespec now;  // текущая отметка монотонных часов
+  clock_gettime(CLOCK_MONOTONIC, &now);  // монотонные часы не зависят от перевода системного времени
+  return (double)now.tv_sec + (double)now.tv_nsec / (double)NSEC_PER_SEC;  // переводим отметку в секунды с дробной частью
+}  // конец monotonic_seconds
+
+// monotonic_ns() — текущее время CLOCK_MONOTONIC в наносекундах для замера отдельных операций
+uint64_t monotonic_ns(void) {  // целые наносекунды вычитаются без потери точности
+  struct timespec now;  // текущая отметка монотонных часов
+  clock_gettime(CLOCK_MONOTONIC, &now);  // в Linux вызов обслуживается vDSO без входа в ядро
+  return (uint64_t)now.tv_sec * (uint64_t)NSEC_PER_SEC + (uint64_t)now.tv_nsec;  // переводим отметку в наносекунды
+}  // конец monotonic_ns
+
+// sleep_until_ns() — спит до момента deadline по CLOCK_MONOTONIC
+void sleep_until_ns(uint64_t deadline) {  // абсолютный срок не накапливает погрешность последовательных пауз
+  struct timespec until;  // срок в формате clock_nanosleep
+  until.tv_sec = (time_t)(deadline / (uint64_t)NSEC_PER_SEC);  // целые секунды
+  until.tv_nsec = (long)(deadline % (uint64_t)NSEC_PER_SEC);  // остаток в наносекундах
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, NULL) == EINTR) {  // после сигнала досыпаем до того же срока
+  }  // конец ожидания
+}  // конец sleep_until_ns
+
+// wait_until_ns() — ждёт момента deadline: спит до RATE_SPIN_NS перед ним, а остаток крутится на часах
+void wait_until_ns(uint64_t deadline) {  // пробуждение из сна опаздывает на десятки микросекунд, а опрос часов — нет
+  if (deadline > RATE_SPIN_NS && deadline - RATE_SPIN_NS > monotonic_ns()) {  // до срока дольше окна опроса
+    sleep_until_ns(deadline - RATE_SPIN_NS);  // спим, пока опоздание пробуждения укладывается в окно
+  }  // конец сна
+  while (monotonic_ns() < deadline) {  // vDSO отвечает без входа в ядро
+  }  // конец опроса часов
+}  // конец wait_until_ns
+
+// remaining_ns() — сколько наносекунд осталось до момента deadline, 0 — если он уже наступил
+uint64_t remaining_ns(uint64_t deadline) {  // для относительных тайм-аутов системных вызовов
+  uint64_t now = monotonic_ns();  // текущий момент
+  return deadline > now ? deadline - now : 0;  // срок в прошлом даёт нулевой тайм-аут
+}  // конец remaining_ns
+
+// ------------------------------ СЛУЧАЙНЫЕ БЛОКИ ------------------------------  // генератор и распределения номеров блоков
+/*
+ * У каждого потока свой генератор xoshiro256**: он быстрее rand_r, даёт
+ * 64 бита за вызов и не имеет общего состояния. Состояние потока 0 получается
+ * из --seed через splitmix64, а каждого следующего — прыжком на 2^128 шагов
+ * от предыдущего, поэтому последовательности потоков не пересекаются, а
+ * запуск с тем же --seed повторяет те же блоки. Номер в диапазоне берётся
+ * умножением с отбраковкой (метод Лемира) без смещения, которое даёт
+ * остаток от деления. zipf строится алгоритмом Грея (как в YCSB и fio),
+ * pareto — степенью равномерного числа, normal — преобразованием Бокса —
+ * Мюллера с отбраковкой значений за пределами диапазона.
+ */
+
+// rng_rotl() — циклический сдвиг влево
+uint64_t rng_rotl(uint64_t value, int bits) {  // компилятор сводит его к одной инструкции
+  return (value << bits) | (value >> (64 - bits));  // старшие биты переходят в младшие
+}  // конец rng_rotl
+
+// rng_next() — следующее 64-битное число xoshiro256**
+uint64_t rng_next(uint64_t* state) {  // state — четыре слова состояния потока
+  uint64_t result = rng_rotl(state[1] * 5, 7) * 9;  // выходная функция **
+  uint64_t shifted = state[1] << 17;  // часть линейного перехода
+  state[2] ^= state[0];  // линейный переход xoshiro
+  state[3] ^= state[1];  // линейный переход xoshiro
+  state[1] ^= state[2];  // линейный переход xoshiro
+  state[0] ^= state[3];  // линейный переход xoshiro
+  state[2] ^= shifted;  // линейный переход xoshiro
+  state[3] = rng_rotl(state[3], 45);  // линейный переход xoshiro
+  return result;  // случайное число
+}  // конец rng_next
+
+// rng_seed() — раскладывает 64-битное зерно в состояние через splitmix64
+void rng_seed(uint64_t* state, uint64_t seed) {  // состояние не может оказаться нулевым
+  int index = 0;  // номер слова состояния
+  for (index = 0; index < 4; ++index) {  // каждое слово — следующий выход splitmix64
+    seed += SPLITMIX_STEP;  // шаг splitmix64
+    uint64_t mixed = seed;  // перемешиваем копию
+    mixed = (mixed ^ (mixed >> 30)) * 0xBF58476D1CE4E5B9ULL;  // первый раунд перемешивания
+    mixed = (mixed ^ (mixed >> 27)) * 0x94D049BB133111EBULL;  // второй раунд перемешивания
+    state[index] = mixed ^ (mixed >> 31);  // слово состояния
+  }  // конец заполнения состояния
+}  // конец rng_seed
+
+// rng_jump() — сдвигает генератор на 2^128 шагов вперёд
+void rng_jump(uint64_t* state) {  // так получается независимая последовательность для следующего потока
+  static const uint64_t JUMP[4] = {0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL, 0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL};  // многочлен прыжка xoshiro256
+  uint64_t jumped[4] = {0, 0, 0, 0};  // состояние после прыжка
+  int word = 0;  // номер слова многочлена
+  for (word = 0; word < 4; ++word) {  // перебираем слова многочлена
+    int bit = 0;  // номер бита слова
+    for (bit = 0; bit < 64; ++bit) {  // перебираем биты слова
+      if (JUMP[word] & ((uint64_t)1 << bit)) {  // бит многочлена установлен
+        jumped[0] ^= state[0];  // накапливаем текущее состояние
+        jumped[1] ^= state[1];  // накапливаем текущее состояние
+        jumped[2] ^= state[2];  // накапливаем текущее состояние
+        jumped[3] ^= state[3];  // накапливаем текущее состояние
+      }  // конец проверки бита
+      rng_next(state);  // следующий шаг генератора
+    }  // конец перебора битов
+  }  // конец перебора слов
+  memcpy(state, jumped, sizeof(jumped));  // переходим в новое состояние
+}  // конец rng_jump
+
+// rng_double() — равномерное число из [0, 1)
+double rng_double(uint64_t* state) {  // 53 старших бита заполняют мантиссу double
+  return (double)(rng_next(state) >> 11) * 0x1.0p-53;  // масштабируем к [0, 1)
+}  // конец rng_double
+
+// rng_below() — равномерное целое из [0, bound) без смещения
+uint64_t rng_below(uint64_t* state, uint64_t bound) {  // метод Лемира: умножение вместо деления, деление только при отбраковке
+  unsigned __int128 product = (unsigned __int128)rng_next(state) * bound;  // старшие 64 бита — кандидат
+  uint64_t low = (uint64_t)product;  // младшие 64 бита решают, нужна ли отбраковка
+  if (low < bound) {  // кандидат может попасть в перекошенную часть
+    uint64_t threshold = -bound % bound;  // 2^64 mod bound: столько младших значений отбрасывается
+    while (low < threshold) {  // кандидат из перекошенной части
+      product = (unsigned __int128)rng_next(state) * bound;  // берём новый
+      low = (uint64_t)product;  // и снова проверяем
+    }  // конец отбраковки
+  }  // конец проверки перекоса
+  return (uint64_t)(product >> 64);  // номер из [0, bound)
+}  // конец rng_below
+
+// parse_dist() — разбирает значение --dist в вид и параметры распределения
+int parse_dist(const char* dist_str, io_dist_t* dist) {  // возвращает 0 или -1 при неверном значении
+  memset(dist, 0, sizeof(*dist));  // параметры, не заданные видом, остаются нулями
+  char* endptr = NULL;  // конец разобранного числа
+  if (strcmp(dist_str, "uniform") == 0) {  // равномерное распределение
+    dist->kind = IO_DIST_UNIFORM;  // параметров нет
+    return 0;  // разбор завершён
+  }  // конец uniform
+  if (strncmp(dist_str, "zipf:", 5) == 0) {  // zipf с обязательным theta
+    dist->kind = IO_DIST_ZIPF;  // вид распределения
+    dist->param = strtod(dist_str + 5, &endptr);  // theta
+    return *endptr == '\0' && dist->param > 0.0 && dist->param != 1.0 ? 0 : -1;  // при theta = 1 алгоритм Грея вырождается
+  }  // конец zipf
+  if (strncmp(dist_str, "pareto", 6) == 0) {  // pareto с необязательным h
+    dist->kind = IO_DIST_PARETO;  // вид распределения
+    dist->param = PARETO_DEFAULT_H;  // h по умолчанию
+    if (dist_str[6] == ':') {  // h задан явно
+      dist->param = strtod(dist_str + 7, &endptr);  // доля горячих блоков
+      return *endptr == '\0' && dist->param > 0.0 && dist->param < 1.0 ? 0 : -1;  // h строго внутри (0, 1)
+    }  // конец явного h
+    return dist_str[6] == '\0' ? 0 : -1;  // иначе за именем ничего не должно быть
+  }  // конец pareto
+  if (strncmp(dist_str, "hotspot:", 8) == 0) {  // hotspot:A/B — A% обращений в B% блоков
+    dist->kind = IO_DIST_HOTSPOT;  // вид распределения
+    dist->hot_access = strtod(dist_str + 8, &endptr) / 100.0;  // доля обращений
+    if (*endptr != '/') {  // доли разделяются косой чертой
+      return -1;  // неверный формат
+    }  // конец проверки разделителя
+    dist->hot_blocks = strtod(endptr + 1, &endptr) / 100.0;  // доля блоков
+    return *endptr == '\0' && dist->hot_access >= 0.0 && dist->hot_access <= 1.0 && dist->hot_blocks > 0.0 && dist->hot_blocks < 1.0 ? 0 : -1;  // горячая часть не пуста и не весь диапазон
+  }  // конец hotspot
+  if (strncmp(dist_str, "normal", 6) == 0) {  // normal с необязательной sigma в процентах диапазона
+    dist->kind = IO_DIST_NORMAL;  // вид распределения
+    dist->param = NORMAL_DEFAULT_SIGMA;  // sigma по умолчанию
+    if (dist_str[6] == ':') {  // sigma задана явно
+      dist->param = strtod(dist_str + 7, &endptr) / 100.0;  // доля диапазона
+      return *endptr == '\0' && dist->param > 0.0 ? 0 : -1;  // sigma положительна
+    }  // конец явной sigma
+    return dist_str[6] == '\0' ? 0 : -1;  // иначе за именем ничего не должно быть
+  }  // конец normal
+  return -1;  // неизвестное распределение
+}  // конец parse_dist
+
+// dist_prepare() — предвычисляет параметры распределения для диапазона из blocks блоков
+void dist_prepare(io_dist_t* dist, off_t blocks) {  // для zipf это O(blocks), поэтому делается до старта потоков
+  if (dist->kind != IO_DIST_ZIPF) {  // остальным распределениям предвычисление не нужно
+    return;  // параметры уже готовы
+  }  // конец проверки вида
+  double theta = dist->param;  // показатель zipf
+  double zetan = 0.0;  // сумма 1 / k^theta
+  off_t rank = 0;  // ранг блока
+  for (rank = 1; rank <= blocks; ++rank) {  // суммируем по всем рангам диапазона
+    zetan += pow((double)rank, -theta);  // вклад ранга
+  }  // конец суммирования
+  double zeta2 = 1.0 + pow(2.0, -theta);  // та же сумма для двух рангов
+  dist->zipf_zetan = zetan;  // нормировка
+  dist->zipf_alpha = 1.0 / (1.0 - theta);  // показатель обратного преобразования
+  dist->zipf_eta = (1.0 - pow(2.0 / (double)blocks, 1.0 - theta)) / (1.0 - zeta2 / zetan);  // поправка Грея
+}  // конец dist_prepare
+
+// dist_next() — номер случайного блока из [0, blocks)
+off_t dist_next(io_task_t* task, off_t blocks) {  // выбирает блок по распределению задания
+  const io_dist_t* dist = &task->dist;  // распределение потока
+  uint64_t* state = task->rng;  // генератор потока
+  off_t block = 0;  // выбранный блок
+  switch (dist->kind) {  // способ выбора зависит от вида
+    case IO_DIST_UNIFORM:  // равномерное
+      return (off_t)rng_below(state, (uint64_t)blocks);  // любой блок равновероятен
+    case IO_DIST_ZIPF: {  // алгоритм Грея
+      double uniform = rng_double(state);  // равномерное число
+      double scaled = uniform * dist->zipf_zetan;  // позиция в нормировке
+      if (scaled < 1.0) {  // первый ранг
+        return 0;  // самый горячий блок
+      }  // конец первого ранга
+      if (scaled < 1.0 + pow(0.5, dist->param)) {  // второй ранг
+        return blocks > 1 ? 1 : 0;  // второй по горячести блок
+      }  // конец второго ранга
+      block = (off_t)((double)blocks * pow(dist->zipf_eta * uniform - dist->zipf_eta + 1.0, dist->zipf_alpha));  // хвост распределения
+      break;  // ограничим ниже
+    }  // конец zipf
+    case IO_DIST_PARETO:  // степень равномерного числа
+      block = (off_t)((double)blocks * pow(rng_double(state), log(dist->param) / log(1.0 - dist->param)));  // доля 1 - h значений меньше h
+      break;  // ограничим ниже
+    case IO_DIST_HOTSPOT: {  // две равномерные части
+      uint64_t hot = (uint64_t)((double)blocks * dist->hot_blocks);  // блоков в горячей части
+      hot = hot ? hot : 1;  // горячая часть не пуста
+      hot = hot < (uint64_t)blocks ? hot : (uint64_t)blocks - 1;  // и не занимает весь диапазон
+      if (hot == 0 || rng_double(state) < dist->hot_access) {  // в горячую часть; диапазон из одного блока весь горячий
+        return (off_t)rng_below(state, hot ? hot : 1);  // равномерно в горячей части
+      }  // конец горячей части
+      return (off_t)(hot + rng_below(state, (uint64_t)blocks - hot));  // равномерно в холодной части
+    }  // конец hotspot
+    case IO_DIST_NORMAL: {  // Бокс — Мюллер
+      double value = -1.0;  // значение в блоках
+      while (value < 0.0 || value >= (double)blocks) {  // отбраковываем значения за пределами диапазона
+        double radius = sqrt(-2.0 * log(1.0 - rng_double(state)));  // 1 - u не бывает нулём
+        double angle = 2.0 * M_PI * rng_double(state);  // равномерный угол
+        value = (double)blocks / 2.0 + radius * cos(angle) * dist->param * (double)blocks;  // нормальное со средним в середине
+      }  // конец отбраковки
+      return (off_t)value;  // номер блока
+    }  // конец normal
+  }  // конец выбора вида
+  return block < blocks ? block : blocks - 1;  // округление вверх могло дать blocks
+}  // конец dist_next
+
+// ------------------------------ ПРОВЕРКА ДАННЫХ ------------------------------  // метки блоков для --verify
+/*
+ * С --verify каждый записываемый блок начинается с метки
+ * io_verify_header_t: смещение блока, номер записи и CRC32C, а остальное
+ * заполняется псевдослучайными байтами из смещения и номера. Прочитанный
+ * блок проверяется: метка на месте, смещение совпадает с запрошенным
+ * (ловит записи не туда) и сумма сходится (ловит порчу данных). Блок из
+ * одних нулей, в который поток ещё не писал, в запуске с записями — дыра
+ * свежего файла или не тронутая часть подготовленного — считается отдельно
+ * как не записанный, а не как ошибка. Запуск только на чтение проверяет
+ * файл, записанный раньше, поэтому нулевой блок в нём — потерянная запись и
+ * ошибка. С испорченными блоками io-loader завершается с кодом 1. Поток помнит номер последней завершённой записи каждого
+ * своего блока и считает ошибкой чтение более старой версии — устаревшие
+ * данные из кэша. Проверка предполагает, что операции над одним блоком не
+ * пересекаются во времени. Внутри потока это обеспечивается: асинхронный
+ * движок с --iodepth больше 1 при записях не ставит операцию над блоком,
+ * пока над ним идёт предыдущая, и на случайном доступе это немного снижает
+ * глубину очереди. Между потоками так сделать нельзя, поэтому запуск с
+ * записями и --slice shared на нескольких потоках отвергается: чтение,
+ * заставшее чужую запись на полпути, дало бы ложную ошибку суммы. Проверять
+ * можно только файл, записанный с тем же --block_size. CRC32C
+ * считается инструкцией crc32 из SSE4.2, если процессор её поддерживает,
+ * иначе — таблицами по 8 байт за шаг (slicing-by-8). У инструкции задержка
+ * в три такта при пропускной способности одна за такт, поэтому длинный
+ * буфер делится на три полосы, которые считаются одновременно, а их суммы
+ * склеиваются умножением на x^(8 * длина полосы) по модулю многочлена —
+ * сдвигом, таблицы которого строятся заранее под размер блока.
+ */
+
+uint32_t CRC32C_TABLE[8][256];  // таблицы программной CRC32C, заполняются crc32c_init
+size_t CRC32C_LANE = 0;  // длина полосы, под которую построен сдвиг, 0 = полосы не используются
+uint32_t CRC32C_SHIFT[4][256];  // сдвиг состояния CRC32C на CRC32C_LANE нулевых байтов, по байту состояния на таблицу
+
+// crc32c_init() — строит таблицы slicing-by-8
+void crc32c_init(void) {  // вызывается один раз до запуска потоков
+  uint32_t byte = 0;  // значение байта
+  for (byte = 0; byte < 256; ++byte) {  // первая таблица — обычная побайтовая
+    uint32_t crc = byte;  // остаток для байта
+    int bit = 0;  // номер бита
+    for (bit = 0; bit < 8; ++bit) {  // делим на многочлен побитно
+      crc = (crc >> 1) ^ (CRC32C_POLY & (0U - (crc & 1U)));  // шаг деления в отражённой форме
+    }  // конец деления
+    CRC32C_TABLE[0][byte] = crc;  // остаток байта
+  }  // конец первой таблицы
+  for (byte = 0; byte < 256; ++byte) {  // таблица k — байт, за которым следуют k нулевых байтов
+    int table = 0;  // номер таблицы
+    for (table = 1; table < 8; ++table) {  // каждая следующая продолжает предыдущую на байт
+      uint32_t prev = CRC32C_TABLE[table - 1][byte];  // остаток на байт короче
+      CRC32C_TABLE[table][byte] = (prev >> 8) ^ CRC32C_TABLE[0][prev & 0xFFU];  // добавляем нулевой байт
+    }  // конец таблиц
+  }  // конец остальных таблиц
+}  // конец crc32c_init
+
+// crc32c_soft() — продолжает CRC32C на length байтов таблицами slicing-by-8
+uint32_t crc32c_soft(uint32_t crc, const void* data, size_t length) {  // crc — текущее состояние без финальной инверсии
+  const unsigned char* bytes = (const unsigned char*)data;  // данные побайтно
+  while (length >= 8) {  // по 8 байтов за шаг
+    uint64_t word = 0;  // очередные 8 байтов
+    memcpy(&word, bytes, sizeof(word));  // данные могут быть не выровнены
+    word ^= crc;  // остаток входит в младшие байты (порядок байтов little-endian)
+    crc = CRC32C_TABLE[7][word & 0xFFU] ^ CRC32C_TABLE[6][(word >> 8) & 0xFFU] ^ CRC32C_TABLE[5][(word >> 16) & 0xFFU] ^ CRC32C_TABLE[4][(word >> 24) & 0xFFU] ^ CRC32C_TABLE[3][(word >> 32) & 0xFFU] ^ CRC32C_TABLE[2][(word >> 40) & 0xFFU] ^ CRC32C_TABLE[1][(word >> 48) & 0xFFU] ^ CRC32C_TABLE[0][word >> 56];  // восемь независимых поисков вместо цепочки
+    bytes += 8;  // следующие 8 байтов
+    length -= 8;  // осталось
+  }  // конец основного цикла
+  while (length > 0) {  // хвост короче 8 байтов
+    crc = (crc >> 8) ^ CRC32C_TABLE[0][(crc ^ *bytes) & 0xFFU];  // по байту
+    ++bytes;  // следующий байт
+    --length;  // осталось
+  }  // конец хвоста
+  return crc;  // новое состояние
+}  // конец crc32c_soft
+
+// crc32c_lanes_init() — строит сдвиг для буферов длиной length, делимых на три полосы
+void crc32c_lanes_init(size_t length) {  // вызывается после crc32c_init и до запуска потоков
+  size_t lane = length / 3 / 8 * 8;  // длина полосы, кратная слову инструкции
+  if (lane < 64) {  // на коротких буферах склейка дороже выигрыша
+    CRC32C_LANE = 0;  // считаем одной цепочкой
+    return;  // сдвиг не нужен
+  }  // конец проверки длины
+  unsigned char* zeros = calloc(lane, 1);  // полоса нулевых байтов
+  if (!zeros) {  // без неё сдвиг не построить
+    CRC32C_LANE = 0;  // остаёмся на одной цепочке
+    return;  // это лишь ускорение
+  }  // конец проверки памяти
+  uint32_t bits[32];  // образ каждого бита состояния
+  int bit = 0;  // номер бита
+  for (bit = 0; bit < 32; ++bit) {  // сдвиг линеен, достаточно образов битов
+    bits[bit] = crc32c_soft(1U << bit, zeros, lane);  // состояние после полосы нулей
+  }  // конец образов битов
+  free(zeros);  // полоса больше не нужна
+  int table = 0;  // номер байта состояния
+  for (table = 0; table < 4; ++table) {  // таблица на каждый байт состояния
+    uint32_t byte = 0;  // значение байта
+    for (byte = 0; byte < 256; ++byte) {  // образ — сумма образов установленных битов
+      uint32_t image = 0;  // накопленный образ
+      for (bit = 0; bit < 8; ++bit) {  // биты байта
+        if (byte & (1U << bit)) {  // бит установлен
+          image ^= bits[table * 8 + bit];  // добавляем его образ
+        }  // конец проверки бита
+      }  // конец битов байта
+      CRC32C_SHIFT[table][byte] = image;  // образ байта
+    }  // конец значений байта
+  }  // конец таблиц
+  CRC32C_LANE = lane;  // сдвиг готов
+}  // конец crc32c_lanes_init
+
+// crc32c_shift() — состояние CRC32C после CRC32C_LANE нулевых байтов
+uint32_t crc32c_shift(uint32_t crc) {  // склеивает сумму полосы со следующей
+  return CRC32C_SHIFT[0][crc & 0xFFU] ^ CRC32C_SHIFT[1][(crc >> 8) & 0xFFU] ^ CRC32C_SHIFT[2][(crc >> 16) & 0xFFU] ^ CRC32C_SHIFT[3][crc >> 24];  // четыре поиска по таблицам
+}  // конец crc32c_shift
+
+#if defined(__x86_64__)  // аппаратный вариант есть только на x86-64
+// crc32c_sse42() — продолжает CRC32C инструкцией crc32 по 8 байтов за такт
+__attribute__((target("sse4.2"))) uint32_t crc32c_sse42(uint32_t crc, const void* data, size_t length) {  // вызывается, только если процессор поддерживает SSE4.2
+  const unsigned char* bytes = (const unsigned char*)data;  // данные побайтно
+  uint64_t state = crc;  // инструкция работает с 64-битным регистром
+  if (CRC32C_LANE && length >= 3 * CRC32C_LANE) {  // три полосы прячут задержку инструкции
+    uint64_t state1 = 0;  // вторая полоса считается от нуля
+    uint64_t state2 = 0;  // третья полоса считается от нуля
+    size_t position = 0;  // смещение внутри полосы
+    for (position = 0; position < CRC32C_LANE; position += 8) {  // три независимые цепочки
+      uint64_t word0 = 0;  // слово первой полосы
+      uint64_t word1 = 0;  // слово второй полосы
+      uint64_t word2 = 0;  // слово третьей полосы
+      memcpy(&word0, bytes + position, sizeof(word0));  // данные могут быть не выровнены
+      memcpy(&word1, bytes + CRC32C_LANE + position, sizeof(word1));  // данные могут быть не выровнены
+      memcpy(&word2, bytes + 2 * CRC32C_LANE + position, sizeof(word2));  // данные могут быть не выровнены
+      state = _mm_crc32_u64(state, word0);  // шаг первой полосы
+      state1 = _mm_crc32_u64(state1, word1);  // шаг второй полосы
+      state2 = _mm_crc32_u64(state2, word2);  // шаг третьей полосы
+    }  // конец полос
+    state = crc32c_shift(crc32c_shift((uint32_t)state) ^ (uint32_t)state1) ^ (uint32_t)state2;  // crc(s, A B) = сдвиг(crc(s, A)) ^ crc(0, B)
+    bytes += 3 * CRC32C_LANE;  // остаток считается одной цепочкой
+    length -= 3 * CRC32C_LANE;  // осталось
+  }  // конец полос
+  while (length >= 8) {  // по 8 байтов за инструкцию
+    uint64_t word = 0;  // очередные 8 байтов
+    memcpy(&word, bytes, sizeof(word));  // данные могут быть не выровнены
+    state = _mm_crc32_u64(state, word);  // шаг CRC32C
+    bytes += 8;  // следующие 8 байтов
+    length -= 8;  // осталось
+  }  // конец основного цикла
+  while (length > 0) {  // хвост короче 8 байтов
+    state = _mm_crc32_u8((uint32_t)state, *bytes);  // по байту
+    ++bytes;  // следующий байт
+    --length;  // осталось
+  }  // конец хвоста
+  return (uint32_t)state;  // новое состояние
+}  // конец crc32c_sse42
+#endif  // конец аппаратного варианта
+
+/* crc32c_update — выбранная в main реализация CRC32C */
+uint32_t (*crc32c_update)(uint32_t crc, const void* data, size_t length) = crc32c_soft;
+
+// verify_crc() — CRC32C блока с меткой: поля метки до crc и байты после метки
+uint32_t verify_crc(const unsigned char* block, size_t block_size) {  // поле crc в сумму не входит
+  uint32_t crc = ~0U;  // начальное состояние CRC32C
+  crc = crc32c_update(crc, block, offsetof(io_verify_header_t, crc));  // magic, offset и generation
+  crc = crc32c_update(crc, block + sizeof(io_verify_header_t), block_size - sizeof(io_verify_header_t));  // содержимое блока
+  return ~crc;  // финальная инверсия
+}  // конец verify_crc
+
+// xorshift64() — следующее состояние генератора содержимого блоков
+uint64_t xorshift64(uint64_t state) {  // быстрее xoshiro256** и не требует качества
+  state ^= state << 13;  // шаг xorshift64
+  state ^= state >> 7;  // шаг xorshift64
+  state ^= state << 17;  // шаг xorshift64
+  return state;  // новое состояние
+}  // конец xorshift64
+
+// verify_fill() — заполняет буфер блоком с меткой для записи по смещению offset
+void verify_fill(unsigned char* block, size_t block_size, off_t offset, uint64_t generation) {  // вызывается перед каждой записью
+  io_verify_header_t header;  // метка блока
+  header.magic = IO_VERIFY_MAGIC;  // признак блока с меткой
+  header.offset = (uint64_t)offset;  // куда блок должен попасть
+  header.generation = generation;  // какая это запись
+  header.crc = 0;  // заполняется ниже
+  header.reserved = 0;  // выравнивание
+  memcpy(block, &header, sizeof(header));  // метка в начале блока
+  uint64_t seed = (uint64_t)offset * SPLITMIX_STEP ^ generation ^ IO_VERIFY_MAGIC;  // зерно из смещения и номера
+  uint64_t state0 = seed | 1U;  // четыре независимых xorshift64, чтобы шаги не ждали друг друга;
+  uint64_t state1 = (seed + SPLITMIX_STEP) | 1U;  // в локальных переменных, а не в массиве, — иначе -O3
+  uint64_t state2 = (seed + 2 * SPLITMIX_STEP) | 1U;  // гоняет состояние через память;
+  uint64_t state3 = (seed + 3 * SPLITMIX_STEP) | 1U;  // младший бит — xorshift не выходит из нуля
+  size_t position = sizeof(header);  // заполняем после метки
+  for (; position + 32 <= block_size; position += 32) {  // по 32 байта за шаг
+    state0 = xorshift64(state0);  // шаг первого генератора
+    state1 = xorshift64(state1);  // шаг второго генератора
+    state2 = xorshift64(state2);  // шаг третьего генератора
+    state3 = xorshift64(state3);  // шаг четвёртого генератора
+    memcpy(block + position, &state0, 8);  // байты 0–7 шага
+    memcpy(block + position + 8, &state1, 8);  // байты 8–15 шага
+    memcpy(block + position + 16, &state2, 8);  // байты 16–23 шага
+    memcpy(block + position + 24, &state3, 8);  // байты 24–31 шага
+  }  // конец основного заполнения
+  for (; position < block_size; ++position) {  // хвост, если блок не кратен 32
+    state0 = xorshift64(state0);  // по состоянию на байт, хвост короткий
+    block[position] = (unsigned char)state0;  // младший байт состояния
+  }  // конец хвоста
+  uint32_t crc = verify_crc(block, block_size);  // сумма блока
+  memcpy(block + offsetof(io_verify_header_t, crc), &crc, sizeof(crc));  // записываем её в метку
+}  // конец verify_fill
+
+// verify_is_blank() — 1, если блок из одних нулей: дыра или ещё не записанная часть файла
+int verify_is_blank(const unsigned char* block, size_t block_size) {  // у блока с меткой первый же байт magic не нулевой
+  size_t position = 0;  // проверенные байты
+  for (position = 0; position < block_size; ++position) {  // до первого ненулевого байта
+    if (block[position] != 0) {  // блок что-то содержит
+      return 0;  // не пустой
+    }  // конец проверки байта
+  }  // конец обхода блока
+  return 1;  // одни нули
+}  // конец verify_is_blank
+
+// verify_check() — причина, по которой прочитанный блок испорчен, или NULL
+const char* verify_check(const unsigned char* block, size_t block_size, off_t offset, uint64_t min_generation, uint64_t* generation) {  // generation получает номер записи из метки
+  io_verify_header_t header;  // метка блока
+  memcpy(&header, block, sizeof(header));  // буфер выровнен, но копия не зависит от этого
+  *generation = header.generation;  // для сообщения об ошибке
+  if (header.magic != IO_VERIFY_MAGIC) {  // блок записан не с --verify или затёрт
+    return verify_is_blank(block, block_size) ? "blank block" : "no verify header";  // блок не записан или метки нет
+  }  // конец проверки метки
+  if (header.offset != (uint64_t)offset) {  // блок предназначался другому месту файла
+    return "misdirected block";  // запись не туда или чтение не оттуда
+  }  // конец проверки смещения
+  if (header.crc != verify_crc(block, block_size)) {  // содержимое изменилось после записи
+    return "checksum mismatch";  // порча данных
+  }  // конец проверки суммы
+  if (header.generation < min_generation) {  // прочитана версия старее последней завершённой записи
+    return "stale block";  // устаревшие данные
+  }  // конец проверки номера
+  return NULL;  // блок цел
+}  // конец verify_check
+
+// ------------------------------ СТАТИСТИКА ------------------------------  // гистограммы задержек и отчёты
+/*
+ * Каждый поток записывает задержку каждой операции в свою гистограмму
+ * io_histogram_t, поэтому запись не требует синхронизации. После повтора,
+ * пока потоки ждут на барьере следующего, главный поток сливает их
+ * гистограммы в гистограмму повтора, а её — в итоговую. Процентили берутся
+ * как верхняя граница корзины, в которую попал нужный ранг, но не больше
+ * наблюдавшегося максимума.
+ */
+
+// histogram_reset() — очищает гистограмму перед новым набором значений
+void histogram_reset(io_histogram_t* histogram) {  // все счётчики и сумма становятся нулевыми
+  memset(histogram, 0, sizeof(*histogram));  // обнуляем корзины и сводные поля
+  histogram->min_ns = UINT64_MAX;  // любое значение окажется меньше
+}  // конец histogram_reset
+
+// histogram_bucket() — номер корзины значения
+size_t histogram_bucket(uint64_t value) {  // лог-линейная схема: степень двойки и положение внутри неё
+  if (value < IO_LATENCY_SUB_COUNT) {  // малые значения хранятся точно, по корзине на значение
+    return (size_t)value;  // номер корзины совпадает со значением
+  }  // конец ветки малых значений
+  int magnitude = 63 - __builtin_clzll(value);  // номер старшего единичного бита
+  int shift = magnitude - IO_LATENCY_SUB_BITS;  // сколько младших битов отбрасывает корзина
+  return (size_t)(shift + 1) * IO_LATENCY_SUB_COUNT + (size_t)((value >> shift) - IO_LATENCY_SUB_COUNT);  // группа степени и корзина в ней
+}  // конец histogram_bucket
+
+// histogram_bucket_upper() — наибольшее значение, попадающее в корзину
+uint64_t histogram_bucket_upper(size_t bucket) {  // обратное к histogram_bucket
+  if (bucket < IO_LATENCY_SUB_COUNT) {  // точные корзины малых значений
+    return (uint64_t)bucket;  // корзина содержит ровно одно значение
+  }  // конец ветки малых значений
+  int shift = (int)(bucket / IO_LATENCY_SUB_COUNT) - 1;  // отброшенные младшие биты группы
+  uint64_t low = (uint64_t)(bucket % IO_LATENCY_SUB_COUNT + IO_LATENCY_SUB_COUNT) << shift;  // нижняя граница корзины
+  return low + ((uint64_t)1 << shift) - 1;  // верхняя граница корзины
+}  // конец histogram_bucket_upper
+
+// histogram_record() — добавляет одно значение
+void histogram_record(io_histogram_t* histogram, uint64_t value) {  // вызывается на каждую операцию, поэтому без ветвлений сверх необходимого
+  ++histogram->counts[histogram_bucket(value)];  // значение в свою корзину
+  ++histogram->count;  // общее число значений
+  histogram->sum_ns += (double)value;  // сумма для среднего
+  if (value < histogram->min_ns) {  // новое наименьшее
+    histogram->min_ns = value;  // запоминаем минимум
+  }  // конец обновления минимума
+  if (value > histogram->max_ns) {  // новое наибольшее
+    histogram->max_ns = value;  // запоминаем максимум
+  }  // конец обновления максимума
+}  // конец histogram_record
+
+// histogram_merge() — добавляет все значения source в target
+void histogram_merge(io_histogram_t* target, const io_histogram_t* source) {  // сложение гистограмм покорзинно
+  size_t bucket = 0;  // номер корзины
+  for (bucket = 0; bucket < IO_LATENCY_BUCKETS; ++bucket) {  // складываем счётчики корзин
+    target->counts[bucket] += source->counts[bucket];  // значения корзины
+  }  // конец сложения корзин
+  target->count += source->count;  // общее число значений
+  target->sum_ns += source->sum_ns;  // сумма значений
+  if (source->min_ns < target->min_ns) {  // минимум источника меньше
+    target->min_ns = source->min_ns;  // берём его
+  }  // конец слияния минимума
+  if (source->max_ns > target->max_ns) {  // максимум источника больше
+    target->max_ns = source->max_ns;  // берём его
+  }  // конец слияния максимума
+}  // конец histogram_merge
+
+// histogram_percentile() — значение, не меньше которого percentile процентов значений
+uint64_t histogram_percentile(const io_histogram_t* histogram, double percentile) {  // percentile от 0 до 100
+  if (histogram->count == 0) {  // пустая гистограмма
+    return 0;  // процентилей нет
+  }  // конец проверки пустоты
+  uint64_t rank = (uint64_t)(percentile / 100.0 * (double)histogram->count + 0.5);  // ранг искомого значения
+  if (rank < 1) {  // ранг считается с единицы
+    rank = 1;  // наименьший допустимый ранг
+  }  // конец коррекции ранга
+  uint64_t seen = 0;  // значения в просмотренных корзинах
+  size_t bucket = 0;  // номер корзины
+  for (bucket = 0; bucket < IO_LATENCY_BUCKETS; ++bucket) {  // накапливаем счётчики до нужного ранга
+    seen += histogram->counts[bucket];  // значения текущей корзины
+    if (seen >= rank) {  // ранг попал в эту корзину
+      uint64_t upper = histogram_bucket_upper(bucket);  // верхняя граница корзины
+      return upper < histogram->max_ns ? upper : histogram->max_ns;  // граница не выше наблюдавшегося максимума
+    }  // конец проверки ранга
+  }  // конец перебора корзин
+  return histogram->max_ns;  // недостижимо при согласованных счётчиках
+}  // конец histogram_percentile
+
+/* io_report_t — итоги повтора или всего запуска */
+typedef struct {
+  double elapsed;  // общее время в секундах
+  double ops;  // число операций
+  double bytes;  // перенесённые байты
+  size_t errors;  // операции с ошибкой
+  size_t short_ops;  // укороченные операции
+  io_histogram_t latency;  // задержки операций
+  int has_lag;  // 1 — отчёт открытого цикла содержит опоздания постановки
+  io_histogram_t lag;  // опоздания постановки операций против расписания
+  uint64_t minor_faults;  // страничные отказы без чтения с диска
+  uint64_t major_faults;  // страничные отказы с чтением с диска
+  int has_verify;  // 1 — отчёт содержит результат проверки данных
+  size_t verify_errors;  // прочитанные блоки, не прошедшие проверку
+  size_t verify_unwritten;  // прочитанные нулевые блоки, куда ещё не писали
+  int has_cache;  // 1 — отчёт содержит счётчики кэша vtpc
+  uint64_t cache_hits;  // попадания в кэш vtpc
+  uint64_t cache_misses;  // промахи кэша vtpc
+} io_report_t;
+
+// print_report_text() — строка производительности и строка задержек отчёта для человека
+void print_report_text(const char* label, const io_report_t* report) {  // label — «Iteration N» или «Total»
+  const io_histogram_t* latency = &report->latency;  // гистограмма задержек отчёта
+  printf(  // печатаем пропускную способность
+      "IO: %s: %.2f MB/s, %.0f IOPS\n",  // метка, мегабайты и операции в секунду
+      label,  // метка отчёта
+      report->bytes / report->elapsed / BYTES_PER_MB,  // мегабайты в секунду
+      report->ops / report->elapsed  // операции в секунду
+  );  // конец строки производительности
+  printf(  // печатаем задержки в микросекундах и ошибки
+      "IO:   latency us: min %.1f, mean %.1f, p50 %.1f, p90 %.1f, p99 %.1f, p99.9 %.1f, max %.1f; errors %zu, short %zu\n",  // сводка распределения
+      latency->count ? (double)latency->min_ns / NSEC_PER_USEC : 0.0,  // минимум
+      latency->count ? latency->sum_ns / (double)latency->count / NSEC_PER_USEC : 0.0,  // среднее
+      (double)histogram_percentile(latency, 50.0) / NSEC_PER_USEC,  // медиана
+      (double)histogram_percentile(latency, 90.0) / NSEC_PER_USEC,  // 90-й процентиль
+      (double)histogram_percentile(latency, 99.0) / NSEC_PER_USEC,  // 99-й процентиль
+      (double)histogram_percentile(latency, 99.9) / NSEC_PER_USEC,  // 99.9-й процентиль
+      (double)latency->max_ns / NSEC_PER_USEC,  // максимум
+      report->errors,  // операции с ошибкой
+      report->short_ops  // укороченные операции
+  );  // конец строки задержек
+  if (report->has_lag) {  // открытый цикл: сколько из задержки пришлось на опоздание постановки
+    const io_histogram_t* lag = &report->lag;  // гистограмма опозданий
+    printf(  // опоздания в микросекундах
+        "IO:   schedule lag us: mean %.1f, p50 %.1f, p99 %.1f, max %.1f\n",  // сводка распределения
+        lag->count ? lag->sum_ns / (double)lag->count / NSEC_PER_USEC : 0.0,  // среднее
+        (double)histogram_percentile(lag, 50.0) / NSEC_PER_USEC,  // медиана
+        (double)histogram_percentile(lag, 99.0) / NSEC_PER_USEC,  // 99-й процентиль
+        (double)lag->max_ns / NSEC_PER_USEC  // максимум
+    );  // конец строки опозданий
+  }  // конец отчёта опозданий
+  printf(  // печатаем страничные отказы процесса: их порождает mmap, а не pread
+      "IO:   page faults: minor %llu, major %llu\n",  // отказы без диска и с диском
+      (unsigned long long)report->minor_faults,  // отказы без чтения с диска
+      (unsigned long long)report->major_faults  // отказы с чтением с диска
+  );  // конец строки отказов
+  if (report->has_verify) {  // блоки проверялись
+    printf("IO:   verify: %zu bad block(s), %zu never written\n", report->verify_errors, report->verify_unwritten);  // испорченные и ещё не записанные блоки
+  }  // конец отчёта проверки
+  if (report->has_cache) {  // операции шли через кэш vtpc
+    uint64_t accesses = report->cache_hits + report->cache_misses;  // все обращения к страницам
+    printf(  // печатаем долю попаданий рядом с пропускной способностью
+        "IO:   vtpc: hit ratio %.2f%% (hits %llu, misses %llu)\n",  // доля и сами счётчики
+        accesses ? 100.0 * (double)report->cache_hits / (double)accesses : 0.0,  // доля попаданий в процентах
+        (unsigned long long)report->cache_hits,  // попадания
+        (unsigned long long)report->cache_misses  // промахи
+    );  // конец строки кэша
+  }  // конец отчёта кэша
+}  // конец print_report_text
+
+// print_json_string() — строка в кавычках с экранированием по правилам JSON
+void print_json_string(const char* str) {  // str приходит из командной строки и может содержать что угодно
+  putchar('"');  // открывающая кавычка
+  for (const unsigned char* c = (const unsigned char*)str; *c; ++c) {  // байты UTF-8 выше 0x7f идут как есть
+    if (*c == '"' || *c == '\\') {  // кавычка и обратная косая черта
+      printf("\\%c", *c);  // экранируем обратной косой чертой
+    } else if (*c == '\n') {  // перевод строки
+      fputs("\\n", stdout);  // короткая форма
+    } else if (*c == '\t') {  // табуляция
+      fputs("\\t", stdout);  // короткая форма
+    } else if (*c < 0x20) {  // прочие управляющие символы
+      printf("\\u%04x", *c);  // только через код
+    } else {  // обычный символ
+      putchar(*c);  // без изменений
+    }  // конец разбора символа
+  }  // конец строки
+  putchar('"');  // закрывающая кавычка
+}  // конец print_json_string
+
+// print_report_json() — поля отчёта как члены JSON-объекта, без фигурных скобок
+void print_report_json(const io_report_t* report) {  // вызывающий окружает поля скобками и добавляет свои
+  const io_histogram_t* latency = &report->latency;  // гистограмма задержек отчёта
+  printf(  // печатаем производительность, ошибки и задержки
+      "\"elapsed_s\": %.6f, \"ops\": %.0f, \"iops\": %.1f, \"mb_per_s\": %.3f, \"errors\": %zu, \"short\": %zu, "  // сводные поля
+      "\"latency_us\": {\"min\": %.3f, \"mean\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"p99_9\": %.3f, \"max\": %.3f}",  // распределение задержек
+      report->elapsed,  // общее время
+      report->ops,  // число операций
+      report->ops / report->elapsed,  // операции в секунду
+      report->bytes / report->elapsed / BYTES_PER_MB,  // мегабайты в секунду
+      report->errors,  // операции с ошибкой
+      report->short_ops,  // укороченные операции
+      latency->count ? (double)latency->min_ns / NSEC_PER_USEC : 0.0,  // минимум
+      latency->count ? latency->sum_ns / (double)latency->count / NSEC_PER_USEC : 0.0,  // среднее
+      (double)histogram_percentile(latency, 50.0) / NSEC_PER_USEC,  // медиана
+      (double)histogram_percentile(latency, 90.0) / NSEC_PER_USEC,  // 90-й процентиль
+      (double)histogram_percentile(latency, 99.0) / NSEC_PER_USEC,  // 99-й процентиль
+      (double)histogram_percentile(latency, 99.9) / NSEC_PER_USEC,  // 99.9-й процентиль
+      (double)latency->max_ns / NSEC_PER_USEC  // максимум
+  );  // конец полей отчёта
+  if (report->has_lag) {  // открытый цикл
+    const io_histogram_t* lag = &report->lag;  // гистограмма опозданий
+    printf(  // опоздания постановки отдельным объектом
+        ", \"schedule_lag_us\": {\"mean\": %.3f, \"p50\": %.3f, \"p99\": %.3f, \"max\": %.3f}",  // распределение опозданий
+        lag->count ? lag->sum_ns / (double)lag->count / NSEC_PER_USEC : 0.0,  // среднее
+        (double)histogram_percentile(lag, 50.0) / NSEC_PER_USEC,  // медиана
+        (double)histogram_percentile(lag, 99.0) / NSEC_PER_USEC,  // 99-й процентиль
+        (double)lag->max_ns / NSEC_PER_USEC  // максимум
+    );  // конец полей опозданий
+  }  // конец отчёта опозданий
+  printf(  // страничные отказы процесса
+      ", \"page_faults\": {\"minor\": %llu, \"major\": %llu}",  // отказы без диска и с диском
+      (unsigned long long)report->minor_faults,  // отказы без чтения с диска
+      (unsigned long long)report->major_faults  // отказы с чтением с диска
+  );  // конец полей отказов
+  if (report->has_verify) {  // блоки проверялись
+    printf(", \"verify_errors\": %zu, \"verify_unwritten\": %zu", report->verify_errors, report->verify_unwritten);  // испорченные и ещё не записанные блоки
+  }  // конец отчёта проверки
+  if (report->has_cache) {  // операции шли через кэш vtpc
+    uint64_t accesses = report->cache_hits + report->cache_misses;  // все обращения к страницам
+    printf(  // счётчики кэша отдельным объектом
+        ", \"vtpc\": {\"hits\": %llu, \"misses\": %llu, \"hit_ratio\": %.4f}",  // попадания, промахи и доля
+        (unsigned long long)report->cache_hits,  // попадания
+        (unsigned long long)report->cache_misses,  // промахи
+        accesses ? (double)report->cache_hits / (double)accesses : 0.0  // доля попаданий
+    );  // конец полей кэша
+  }  // конец отчёта кэша
+}  // конец print_report_json
+
+// ------------------------------ ДВИЖКИ ВВОДА-ВЫВОДА ------------------------------  // способы выполнения операций
+/*
+ * Движок отделяет выбор блоков от способа их чтения и записи. psync
+ * выполняет операции блокирующими pread/pwrite по одной, поэтому в полёте
+ * всегда не больше одной операции. С --batch N psync копит N операций в
+ * очереди и выполняет каждый непрерывный участок из них одним preadv или
+ * pwritev в кольцо из N выровненных буферов; с --rwf — через preadv2 и
+ * pwritev2 с флагами RWF_HIPRI или RWF_NOWAIT. У векторного вызова одно
+ * смещение в файле, поэтому пакет сокращает число системных вызовов при
+ * последовательном доступе, а случайные блоки остаются по вызову на блок:
+ * сравнение этих двух случаев и отделяет цену вызова от работы устройства. io_uring и libaio отправляют в ядро до
+ * --iodepth операций сразу и забирают завершения по мере готовности; оба
+ * реализованы прямо на системных вызовах, без liburing и libaio. Linux AIO
+ * по-настоящему асинхронен только с O_DIRECT: для файлов в страничном кэше
+ * io_submit выполняет операцию синхронно. vtpc выполняет те же блокирующие
+ * операции через кэш страниц из lab/vtpc: у каждого потока свой хэндл
+ * vtpc_open, потому что позиция vtpc_lseek принадлежит хэндлу, а сами
+ * страницы файла кэш делит между хэндлами. Кэш работает с диском в обход
+ * страничного кэша ОС, поэтому --direct на него не влияет. mmap отображает
+ * диапазон потока в память и копирует блоки memcpy между отображением и
+ * буферами: вместо системного вызова на операцию — страничный отказ на
+ * первое обращение к странице, что и видно по счётчикам отказов в отчёте.
+ * Отображение обрезается по концу файла, чтобы чтение за ним давало
+ * укороченную операцию, а не SIGBUS.
+ */
+
+/* psync_ctx_t — очередь psync: операции, поставленные prepare и ещё не выполненные */
+typedef struct {
+  int* slots;  // номера буферов поставленных операций
+  off_t* offsets;  // смещения поставленных операций
+  int* writes;  // 1 — запись, 0 — чтение для каждой поставленной операции
+  int count;  // число поставленных операций
+  int fd;  // дескриптор операций: общий дескриптор для psync, хэндл потока для vtpc
+  struct iovec* iov;  // буферы непрерывного участка для preadv/pwritev
+} psync_ctx_t;
+
+// psync_init() — выделяет очередь на iodepth операций
+int psync_init(io_task_t* task) {  // вызывается главным потоком до запуска рабочих потоков
+  psync_ctx_t* ctx = calloc(1, sizeof(psync_ctx_t));  // состояние движка потока
+  if (!ctx) {  // нехватка памяти
+    return -1;  // errno выставлен calloc
+  }  // конец проверки выделения
+  ctx->slots = calloc((size_t)task->iodepth, sizeof(int));  // место под номера буферов
+  ctx->offsets = calloc((size_t)task->iodepth, sizeof(off_t));  // место под смещения
+  ctx->writes = calloc((size_t)task->iodepth, sizeof(int));  // место под виды операций
+  ctx->iov = calloc((size_t)task->iodepth, sizeof(struct iovec));  // место под буферы пакета
+  ctx->fd = task->fd;  // psync работает через общий дескриптор
+  task->engine_ctx = ctx;  // сохраняем состояние до проверки, чтобы destroy освободил частично выделенное
+  return ctx->slots && ctx->offsets && ctx->writes && ctx->iov ? 0 : -1;  // успех только при выделении всех массивов
+}  // конец psync_init
+
+// psync_prepare() — запоминает операцию до вызова complete
+void psync_prepare(io_task_t* task, int slot, off_t offset, int is_write) {  // операция выполняется позже, в complete
+  psync_ctx_t* ctx = (psync_ctx_t*)task->engine_ctx;  // очередь потока
+  ctx->slots[ctx->count] = slot;  // номер буфера операции
+  ctx->offsets[ctx->count] = offset;  // смещение операции
+  ctx->writes[ctx->count] = is_write;  // вид операции
+  ++ctx->count;  // операция поставлена
+}  // конец psync_prepare
+
+// psync_complete() — выполняет все поставленные операции блокирующими вызовами
+int psync_complete(io_task_t* task, int* slots, ssize_t* results, uint64_t deadline) {  // каждая операция завершается до начала следующей
+  (void)deadline;  // блокирующие вызовы завершаются сразу, ждать больше нечего
+  psync_ctx_t* ctx = (psync_ctx_t*)task->engine_ctx;  // очередь потока
+  int index = 0;  // первая операция непрерывного участка
+  while (index < ctx->count) {  // выполняем участки в порядке постановки
+    int run = 1;  // операций в участке
+    while (index + run < ctx->count && run < IOV_MAX && ctx->writes[index + run] == ctx->writes[index] && ctx->offsets[index + run] == ctx->offsets[index] + (off_t)run * (off_t)task->block_size) {  // следующая операция того же вида продолжает участок
+      ++run;  // присоединяем её
+    }  // конец поиска участка
+    int part = 0;  // номер операции в участке
+    for (part = 0; part < run; ++part) {  // собираем буферы участка
+      ctx->iov[part].iov_base = (char*)task->buffer + (size_t)ctx->slots[index + part] * task->block_size;  // буфер операции
+      ctx->iov[part].iov_len = task->block_size;  // длина операции
+    }  // конец сборки
+    int is_write = ctx->writes[index];  // вид операций участка
+    off_t offset = ctx->offsets[index];  // начало участка в файле
+    ssize_t done = -1;  // байты участка или -1
+#if defined(RWF_NOWAIT)  // preadv2 и pwritev2 есть только в Linux
+    if (task->rwf_flags) {  // запрошены флаги RWF_*
+      done = is_write ? pwritev2(ctx->fd, ctx->iov, run, offset, task->rwf_flags) : preadv2(ctx->fd, ctx->iov, run, offset, task->rwf_flags);  // векторный вызов с флагами
+    } else  // без флагов — обычные вызовы ниже
+#endif  // конец preadv2
+    if (run == 1) {  // одиночная операция
+      done = is_write ? pwrite(ctx->fd, ctx->iov[0].iov_base, task->block_size, offset) : pread(ctx->fd, ctx->iov[0].iov_base, task->block_size, offset);  // позиционная запись или чтение блока
+    } else {  // несколько соседних блоков
+      done = is_write ? pwritev(ctx->fd, ctx->iov, run, offset) : preadv(ctx->fd, ctx->iov, run, offset);  // один векторный вызов на участок
+    }  // конец выбора вызова
+    for (part = 0; part < run; ++part) {  // раскладываем результат участка по операциям
+      ssize_t before = (ssize_t)part * (ssize_t)task->block_size;  // байты участка до этой операции
+      ssize_t rest = done - before;  // байты, пришедшиеся на эту операцию и следующие
+      slots[index + part] = ctx->slots[index + part];  // возвращаем номер буфера
+      if (done < 0) {  // ошибка относится ко всем операциям участка
+        results[index + part] = -errno;  // приводим ошибку к форме -errno, как у асинхронных движков
+      } else {  // укороченный участок укорачивает только хвостовые операции
+        results[index + part] = rest <= 0 ? 0 : rest < (ssize_t)task->block_size ? rest : (ssize_t)task->block_size;  // байты этой операции
+      }  // конец разбора результата
+    }  // конец раскладки
+    index += run;  // следующий участок
+  }  // конец выполнения очереди
+  int completed = ctx->count;  // все поставленные операции завершены
+  ctx->count = 0;  // очередь пуста
+  return completed;  // число завершений
+}  // конец psync_complete
+
+// psync_destroy() — освобождает очередь
+void psync_destroy(io_task_t* task) {  // вызывается после завершения потока
+  psync_ctx_t* ctx = (psync_ctx_t*)task->engine_ctx;  // очередь потока
+  if (ctx) {  // состояние могло не создаться
+    free(ctx->slots);  // номера буферов
+    free(ctx->offsets);  // смещения
+    free(ctx->writes);  // виды операций
+    free(ctx->iov);  // буферы пакета
+    free(ctx);  // само состояние
+  }  // конец освобождения
+  task->engine_ctx = NULL;  // состояние больше не действительно
+}  // конец psync_destroy
+
+// vtpc_engine_init() — очередь psync и собственный хэндл кэша для потока
+int vtpc_engine_init(io_task_t* task) {  // кэш уже настроен vtpc_configure в main
+  if (psync_init(task) != 0) {  // очередь устроена так же, как у psync
+    return -1;  // errno выставлен calloc
+  }  // конец создания очереди
+  psync_ctx_t* ctx = (psync_ctx_t*)task->engine_ctx;  // очередь потока
+  ctx->fd = vtpc_open(task->file, task->rwmixread < 100 ? O_RDWR : O_RDONLY, 0);  // хэндл с собственной позицией
+  return ctx->fd < 0 ? -1 : 0;  // errno выставлен vtpc_open
+}  // конец vtpc_engine_init
+
+// vtpc_engine_complete() — выполняет поставленные операции через кэш
+int vtpc_engine_complete(io_task_t* task, int* slots, ssize_t* results, uint64_t deadline) {  // как psync_complete, но позиция выставляется отдельно
+  psync_ctx_t* ctx = (psync_ctx_t*)task->engine_ctx;  // очередь потока
+  (void)deadline;  // операции кэша блокирующие
+  int index = 0;  // номер выполняемой операции
+  for (index = 0; index < ctx->count; ++index) {  // выполняем операции в порядке постановки
+    char* buffer = (char*)task->buffer + (size_t)ctx->slots[index] * task->block_size;  // буфер операции
+    ssize_t done = -1;  // байты или -1
+    if (vtpc_lseek(ctx->fd, ctx->offsets[index], SEEK_SET) >= 0) {  // у кэша нет позиционных вызовов
+      done = ctx->writes[index] ? vtpc_write(ctx->fd, buffer, task->block_size) : vtpc_read(ctx->fd, buffer, task->block_size);  // запись или чтение блока через кэш
+    }  // конец позиционирования
+    slots[index] = ctx->slots[index];  // возвращаем номер буфера
+    results[index] = done < 0 ? -errno : done;  // приводим ошибку к форме -errno
+  }  // конец выполнения очереди
+  int completed = ctx->count;  // все поставленные операции завершены
+  ctx->count = 0;  // очередь пуста
+  return completed;  // число завершений
+}  // конец vtpc_engine_complete
+
+// vtpc_engine_destroy() — закрывает хэндл кэша и освобождает очередь
+void vtpc_engine_destroy(io_task_t* task) {  // грязные страницы записываются на диск при закрытии, вне замеров
+  psync_ctx_t* ctx = (psync_ctx_t*)task->engine_ctx;  // очередь потока
+  if (ctx && ctx->fd >= 0) {  // хэндл мог не открыться
+    vtpc_close(ctx->fd);  // закрываем хэндл потока
+  }  // конец закрытия хэндла
+  psync_destroy(task);  // освобождаем очередь
+}  // конец vtpc_engine_destroy
+
+/* mmap_ctx_t — очередь psync и отображение диапазона потока */
+typedef struct {
+  psync_ctx_t queue;  // очередь операций; первое поле, чтобы psync_prepare работал с этим состоянием
+  char* base;  // начало отображения
+  off_t map_start;  // смещение начала отображения в файле, кратное размеру страницы
+  size_t map_len;  // длина отображения; за ним конец файла или диапазона
+} mmap_ctx_t;
+
+// mmap_init() — отображает диапазон потока и передаёт ядру совет --madvise
+int mmap_init(io_task_t* task) {  // вызывается главным потоком, поэтому отказы MAP_POPULATE не попадают в замер
+  mmap_ctx_t* ctx = calloc(1, sizeof(mmap_ctx_t));  // состояние движка потока
+  if (!ctx) {  // нехватка памяти
+    return -1;  // errno выставлен calloc
+  }  // конец проверки выделения
+  task->engine_ctx = ctx;  // сохраняем состояние до остальных шагов, чтобы destroy освободил частично созданное
+  ctx->queue.slots = calloc((size_t)task->iodepth, sizeof(int));  // место под номера буферов
+  ctx->queue.offsets = calloc((size_t)task->iodepth, sizeof(off_t));  // место под смещения
+  ctx->queue.writes = calloc((size_t)task->iodepth, sizeof(int));  // место под виды операций
+  if (!ctx->queue.slots || !ctx->queue.offsets || !ctx->queue.writes) {  // без очереди движок не работает
+    return -1;  // errno выставлен calloc
+  }  // конец проверки очереди
+
+  struct stat file_stat;  // размер файла ограничивает отображение
+  if (fstat(task->fd, &file_stat) != 0) {  // запрос метаданных не удался
+    return -1;  // errno выставлен fstat
+  }  // конец проверки fstat
+  off_t page_size = (off_t)sysconf(_SC_PAGESIZE);  // смещение отображения кратно странице
+  off_t slice_end = task->slice_start + task->slice_blocks * (off_t)task->block_size;  // конец диапазона потока
+  off_t map_end = slice_end < file_stat.st_size ? slice_end : file_stat.st_size;  // за концом файла отображать нельзя
+  ctx->map_start = task->slice_start / page_size * page_size;  // начало округляем вниз до страницы
+  if (map_end <= ctx->map_start) {  // диапазон целиком за концом файла
+    return 0;  // отображать нечего: все операции будут укороченными
+  }  // конец проверки пустого диапазона
+  ctx->map_len = (size_t)(map_end - ctx->map_start);  // длина отображения
+  int prot = PROT_READ | (task->rwmixread < 100 ? PROT_WRITE : 0);  // запись в отображение только при записях
+  int flags = MAP_SHARED;  // записи попадают в файл
+#ifdef MAP_POPULATE  // предзагрузка есть только в Linux
+  if (task->is_populate) {  // --populate
+    flags |= MAP_POPULATE;  // загружаем и отображаем все страницы сразу
+  }  // конец предзагрузки
+#endif  // конец MAP_POPULATE
+  void* base = mmap(NULL, ctx->map_len, prot, flags, task->fd, ctx->map_start);  // отображаем диапазон потока
+  if (base == MAP_FAILED) {  // отображение не удалось
+    return -1;  // errno выставлен mmap
+  }  // конец проверки mmap
+  ctx->base = (char*)base;  // запоминаем отображение
+  if (task->madvise_advice >= 0 && madvise(base, ctx->map_len, task->madvise_advice) != 0) {  // совет ядру о характере доступа
+    perror("Warning: madvise");  // например, MADV_HUGEPAGE для файлов на этой файловой системе; продолжаем без совета
+  }  // конец совета
+  return 0;  // отображение готово
+}  // конец mmap_init
+
+// mmap_complete() — копирует блоки поставленных операций между отображением и буферами
+int mmap_complete(io_task_t* task, int* slots, ssize_t* results, uint64_t deadline) {  // операции завершаются сразу, как у psync
+  mmap_ctx_t* ctx = (mmap_ctx_t*)task->engine_ctx;  // состояние потока
+  (void)deadline;  // ждать нечего
+  int index = 0;  // номер выполняемой операции
+  for (index = 0; index < ctx->queue.count; ++index) {  // выполняем операции в порядке постановки
+    char* buffer = (char*)task->buffer + (size_t)ctx->queue.slots[index] * task->block_size;  // буфер операции
+    size_t from = (size_t)(ctx->queue.offsets[index] - ctx->map_start);  // смещение блока в отображении
+    size_t length = from < ctx->map_len ? ctx->map_len - from : 0;  // сколько байтов блока лежит до конца файла
+    length = length < task->block_size ? length : task->block_size;  // не больше блока
+    if (ctx->queue.writes[index]) {  // запись блока
+      memcpy(ctx->base + from, buffer, length);  // страничный отказ при первом обращении к странице
+    } else {  // чтение блока
+      memcpy(buffer, ctx->base + from, length);  // страничный отказ при первом обращении к странице
+    }  // конец копирования
+    slots[index] = ctx->queue.slots[index];  // возвращаем номер буфера
+    results[index] = (ssize_t)length;  // за концом файла операция укороченная
+  }  // конец выполнения очереди
+  int completed = ctx->queue.count;  // все поставленные операции завершены
+  ctx->queue.count = 0;  // очередь пуста
+  return completed;  // число завершений
+}  // конец mmap_complete
+
+// mmap_destroy() — снимает отображение и освобождает очередь
+void mmap_destroy(io_task_t* task) {  // грязные страницы ядро запишет само, вне замеров
+  mmap_ctx_t* ctx = (mmap_ctx_t*)task->engine_ctx;  // состояние потока
+  if (ctx && ctx->base) {  // отображение создано
+    munmap(ctx->base, ctx->map_len);  // снимаем его
+  }  // конец снятия отображения
+  psync_destroy(task);  // очередь устроена как у psync и лежит в начале состояния
+}  // конец mmap_destroy
+
+#if defined(__linux__)  // асинхронные движки доступны только в Linux
+
+/*
+ * uring_ctx_t — кольца io_uring, отображённые в память. Поток — единственный
+ * поставщик в очередь отправки и единственный потребитель очереди завершений,
+ * поэтому свои индексы он читает обычными загрузками, а индексы ядра —
+ * с семантикой acquire и публикует свои с release.
+ */
+typedef struct {
+  int ring_fd;  // дескриптор кольца
+  unsigned* sq_tail;  // хвост очереди отправки, его двигаем мы
+  unsigned* sq_mask;  // маска индексов очереди отправки
+  unsigned* sq_array;  // индексы записей sqes в порядке отправки
+  unsigned* cq_head;  // голова очереди завершений, её двигаем мы
+  unsigned* cq_tail;  // хвост очереди завершений, его двигает ядро
+  unsigned* cq_mask;  // маска индексов очереди завершений
+  struct io_uring_sqe* sqes;  // записи операций
+  struct io_uring_cqe* cqes;  // записи завершений
+  void* sq_ptr;  // отображение очереди отправки
+  size_t sq_size;  // его размер
+  void* cq_ptr;  // отображение очереди завершений, может совпадать с sq_ptr
+  size_t cq_size;  // его размер
+  size_t sqes_size;  // размер отображения записей
+  unsigned to_submit;  // поставленные, но ещё не отправленные операции
+  int has_ext_arg;  // 1 — ядро принимает тайм-аут ожидания в io_uring_enter (IORING_FEAT_EXT_ARG, Linux 5.11)
+} uring_ctx_t;
+
+// uring_init() — создаёт кольцо на iodepth операций и отображает его в память
+int uring_init(io_task_t* task) {  // вызывается главным потоком до запуска рабочих потоков
+  uring_ctx_t* ctx = calloc(1, sizeof(uring_ctx_t));  // состояние движка потока
+  if (!ctx) {  // нехватка памяти
+    return -1;  // errno выставлен calloc
+  }  // конец проверки выделения
+  ctx->ring_fd = -1;  // кольцо ещё не создано
+  task->engine_ctx = ctx;  // сохраняем состояние, чтобы destroy освободил частично созданное
+
+  struct io_uring_params params;  // параметры кольца, которые заполнит ядро
+  memset(&params, 0, sizeof(params));  // флаги по умолчанию
+  int ring_fd = (int)syscall(__NR_io_uring_setup, (unsigned)task->iodepth, &params);  // создаём кольцо
+  if (ring_fd < 0) {  // ядро без io_uring или запрет в песочнице
+    return -1;  // errno выставлен системным вызовом
+  }  // конец проверки создания
+  ctx->ring_fd = ring_fd;  // запоминаем дескриптор кольца
+  ctx->has_ext_arg = (params.features & IORING_FEAT_EXT_ARG) != 0;  // можно ли ждать завершений со сроком
+
+  ctx->sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);  // конец массива индексов очереди отправки
+  ctx->cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);  // конец массива завершений
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {  // обе очереди лежат в одном отображении
+    if (ctx->cq_size > ctx->sq_size) {  // отображение должно вместить большую из очередей
+      ctx->sq_size = ctx->cq_size;  // расширяем общее отображение
+    }  // конец выбора размера
+  }  // конец проверки общего отображения
+  ctx->sq_ptr = mmap(NULL, ctx->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);  // очередь отправки
+  if (ctx->sq_ptr == MAP_FAILED) {  // отображение не удалось
+    ctx->sq_ptr = NULL;  // destroy не будет его снимать
+    return -1;  // errno выставлен mmap
+  }  // конец проверки отображения очереди отправки
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {  // очередь завершений в том же отображении
+    ctx->cq_ptr = ctx->sq_ptr;  // переиспользуем отображение
+  } else {  // старые ядра отображают очереди раздельно
+    ctx->cq_ptr = mmap(NULL, ctx->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);  // очередь завершений
+    if (ctx->cq_ptr == MAP_FAILED) {  // отображение не удалось
+      ctx->cq_ptr = NULL;  // destroy не будет его снимать
+      return -1;  // errno выставлен mmap
+    }  // конец проверки отображения очереди завершений
+  }  // конец отображения очереди завершений
+  ctx->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);  // размер массива записей операций
+  ctx->sqes = mmap(NULL, ctx->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);  // записи операций
+  if (ctx->sqes == MAP_FAILED) {  // отображение не удалось
+    ctx->sqes = NULL;  // destroy не будет его снимать
+    return -1;  // errno выставлен mmap
+  }  // конец проверки отображения записей
+
+  char* sq = (char*)ctx->sq_ptr;  // база очереди отправки для смещений из params
+  char* cq = (char*)ctx->cq_ptr;  // база очереди завершений для смещений из params
+  ctx->sq_tail = (unsigned*)(sq + params.sq_off.tail);  // хвост очереди отправки
+  ctx->sq_mask = (unsigned*)(sq + params.sq_off.ring_mask);  // маска очереди отправки
+  ctx->sq_array = (unsigned*)(sq + params.sq_off.array);  // массив индексов
+  ctx->cq_head = (unsigned*)(cq + params.cq_off.head);  // голова очереди завершений
+  ctx->cq_tail = (unsigned*)(cq + params.cq_off.tail);  // хвост очереди завершений
+  ctx->cq_mask = (unsigned*)(cq + params.cq_off.ring_mask);  // маска очереди завершений
+  ctx->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);  // массив завершений
+  return 0;  // кольцо готово
+}  // конец uring_init
+
+// uring_prepare() — заполняет запись операции и публикует её в очереди отправки
+void uring_prepare(io_task_t* task, int slot, off_t offset, int is_write) {  // ядро увидит операцию при следующем io_uring_enter
+  uring_ctx_t* ctx = (uring_ctx_t*)task->engine_ctx;  // кольцо потока
+  unsigned tail = *ctx->sq_tail;  // хвост меняем только мы, поэтому читаем без барьера
+  unsigned index = tail & *ctx->sq_mask;  // ячейка для новой операции
+  struct io_uring_sqe* sqe = &ctx->sqes[index];  // запись операции
+  memset(sqe, 0, sizeof(*sqe));  // сбрасываем поля прошлой операции
+  sqe->opcode = is_write ? IORING_OP_WRITE : IORING_OP_READ;  // позиционная запись или чтение
+  sqe->fd = task->fd;  // общий дескриптор файла
+  sqe->addr = (unsigned long long)(uintptr_t)((char*)task->buffer + (size_t)slot * task->block_size);  // буфер операции
+  sqe->len = (unsigned)task->block_size;  // длина операции
+  sqe->off = (unsigned long long)offset;  // смещение в файле
+  sqe->user_data = (unsigned long long)slot;  // номер буфера вернётся в записи завершения
+  ctx->sq_array[index] = index;  // ставим запись в очередь отправки
+  __atomic_store_n(ctx->sq_tail, tail + 1, __ATOMIC_RELEASE);  // публикуем запись: ядро увидит её заполненной
+  ++ctx->to_submit;  // операцию нужно отправить
+}  // конец uring_prepare
+
+// uring_complete() — отправляет поставленные операции и забирает готовые завершения
+int uring_complete(io_task_t* task, int* slots, ssize_t* results, uint64_t deadline) {  // ждёт хотя бы одного завершения до срока deadline
+  uring_ctx_t* ctx = (uring_ctx_t*)task->engine_ctx;  // кольцо потока
+  int is_expired = deadline == 0 || (deadline != IO_WAIT_FOREVER && !ctx->has_ext_arg);  // без EXT_ARG срок не передать ядру: только опрашиваем, а вызывающий повторит
+  int completed = 0;  // число забранных завершений
+  while (completed == 0) {  // повторяем, пока не появится хотя бы одно завершение
+    unsigned head = *ctx->cq_head;  // голову меняем только мы
+    unsigned tail = __atomic_load_n(ctx->cq_tail, __ATOMIC_ACQUIRE);  // хвост двигает ядро; acquire делает видимыми сами записи
+    if (head == tail) {  // готовых завершений нет
+      if (is_expired && ctx->to_submit == 0) {  // срок вышел или ждать не просили, а отправлять нечего
+        return 0;  // завершений пока нет
+      }  // конец проверки опроса
+      unsigned flags = is_expired ? 0U : IORING_ENTER_GETEVENTS;  // ждём, только пока срок не вышел
+      struct __kernel_timespec timeout;  // оставшееся до срока время; ядро считает его от входа в вызов
+      struct io_uring_getevents_arg ext_arg;  // тайм-аут передаётся через расширенный аргумент
+      void* arg = NULL;  // без срока аргумента нет
+      size_t arg_size = 0;  // его размер
+      if (!is_expired && deadline != IO_WAIT_FOREVER) {  // ждём со сроком
+        uint64_t left_ns = remaining_ns(deadline);  // до срока, 0 — уже наступил
+        timeout.tv_sec = (long long)(left_ns / (uint64_t)NSEC_PER_SEC);  // целые секунды
+        timeout.tv_nsec = (long long)(left_ns % (uint64_t)NSEC_PER_SEC);  // остаток в наносекундах
+        memset(&ext_arg, 0, sizeof(ext_arg));  // маска сигналов не меняется
+        ext_arg.ts = (unsigned long long)(uintptr_t)&timeout;  // указатель на тайм-аут
+        flags |= IORING_ENTER_EXT_ARG;  // arg — io_uring_getevents_arg, а не маска сигналов
+        arg = &ext_arg;  // расширенный аргумент
+        arg_size = sizeof(ext_arg);  // ядро проверяет его размер
+      }  // конец тайм-аута
+      int entered = (int)syscall(__NR_io_uring_enter, ctx->ring_fd, ctx->to_submit, is_expired ? 0U : 1U, flags, arg, arg_size);  // отправляем очередь и до срока ждём завершения
+      if (entered < 0) {  // ошибка ожидания
+        if (errno == EINTR) {  // прерывание сигналом не ошибка
+          continue;  // ждём снова
+        }  // конец обработки EINTR
+        if (errno == ETIME) {  // срок наступил без завершений
+          is_expired = 1;  // ещё раз смотрим очередь и возвращаемся
+          continue;  // завершение могло прийти в последний момент
+        }  // конец обработки тайм-аута
+        return -1;  // errno выставлен системным вызовом
+      }  // конец проверки io_uring_enter
+      ctx->to_submit -= (unsigned)entered;  // io_uring_enter возвращает число отправленных операций
+      continue;  // перечитываем хвост очереди завершений
+    }  // конец ожидания
+    while (head != tail && completed < task->iodepth) {  // забираем все готовые завершения
+      struct io_uring_cqe* cqe = &ctx->cqes[head & *ctx->cq_mask];  // запись завершения
+      slots[completed] = (int)cqe->user_data;  // номер буфера завершившейся операции
+      results[completed] = cqe->res;  // байты или -errno
+      ++completed;  // завершение забрано
+      ++head;  // следующая запись
+    }  // конец перебора завершений
+    __atomic_store_n(ctx->cq_head, head, __ATOMIC_RELEASE);  // освобождаем записи для ядра
+  }  // конец цикла ожидания
+  if (ctx->to_submit > 0) {  // часть поставленных операций не отправлена, потому что завершения уже были готовы
+    int entered = (int)syscall(__NR_io_uring_enter, ctx->ring_fd, ctx->to_submit, 0U, 0U, NULL, 0);  // отправляем их без ожидания
+    if (entered > 0) {  // ошибку отправки увидим при следующем ожидании
+      ctx->to_submit -= (unsigned)entered;  // учитываем отправленные
+    }  // конец учёта отправки
+  }  // конец досылки
+  return completed;  // число завершений
+}  // конец uring_complete
+
+// uring_destroy() — снимает отображения и закрывает кольцо
+void uring_destroy(io_task_t* task) {  // вызывается после завершения потока
+  uring_ctx_t* ctx = (uring_ctx_t*)task->engine_ctx;  // кольцо потока
+  if (!ctx) {  // состояние могло не создаться
+    return;  // освобождать нечего
+  }  // конец проверки состояния
+  if (ctx->sqes) {  // записи операций отображены
+    munmap(ctx->sqes, ctx->sqes_size);  // снимаем отображение записей
+  }  // конец снятия записей
+  if (ctx->cq_ptr && ctx->cq_ptr != ctx->sq_ptr) {  // у очереди завершений своё отображение
+    munmap(ctx->cq_ptr, ctx->cq_size);  // снимаем его
+  }  // конец снятия очереди завершений
+  if (ctx->sq_ptr) {  // очередь отправки отображена
+    munmap(ctx->sq_ptr, ctx->sq_size);  // снимаем отображение
+  }  // конец снятия очереди отправки
+  if (ctx->ring_fd >= 0) {  // кольцо создано
+    close(ctx->ring_fd);  // закрываем кольцо
+  }  // конец закрытия кольца
+  free(ctx);  // освобождаем состояние
+  task->engine_ctx = NULL;  // состояние больше не действительно
+}  // конец uring_destroy
+
+/* aio_ctx_t — контекст Linux AIO: запросы по одному на буфер и очередь неотправленных */
+typedef struct {
+  aio_context_t aio;  // контекст ядра
+  struct iocb* iocbs;  // запросы, по одному на буфер
+  struct iocb** pending;  // поставленные, но не отправленные запросы
+  int pending_count;  // их число
+  struct io_event* events;  // место под завершения
+} aio_ctx_t;
+
+// aio_init() — создаёт контекст Linux AIO на iodepth операций
+int aio_init(io_task_t* task) {  // вызывается главным потоком до запуска рабочих потоков
+  aio_ctx_t* ctx = calloc(1, sizeof(aio_ctx_t));  // состояние движка потока
+  if (!ctx) {  // нехватка памяти
+    return -1;  // errno выставлен calloc
+  }  // конец проверки выделения
+  task->engine_ctx = ctx;  // сохраняем состояние, чтобы destroy освободил частично созданное
+  ctx->iocbs = calloc((size_t)task->iodepth, sizeof(struct iocb));  // запросы
+  ctx->pending = calloc((size_t)task->iodepth, sizeof(struct iocb*));  // очередь отправки
+  ctx->events = calloc((size_t)task->iodepth, sizeof(struct io_event));  // завершения
+  if (!ctx->iocbs || !ctx->pending || !ctx->events) {  // нехватка памяти
+    return -1;  // errno выставлен calloc
+  }  // конец проверки выделения
+  return (int)syscall(__NR_io_setup, (unsigned)task->iodepth, &ctx->aio);  // создаём контекст ядра
+}  // конец aio_init
+
+// aio_prepare() — заполняет запрос буфера и ставит его в очередь отправки
+void aio_prepare(io_task_t* task, int slot, off_t offset, int is_write) {  // ядро получит запрос в complete
+  aio_ctx_t* ctx = (aio_ctx_t*)task->engine_ctx;  // контекст потока
+  struct iocb* iocb = &ctx->iocbs[slot];  // буфер занят одним запросом, поэтому запрос берём по номеру буфера
+  memset(iocb, 0, sizeof(*iocb));  // сбрасываем поля прошлого запроса
+  iocb->aio_lio_opcode = is_write ? IOCB_CMD_PWRITE : IOCB_CMD_PREAD;  // позиционная запись или чтение
+  iocb->aio_fildes = (unsigned)task->fd;  // общий дескриптор файла
+  iocb->aio_buf = (unsigned long long)(uintptr_t)((char*)task->buffer + (size_t)slot * task->block_size);  // буфер операции
+  iocb->aio_nbytes = task->block_size;  // длина операции
+  iocb->aio_offset = offset;  // смещение в файле
+  iocb->aio_data = (unsigned long long)slot;  // номер буфера вернётся в завершении
+  ctx->pending[ctx->pending_count++] = iocb;  // запрос ждёт отправки
+}  // конец aio_prepare
+
+// aio_complete() — отправляет очередь через io_submit и ждёт завершений в io_getevents
+int aio_complete(io_task_t* task, int* slots, ssize_t* results, uint64_t deadline) {  // ждёт хотя бы одного завершения до срока deadline
+  aio_ctx_t* ctx = (aio_ctx_t*)task->engine_ctx;  // контекст потока
+  while (ctx->pending_count > 0) {  // отправляем, пока очередь не опустеет
+    int submitted = (int)syscall(__NR_io_submit, ctx->aio, (long)ctx->pending_count, ctx->pending);  // отправка очереди
+    if (submitted < 0) {  // ошибка отправки
+      if (errno == EINTR || errno == EAGAIN) {  // ядро временно не принимает запросы
+        break;  // сначала заберём завершения, потом отправим снова
+      }  // конец обработки временной ошибки
+      return -1;  // errno выставлен системным вызовом
+    }  // конец проверки отправки
+    ctx->pending_count -= submitted;  // ядро могло принять только часть очереди
+    memmove(ctx->pending, ctx->pending + submitted, (size_t)ctx->pending_count * sizeof(struct iocb*));  // сдвигаем оставшиеся в начало
+  }  // конец отправки
+  struct timespec timeout = {0, 0};  // нулевой тайм-аут: забрать только готовые завершения
+  int completed = -1;  // число завершений
+  do {  // ждём хотя бы одного завершения до срока
+    if (deadline != 0 && deadline != IO_WAIT_FOREVER) {  // ждём со сроком
+      uint64_t left_ns = remaining_ns(deadline);  // тайм-аут io_getevents относительный, поэтому пересчитываем после EINTR
+      timeout.tv_sec = (time_t)(left_ns / (uint64_t)NSEC_PER_SEC);  // целые секунды
+      timeout.tv_nsec = (long)(left_ns % (uint64_t)NSEC_PER_SEC);  // остаток в наносекундах
+    }  // конец тайм-аута
+    completed = (int)syscall(__NR_io_getevents, ctx->aio, deadline ? 1L : 0L, (long)task->iodepth, ctx->events, deadline == IO_WAIT_FOREVER ? NULL : &timeout);  // без срока, до срока или опрос
+  } while (completed < 0 && errno == EINTR);  // прерывание сигналом не ошибка
+  int index = 0;  // номер завершения
+  for (index = 0; index < completed; ++index) {  // переводим завершения в общий формат
+    slots[index] = (int)ctx->events[index].data;  // номер буфера
+    results[index] = (ssize_t)ctx->events[index].res;  // байты или -errno
+  }  // конец перебора завершений
+  return completed;  // число завершений или -1
+}  // конец aio_complete
+
+// aio_destroy() — уничтожает контекст и освобождает очереди
+void aio_destroy(io_task_t* task) {  // вызывается после завершения потока
+  aio_ctx_t* ctx = (aio_ctx_t*)task->engine_ctx;  // контекст потока
+  if (!ctx) {  // состояние могло не создаться
+    return;  // освобождать нечего
+  }  // конец проверки состояния
+  if (ctx->aio) {  // контекст ядра создан
+    syscall(__NR_io_destroy, ctx->aio);  // уничтожаем его
+  }  // конец уничтожения контекста
+  free(ctx->iocbs);  // запросы
+  free(ctx->pending);  // очередь отправки
+  free(ctx->events);  // завершения
+  free(ctx);  // само состояние
+  task->engine_ctx = NULL;  // состояние больше не действительно
+}  // конец aio_destroy
+
+#endif  // конец асинхронных движков Linux
+
+/* IO_ENGINES — движки, доступные в --engine; первый используется по умолчанию */
+const io_engine_t IO_ENGINES[] = {
+    {"psync", 1, psync_init, psync_prepare, psync_complete, psync_destroy},  // блокирующие pread/pwrite
+    {"mmap", 1, mmap_init, psync_prepare, mmap_complete, mmap_destroy},  // копирование из отображения файла
+    {"vtpc", 1, vtpc_engine_init, psync_prepare, vtpc_engine_complete, vtpc_engine_destroy},  // кэш страниц lab/vtpc
+#if defined(__linux__)  // асинхронные движки есть только в Linux
+    {"io_uring", 0, uring_init, uring_prepare, uring_complete, uring_destroy},  // кольца io_uring
+    {"libaio", 0, aio_init, aio_prepare, aio_complete, aio_destroy},  // Linux AIO
+#endif  // конец асинхронных движков
+};
+const size_t IO_ENGINE_COUNT = sizeof(IO_ENGINES) / sizeof(IO_ENGINES[0]);  // число доступных движков
+
+/* MADVISE_NAMES — значения --madvise и соответствующие советы madvise */
+const struct {
+  const char* name;  // значение ключа
+  int advice;  // совет madvise
+} MADVISE_NAMES[] = {
+    {"normal", MADV_NORMAL},  // обычное упреждающее чтение
+    {"random", MADV_RANDOM},  // упреждение отключено
+    {"sequential", MADV_SEQUENTIAL},  // агрессивное упреждение, прочитанное быстро вытесняется
+    {"willneed", MADV_WILLNEED},  // загрузить страницы заранее
+#ifdef MADV_HUGEPAGE  // прозрачные огромные страницы есть только в Linux
+    {"hugepage", MADV_HUGEPAGE},  // отображать огромными страницами, где возможно
+#endif  // конец MADV_HUGEPAGE
+};
+
+// find_engine() — движок по имени из --engine или NULL
+const io_engine_t* find_engine(const char* name) {  // линейный поиск по короткой таблице
+  size_t index = 0;  // номер проверяемого движка
+  for (index = 0; index < IO_ENGINE_COUNT; ++index) {  // перебираем таблицу
+    if (strcmp(IO_ENGINES[index].name, name) == 0) {  // имя совпало
+      return &IO_ENGINES[index];  // нашли движок
+    }  // конец сравнения
+  }  // конец перебора
+  return NULL;  // такого движка нет или он недоступен на этой платформе
+}  // конец find_engine
+
+// ------------------------------ ПОТОК НАГРУЗКИ ------------------------------  // работа одного потока
+/*
+ * Каждый поток выполняет block_count операций в своём диапазоне файла
+ * [slice_start, slice_start + slice_blocks * block_size) через общий
+ * дескриптор: операции позиционные, поэтому потокам не нужна общая позиция
+ * в файле. Поток держит в полёте до iodepth операций, по одной на каждый
+ * свой буфер: ставит новые в движок, пока есть свободные буферы, а затем
+ * ждёт завершений и освобождает их буферы. Перед каждым повтором потоки
+ * встречаются на барьере, чтобы стартовать одновременно, а после повтора —
+ * ещё раз, чтобы главный поток забрал отметки времени. Случайные блоки
+ * выбираются собственным генератором потока по распределению --dist, а
+ * чтение или запись — тем же генератором по доле --rwmixread.
+ *
+ * С --rate поток работает в открытом цикле: операция i повтора должна
+ * начаться в момент start + phase + i * interval, независимо от того, как
+ * быстро завершились предыдущие. Медленная операция не сдвигает расписание,
+ * а задержка считается от запланированного начала, поэтому ожидание
+ * свободного буфера или опоздание самого потока входит в задержку, а не
+ * исчезает из неё (поправка на coordinated omission). Пока следующая
+ * операция не наступила, поток ждёт завершений в движке с тайм-аутом до
+ * момента за RATE_SPIN_NS до её срока, поэтому завершение будит его сразу,
+ * а не на следующем шаге опроса. Последние RATE_SPIN_NS поток не спит, а
+ * опрашивает часы и завершения: пробуждение из сна опаздывает на десятки
+ * микросекунд даже с запасом таймера в 1 нс (PR_SET_TIMERSLACK), который
+ * поток выставляет себе в открытом цикле. Опоздание постановки операции
+ * против расписания — ожидание буфера или самого потока — входит в задержку
+ * и отдельно собирается в гистограмму lag, чтобы отчёт отделял его от
+ * времени самого ввода-вывода.
+ */
+void* io_worker(void* arg) {  // потоковая функция, получающая задание потока через void*
+  io_task_t* task = (io_task_t*)arg;  // восстанавливаем тип задания
+  int* free_slots = calloc((size_t)task->iodepth, sizeof(int));  // стек свободных буферов
+  int* done_slots = calloc((size_t)task->iodepth, sizeof(int));  // буферы завершившихся операций
+  ssize_t* done_results = calloc((size_t)task->iodepth, sizeof(ssize_t));  // результаты завершившихся операций
+  uint64_t* slot_started = calloc((size_t)task->iodepth, sizeof(uint64_t));  // момент постановки операции каждого буфера
+  char* slot_writes = calloc((size_t)task->iodepth, sizeof(char));  // 1, если операция буфера — запись
+  off_t* slot_offsets = calloc((size_t)task->iodepth, sizeof(off_t));  // смещение операции каждого буфера для проверки
+  uint64_t* slot_min_generation = calloc((size_t)task->iodepth, sizeof(uint64_t));  // наименьший допустимый номер записи для чтения буфера
+  uint64_t* written_generation = task->verify_stale ? calloc((size_t)task->slice_blocks, sizeof(uint64_t)) : NULL;  // номер последней завершённой записи каждого блока
+  char* block_busy = task->verify_exclusive ? calloc((size_t)task->slice_blocks, sizeof(char)) : NULL;  // 1, если над блоком идёт операция
+  if (!free_slots || !done_slots || !done_results || !slot_started || !slot_writes || !slot_offsets || !slot_min_generation || (task->verify_stale && !written_generation) || (task->verify_exclusive && !block_busy)) {  // без этих массивов поток работать не может
+    perror("calloc");  // сообщаем о нехватке памяти
+    exit(1);  // остальные потоки ждут на барьере, поэтому завершаем весь процесс
+  }  // конец проверки выделения
+
+#if defined(__linux__)  // запас таймера есть только в Linux
+  if (task->rate_interval_ns) {  // открытый цикл спит до сроков операций
+    prctl(PR_SET_TIMERSLACK, 1UL, 0UL, 0UL, 0UL);  // по умолчанию ядро откладывает пробуждение на 50 мкс ради объединения таймеров
+  }  // конец настройки таймера
+#endif  // конец запаса таймера
+
+  int repetition_index = 0;  // номер текущего повтора
+  for (repetition_index = 0; repetition_index < task->repetitions; ++repetition_index) {  // выполняем столько же повторов, сколько и главный поток
+    int free_count = 0;  // число свободных буферов
+    for (free_count = 0; free_count < task->iodepth; ++free_count) {  // в начале повтора свободны все буферы
+      free_slots[free_count] = free_count;  // кладём номер буфера в стек
+    }  // конец заполнения стека
+
+    pthread_barrier_wait(task->barrier);  // ждём остальных потоков, чтобы все начали повтор одновременно
+    histogram_reset(&task->latency);  // главный поток уже слил гистограмму прошлого повтора
+    histogram_reset(&task->lag);  // и гистограмму опозданий
+    task->started[repetition_index] = monotonic_seconds();  // фиксируем начало работы потока в повторе
+    uint64_t schedule_start = monotonic_ns() + task->rate_phase_ns;  // отсчёт расписания открытого цикла
+
+    size_t issued = 0;  // операции, поставленные в движок
+    size_t completed = 0;  // операции, завершившиеся
+    while (completed < task->block_count) {  // пока не завершены все операции повтора
+      uint64_t due_ns = 0;  // запланированное начало следующей операции в открытом цикле
+      int is_blocked = 0;  // 1, если следующий блок занят операцией в полёте
+      while (free_count > 0 && issued < task->block_count) {  // заполняем свободные буферы новыми операциями
+        if (task->rate_interval_ns) {  // открытый цикл: операция начинается не раньше своего срока
+          due_ns = schedule_start + (uint64_t)issued * task->rate_interval_ns;  // срок по расписанию
+          if (due_ns > monotonic_ns()) {  // срок ещё не наступил
+            break;  // ставить операцию рано
+          }  // конец проверки срока
+        }  // конец открытого цикла
+        off_t current_block_index = task->is_sequence ? (off_t)issued % task->slice_blocks : dist_next(task, task->slice_blocks);  // выбираем блок внутри диапазона потока последовательно или по распределению
+        off_t current_offset_bytes = task->slice_start + current_block_index * (off_t)task->block_size;  // смещение блока в файле
+        if (block_busy && block_busy[current_block_index]) {  // над блоком уже идёт операция
+          is_blocked = 1;  // чтение не должно застать запись на полпути, а запись — обогнать другую
+          break;  // ставим блок, когда она завершится; случайный выбор при этом просто берёт другой
+        }  // конец проверки занятости
+        if (block_busy) {  // поток следит за блоками в полёте
+          block_busy[current_block_index] = 1;  // блок занят до завершения операции
+        }  // конец пометки блока
+        int slot = free_slots[--free_count];  // свободный буфер для операции
+        slot_writes[slot] = task->rwmixread == 100 ? 0 : task->rwmixread == 0 || rng_below(task->rng, 100) >= (uint64_t)task->rwmixread;  // чистые режимы не тратят генератор
+        slot_offsets[slot] = current_offset_bytes;  // смещение для проверки после завершения
+        if (task->verify && slot_writes[slot]) {  // запись блока с меткой
+          verify_fill((unsigned char*)task->buffer + (size_t)slot * task->block_size, task->block_size, current_offset_bytes, ++task->generation);  // заполняем буфер до замера задержки
+        }  // конец заполнения блока
+        slot_min_generation[slot] = written_generation ? written_generation[current_block_index] : 0;  // чтение не должно вернуть версию старее уже записанной
+        slot_started[slot] = monotonic_ns();  // момент постановки
+        if (task->rate_interval_ns) {  // открытый цикл
+          histogram_record(&task->lag, slot_started[slot] - due_ns);  // насколько постановка опоздала против расписания
+          slot_started[slot] = due_ns;  // задержка считается от запланированного начала
+        }  // конец учёта опоздания
+        task->engine->prepare(task, slot, current_offset_bytes, slot_writes[slot]);  // ставим операцию над свободным буфером
+        ++issued;  // операция поставлена
+      }  // конец заполнения
+
+      int is_early = task->rate_interval_ns && free_count > 0 && issued < task->block_count && !is_blocked;  // буфер есть, но следующая операция ещё не наступила
+      if (is_early && issued == completed) {  // в полёте ничего нет
+        wait_until_ns(due_ns);  // ждём срока следующей операции
+        continue;  // ставим её
+      }  // конец ожидания срока
+      uint64_t deadline = IO_WAIT_FOREVER;  // ставить нечего: ждём завершения без срока
+      if (is_early) {  // следующая операция ещё не наступила
+        deadline = due_ns > RATE_SPIN_NS ? due_ns - RATE_SPIN_NS : 0;  // ждём завершений, пока до неё дальше окна опроса
+        deadline = deadline > monotonic_ns() ? deadline : 0;  // в окне только опрашиваем
+      }  // конец выбора срока
+      int done = task->engine->complete(task, done_slots, done_results, deadline);  // отправляем поставленные и ждём до срока
+      if (done < 0) {  // движок не может продолжать: незавершённые операции остались в ядре
+        perror(task->engine->name);  // выводим причину из errno
+        exit(1);  // остальные потоки ждут на барьере, поэтому завершаем весь процесс
+      }  // конец проверки движка
+      if (done == 0) {  // срок ожидания наступил раньше завершений
+        continue;  // ставим операцию, если срок наступил, иначе опрашиваем дальше
+      }  // конец пустого ожидания
+      uint64_t done_ns = monotonic_ns();  // момент, когда поток узнал о завершениях
+      int done_index = 0;  // номер завершения
+      for (done_index = 0; done_index < done; ++done_index) {  // разбираем завершения
+        ssize_t result = done_results[done_index];  // байты или -errno
+        histogram_record(&task->latency, done_ns - slot_started[done_slots[done_index]]);  // задержка операции
+        if (block_busy) {  // блок операции освобождается при любом исходе
+          block_busy[(slot_offsets[done_slots[done_index]] - task->slice_start) / (off_t)task->block_size] = 0;  // над ним можно ставить следующую
+        }  // конец освобождения блока
+        if (result != (ssize_t)task->block_size) {  // операция не удалась или оказалась неполной
+          if (result < 0) {  // ошибка операции
+            ++task->errors;  // учитываем неудачную операцию
+            fprintf(stderr, "%s: %s\n", slot_writes[done_slots[done_index]] ? "pwrite" : "pread", strerror((int)-result));  // выводим причину
+          } else {  // укороченная операция, например чтение за концом файла
+            ++task->short_ops;  // учитываем укороченную операцию
+            fprintf(stderr, "Short %s %zd\n", slot_writes[done_slots[done_index]] ? "write" : "read", result);  // сообщаем фактический объём
+          }  // конец разбора неудачной операции
+        } else if (task->verify) {  // полная операция проверяемого запуска
+          int slot = done_slots[done_index];  // буфер операции
+          unsigned char* block = (unsigned char*)task->buffer + (size_t)slot * task->block_size;  // данные операции
+          off_t block_index = (slot_offsets[slot] - task->slice_start) / (off_t)task->block_size;  // номер блока в диапазоне потока
+          uint64_t generation = 0;  // номер записи из метки
+          if (slot_writes[slot]) {  // запись завершилась: её версия теперь самая новая
+            memcpy(&generation, block + offsetof(io_verify_header_t, generation), sizeof(generation));  // номер только что записанного блока
+            if (written_generation && generation > written_generation[block_index]) {  // учитываем, только если поток следит за версиями
+              written_generation[block_index] = generation;  // последняя завершённая запись блока
+            }  // конец учёта записи
+          } else if (task->verify_blank_ok && slot_min_generation[slot] == 0 && verify_is_blank(block, task->block_size)) {  // в блок ещё не писали, и файл там пуст
+            ++task->verify_unwritten;  // не ошибка: нули дыры или подготовленного файла
+          } else {  // чтение: проверяем метку
+            const char* reason = verify_check(block, task->block_size, slot_offsets[slot], slot_min_generation[slot], &generation);  // причина порчи или NULL
+            if (reason) {  // блок испорчен
+              if (task->verify_errors < VERIFY_REPORT_LIMIT) {  // подробности только для первых блоков, чтобы не залить stderr
+                fprintf(stderr, "Verify: %s at offset %lld (generation %llu, expected at least %llu)\n", reason, (long long)slot_offsets[slot], (unsigned long long)generation, (unsigned long long)slot_min_generation[slot]);  // что и где не так
+              }  // конец сообщения
+              ++task->verify_errors;  // учитываем испорченный блок
+            }  // конец проверки
+          }  // конец разбора вида операции
+        }  // конец проверки результата
+        free_slots[free_count++] = done_slots[done_index];  // буфер снова свободен
+        ++completed;  // операция завершена
+      }  // конец разбора завершений
+    }  // конец цикла операций повтора
+
+    task->finished[repetition_index] = monotonic_seconds();  // фиксируем конец работы потока в повторе для отчёта главного потока
+    pthread_barrier_wait(task->barrier);  // сообщаем главному потоку, что повтор завершён
+  }  // конец цикла повторов
+
+  free(free_slots);  // стек свободных буферов
+  free(done_slots);  // буферы завершений
+  free(done_results);  // результаты завершений
+  free(slot_started);  // моменты постановки операций
+  free(slot_writes);  // виды операций буферов
+  free(slot_offsets);  // смещения операций буферов
+  free(slot_min_generation);  // допустимые номера записей
+  free(written_generation);  // последние записи блоков
+  free(block_busy);  // блоки в полёте
+  return NULL;  // результаты возвращаются через поля задания
+}  // конец io_worker
+
 // ------------------------------ MAIN ------------------------------  // входная точка программы
 
 int main(int argc, char** argv) {  // основная функция получает количество аргументов и их значения, являясь входной точкой программы
@@ -114,6 +1561,26 @@ int main(int argc, char** argv) {  // основная функция получ
   int direct_io_flag = 0;  // флаг запроса прямого ввода-вывода (O_DIRECT); управляет попыткой отключить файловый кэш
   int is_sequence_access = 1;  // режим доступа: 1 — последовательный, 0 — случайный; влияет на выбор индекса блока в цикле
   int repetitions_total = 1;  // количество повторов полного прохода по блокам; даёт возможность повторять замеры для усреднения
+  int threads_total = 1;  // число потоков нагрузки; по умолчанию один, как в исходном однопоточном нагрузчике
+  int is_shared_slice = 0;  // 1 — все потоки работают во всём диапазоне, 0 — каждый в своей непересекающейся части
+  const io_engine_t* engine = &IO_ENGINES[0];  // движок ввода-вывода; по умолчанию блокирующие pread/pwrite
+  int iodepth = 1;  // наибольшее число операций в полёте на поток
+  int is_json_output = 0;  // 1 — отчёт одним JSON-документом в stdout, 0 — текстом для человека
+  size_t cache_pages = VTPC_CACHE_PAGES;  // ёмкость кэша vtpc в страницах для --engine vtpc
+  const char* madvise_str = NULL;  // совет --madvise для отчёта; NULL — не задан
+  int madvise_advice = -1;  // совет madvise для --engine mmap; -1 — отображение без совета
+  int is_populate = 0;  // 1 — отображать с MAP_POPULATE
+  int batch = 1;  // операций в пакете psync
+  const char* rwf_str = NULL;  // флаги --rwf для отчёта; NULL — не заданы
+  int rwf_flags = 0;  // флаги RWF_* для preadv2/pwritev2
+  int is_verify = 0;  // 1 — писать блоки с меткой и проверять прочитанные
+  double rate_value = 0.0;  // заданная частота всех потоков; 0 — замкнутый цикл без расписания
+  int is_rate_mb = 0;  // 1 — rate_value в MB/s, 0 — в операциях в секунду
+  int rwmixread = -1;  // доля чтений в процентах; -1 — определяется по --rw
+  uint64_t seed = (uint64_t)time(NULL);  // зерно генераторов потоков; по умолчанию меняется между запусками
+  const char* dist_str = "uniform";  // распределение случайных блоков для отчёта
+  io_dist_t dist;  // разобранное распределение
+  parse_dist(dist_str, &dist);  // по умолчанию равномерное
 
   // -------------------- Парсинг аргументов командной строки --------------------  // разбираем ключи и значения, переданные пользователем
   /*
@@ -194,6 +1661,167 @@ int main(int argc, char** argv) {  // основная функция получ
       continue;  // продолжаем обработку аргументов, поскольку ключ успешно интерпретирован
     }  // завершение обработки --repetitions, определяющего длительность серии экспериментов
 
+    if (strcmp(argv[arg_index], "--threads") == 0 && arg_index + 1 < argc) {  // ключ числа потоков нагрузки
+      char* endptr = NULL;  // указатель для контроля преобразования числа
+      long long temp_val = strtoll(argv[++arg_index], &endptr, 10);  // читаем число потоков
+      if (*endptr != '\0' || temp_val <= 0 || temp_val > 1024) {  // число потоков должно быть положительным и разумным
+        fprintf(stderr, "Invalid --threads value\n");  // сообщаем об ошибке пользователю
+        return 1;  // завершаем программу из-за неверного аргумента
+      }  // конец проверки threads
+      threads_total = (int)temp_val;  // сохраняем число потоков
+      continue;  // продолжаем разбор аргументов
+    }  // завершение обработки --threads
+
+    if (strcmp(argv[arg_index], "--slice") == 0 && arg_index + 1 < argc) {  // ключ деления диапазона между потоками
+      const char* slice_str = argv[++arg_index];  // значение disjoint или shared
+      if (strcmp(slice_str, "shared") != 0 && strcmp(slice_str, "disjoint") != 0) {  // допускаем только два режима
+        fprintf(stderr, "Invalid --slice value\n");  // сообщаем об ошибке пользователю
+        return 1;  // завершаем программу из-за неверного аргумента
+      }  // конец проверки slice
+      is_shared_slice = strcmp(slice_str, "shared") == 0;  // запоминаем выбранный режим
+      continue;  // продолжаем разбор аргументов
+    }  // завершение обработки --slice
+
+    if (strcmp(argv[arg_index], "--engine") == 0 && arg_index + 1 < argc) {  // ключ движка ввода-вывода
+      engine = find_engine(argv[++arg_index]);  // ищем движок по имени
+      if (!engine) {  // такого движка нет или он недоступен на этой платформе
+        fprintf(stderr, "Invalid --engine value\n");  // сообщаем об ошибке пользователю
+        return 1;  // завершаем программу из-за неверного аргумента
+      }  // конец проверки engine
+      continue;  // продолжаем разбор аргументов
+    }  // завершение обработки --engine
+
+    if (strcmp(argv[arg_index], "--iodepth") == 0 && arg_index + 1 < argc) {  // ключ глубины очереди
+      char* endptr = NULL;  // указатель для контроля преобразования числа
+      long long temp_val = strtoll(argv[++arg_index], &endptr, 10);  // читаем глубину очереди
+      if (*endptr != '\0' || temp_val <= 0 || temp_val > MAX_IODEPTH) {  // глубина должна быть положительной и не больше MAX_IODEPTH
+        fprintf(stderr, "Invalid --iodepth value\n");  // сообщаем об ошибке пользователю
+        return 1;  // завершаем программу из-за неверного аргумента
+      }  // конец проверки iodepth
+      iodepth = (int)temp_val;  // сохраняем глубину очереди
+      continue;  // продолжаем разбор аргументов
+    }  // завершение обработки --iodepth
+
+    if (strcmp(argv[arg_index], "--rate") == 0 && arg_index + 1 < argc) {  // ключ частоты открытого цикла
+      char* endptr = NULL;  // указатель на суффикс единиц после числа
+      rate_value = strtod(argv[++arg_index], &endptr);  // читаем частоту
+      is_rate_mb = strcmp(endptr, "mb") == 0;  // суффикс mb — мегабайты в секунду
+      if (!(rate_value > 0.0) || (*endptr != '\0' && strcmp(endptr, "iops") != 0 && !is_rate_mb)) {  // частота положительна, суффикс пуст, iops или mb
+        fprintf(stderr, "Invalid --rate value\n");  // сообщаем об ошибке пользователю
+        return 1;  // завершаем программу из-за неверного аргумента
+      }  // конец проверки rate
+      continue;  // продолжаем разбор аргументов
+    }  // завершение обработки --rate
+
+    if (strcmp(argv[arg_index], "--rwmixread") == 0 && arg_index + 1 < argc) {  // ключ доли чтений
+      char* endptr = NULL;  // указатель для контроля преобразования числа
+      long long temp_val = strtoll(argv[++arg_index], &endptr, 10);  // читаем долю в процентах
+      if (*endptr != '\0' || temp_val < 0 || temp_val > 100) {  // доля от 0 до 100 процентов
+        fprintf(stderr, "Invalid --rwmixread value\n");  // сообщаем об ошибке пользователю
+        return 1;  // завершаем программу из-за неверного аргумента
+      }  // конец проверки rwmixread
+      rwmixread = (int)temp_val;  // сохраняем долю чтений
+      continue;  // продолжаем разбор аргументов
+    }  // завершение обработки --rwmixread
+
+    if (strcmp(argv[arg_index], "--dist") == 0 && arg_index + 1 < argc) {  // ключ распределения случайных блоков
+      dist_str = argv[++arg_index];  // значение вида и параметров
+      if (parse_dist(dist_str, &dist) != 0) {  // проверяем формат и границы параметров
+        fprintf(stderr, "Invalid --dist value\n");  // сообщаем об ошибке пользователю
+        return 1;  // завершаем программу из-за неверного аргумента
+      }  // конец проверки dist
+      continue;  // продолжаем разбор аргументов
+    }  // завершение обработки --dist
+
+    if (strcmp(argv[arg_index], "--seed") == 0 && arg_index + 1 < argc) {  // ключ зерна генераторов
+      char* endptr = NULL;  // указатель для контроля преобразования числа
+      const char* seed_str = argv[++arg_index];  // значение зерна
+      seed = (uint64_t)strtoull(seed_str, &endptr, 0);  // допускаем десятичную и шестнадцатеричную запись
+      if (*seed_str == '\0' || *seed_str == '-' || *endptr != '\0') {  // зерно — неотрицательное целое
+        fprintf(stderr, "Invalid --seed value\n");  // сообщаем об ошибке пользователю
+        return 1;  // завершаем программу из-за неверного аргумента
+      }  // конец проверки seed
+      continue;  // продолжаем разбор аргументов
+    }  // завершение обработки --seed
+
+    if (strcmp(argv[arg_index], "--cache_pages") == 0 && arg_index + 1 < argc) {  // ключ ёмкости кэша vtpc
+      char* endptr = NULL;  // указатель для контроля преобразования числа
+      long long temp_val = strtoll(argv[++arg_index], &endptr, 10);  // читаем ёмкость в страницах
+      if (*endptr != '\0' || temp_val <= 0) {  // ёмкость должна быть положительной
+        fprintf(stderr, "Invalid --cache_pages value\n");  // сообщаем об ошибке пользователю
+        return 1;  // завершаем программу из-за неверного аргумента
+      }  // конец проверки cache_pages
+      cache_pages = (size_t)temp_val;  // сохраняем ёмкость кэша
+      continue;  // продолжаем разбор аргументов
+    }  // завершение обработки --cache_pages
+
+    if (strcmp(argv[arg_index], "--madvise") == 0 && arg_index + 1 < argc) {  // ключ совета для отображения
+      madvise_str = argv[++arg_index];  // имя совета
+      size_t advice_index = 0;  // номер проверяемого совета
+      for (advice_index = 0; advice_index < sizeof(MADVISE_NAMES) / sizeof(MADVISE_NAMES[0]); ++advice_index) {  // ищем имя в таблице
+        if (strcmp(MADVISE_NAMES[advice_index].name, madvise_str) == 0) {  // имя совпало
+          madvise_advice = MADVISE_NAMES[advice_index].advice;  // запоминаем совет
+        }  // конец сравнения
+      }  // конец поиска
+      if (madvise_advice < 0) {  // такого совета нет или он недоступен на этой платформе
+        fprintf(stderr, "Invalid --madvise value\n");  // сообщаем об ошибке пользователю
+        return 1;  // завершаем программу из-за неверного аргумента
+      }  // конец проверки madvise
+      continue;  // продолжаем разбор аргументов
+    }  // завершение обработки --madvise
+
+    if (strcmp(argv[arg_index], "--populate") == 0) {  // флаг предзагрузки отображения без значения
+      is_populate = 1;  // отображение будет создано с MAP_POPULATE
+      continue;  // продолжаем разбор аргументов
+    }  // завершение обработки --populate
+
+    if (strcmp(argv[arg_index], "--batch") == 0 && arg_index + 1 < argc) {  // ключ размера пакета
+      char* endptr = NULL;  // указатель для контроля преобразования числа
+      long long temp_val = strtoll(argv[++arg_index], &endptr, 10);  // читаем число операций в пакете
+      if (*endptr != '\0' || temp_val <= 0 || temp_val > MAX_IODEPTH) {  // пакет положителен и не больше MAX_IODEPTH буферов
+        fprintf(stderr, "Invalid --batch value\n");  // сообщаем об ошибке пользователю
+        return 1;  // завершаем программу из-за неверного аргумента
+      }  // конец проверки batch
+      batch = (int)temp_val;  // сохраняем размер пакета
+      continue;  // продолжаем разбор аргументов
+    }  // завершение обработки --batch
+
+    if (strcmp(argv[arg_index], "--rwf") == 0 && arg_index + 1 < argc) {  // ключ флагов preadv2/pwritev2
+      rwf_str = argv[++arg_index];  // список флагов через запятую
+      const char* flag_str = rwf_str;  // начало очередного флага
+      while (*flag_str) {  // разбираем флаги по одному
+        size_t flag_len = strcspn(flag_str, ",");  // длина флага до запятой
+#if defined(RWF_NOWAIT)  // флаги RWF_* есть только в Linux
+        if (flag_len == 5 && strncmp(flag_str, "hipri", 5) == 0) {  // опрос завершения вместо прерывания; действует с O_DIRECT
+          rwf_flags |= RWF_HIPRI;  // добавляем флаг
+        } else if (flag_len == 6 && strncmp(flag_str, "nowait", 6) == 0) {  // не блокироваться: без данных в кэше вызов вернёт EAGAIN
+          rwf_flags |= RWF_NOWAIT;  // добавляем флаг
+        } else  // неизвестный флаг
+#endif  // конец флагов Linux
+        {  // флаг не распознан
+          fprintf(stderr, "Invalid --rwf value\n");  // сообщаем об ошибке пользователю
+          return 1;  // завершаем программу из-за неверного аргумента
+        }  // конец разбора флага
+        flag_str += flag_len + (flag_str[flag_len] == ',');  // переходим за запятую
+      }  // конец перебора флагов
+      continue;  // продолжаем разбор аргументов
+    }  // завершение обработки --rwf
+
+    if (strcmp(argv[arg_index], "--verify") == 0) {  // флаг проверки данных без значения
+      is_verify = 1;  // блоки пишутся с меткой и проверяются при чтении
+      continue;  // продолжаем разбор аргументов
+    }  // завершение обработки --verify
+
+    if (strcmp(argv[arg_index], "--output-format") == 0 && arg_index + 1 < argc) {  // ключ формата отчёта
+      const char* format_str = argv[++arg_index];  // значение text или json
+      if (strcmp(format_str, "text") != 0 && strcmp(format_str, "json") != 0) {  // допускаем только два формата
+        fprintf(stderr, "Invalid --output-format value\n");  // сообщаем об ошибке пользователю
+        return 1;  // завершаем программу из-за неверного аргумента
+      }  // конец проверки формата
+      is_json_output = strcmp(format_str, "json") == 0;  // запоминаем выбранный формат
+      continue;  // продолжаем разбор аргументов
+    }  // завершение обработки --output-format
+
     fprintf(stderr, "Unknown or malformed arg: %s\n", argv[arg_index]);  // сообщаем о незнакомом или неверном аргументе, чтобы упростить диагностику
     usage(argv[0]);  // повторно выводим подсказку по синтаксису, демонстрируя ожидаемую последовательность ключей
     return 1;  // прекращаем работу, так как не разобрались с аргументом, предотвращая запуск в неопределённом состоянии
@@ -211,6 +1839,63 @@ int main(int argc, char** argv) {  // основная функция получ
   }  // конец проверки обязательных опций, после которой можно переходить к инициализации
 
   int do_write_flag = (strcmp(rw_mode_str, "write") == 0) ? 1 : 0;  // определяем, требуется ли режим записи (иначе будет чтение), переводя строковый параметр в быстродействующий флаг
+  if (rwmixread < 0) {  // доля чтений не задана явно
+    rwmixread = do_write_flag ? 0 : 100;  // чистая запись или чистое чтение, как раньше
+  }  // конец выбора доли чтений
+  do_write_flag = rwmixread < 100;  // файл открывается на запись и готовится к ней, если записи вообще будут
+  if (engine->is_blocking && iodepth > 1) {  // блокирующий движок всё равно выполняет операции по одной
+    fprintf(stderr, "Warning: --iodepth %d has no effect with --engine %s\n", iodepth, engine->name);  // предупреждаем, что глубина не изменит результат
+    iodepth = 1;  // не выделяем лишних буферов
+  }  // конец проверки глубины для блокирующих движков
+  if ((batch > 1 || rwf_flags) && strcmp(engine->name, "psync") != 0) {  // пакеты и флаги есть только у psync
+    fprintf(stderr, "Warning: --batch and --rwf have no effect without --engine psync\n");  // предупреждаем, что ключи не изменят результат
+    batch = 1;  // в отчёте — без пакетов
+    rwf_flags = 0;  // флаги не используются
+    rwf_str = NULL;  // флаги не используются
+  } else if (batch > 1) {  // очередь psync вмещает пакет
+    iodepth = batch;  // буферов столько же, сколько операций в пакете
+  }  // конец проверки пакетов
+  if ((madvise_str || is_populate) && strcmp(engine->name, "mmap") != 0) {  // советы относятся только к отображению
+    fprintf(stderr, "Warning: --madvise and --populate have no effect without --engine mmap\n");  // предупреждаем, что ключи не изменят результат
+  }  // конец проверки ключей mmap
+  const char* verify_str = "off";  // реализация CRC32C для отчёта
+  if (is_verify) {  // проверка данных
+    if (block_size_bytes < sizeof(io_verify_header_t)) {  // метка не помещается в блок
+      fprintf(stderr, "--verify needs --block_size of at least %zu\n", sizeof(io_verify_header_t));  // сообщаем об ошибке пользователю
+      return 1;  // завершаем программу из-за неверного сочетания аргументов
+    }  // конец проверки размера блока
+    if (do_write_flag && is_shared_slice && threads_total > 1) {  // потоки пишут в общие блоки
+      fprintf(stderr, "--verify with writes needs --slice disjoint or --threads 1: reads would overlap other threads' writes\n");  // ошибки были бы ложными
+      return 1;  // завершаем программу из-за неверного сочетания аргументов
+    }  // конец проверки общих диапазонов
+    crc32c_init();  // таблицы нужны и как запасной вариант
+    crc32c_lanes_init(block_size_bytes - sizeof(io_verify_header_t));  // сдвиг под содержимое блока
+    verify_str = "crc32c-table";  // программная CRC32C
+#if defined(__x86_64__)  // на x86-64 проверяем поддержку SSE4.2
+    if (__builtin_cpu_supports("sse4.2")) {  // процессор умеет crc32
+      crc32c_update = crc32c_sse42;  // аппаратная CRC32C
+      verify_str = "crc32c-sse4.2";  // для отчёта
+    }  // конец выбора аппаратной CRC32C
+#endif  // конец x86-64
+  }  // конец настройки проверки
+  int is_vtpc_engine = strcmp(engine->name, "vtpc") == 0;  // операции идут через кэш, и отчёт содержит его счётчики
+  if (is_vtpc_engine) {  // кэш настраивается до первого vtpc_open
+    struct vtpc_config vtpc_cfg = VTPC_CONFIG_DEFAULT;  // умолчания кэша: упреждение, фоновое освобождение и предвыделение
+    vtpc_cfg.cache_pages = cache_pages;  // ёмкость из --cache_pages
+    if (!is_sequence_access) {  // упреждение полезно только последовательному доступу
+      vtpc_cfg.readahead_pages = 0;  // случайный доступ читает без упреждения
+    }  // конец выбора упреждения
+    if (vtpc_configure(&vtpc_cfg) != 0) {  // неверная конфигурация кэша
+      perror("vtpc_configure");  // выводим причину
+      return 1;  // без кэша движок работать не может
+    }  // конец настройки кэша
+  }  // конец подготовки vtpc
+  double rate_iops = is_rate_mb ? rate_value * BYTES_PER_MB / (double)block_size_bytes : rate_value;  // частота операций всех потоков
+  uint64_t rate_interval_ns = rate_iops > 0.0 ? (uint64_t)((double)threads_total * NSEC_PER_SEC / rate_iops) : 0;  // шаг расписания одного потока
+  if (rate_iops > 0.0 && rate_interval_ns == 0) {  // частота выше наносекундного разрешения расписания
+    fprintf(stderr, "Invalid --rate value\n");  // сообщаем об ошибке пользователю
+    return 1;  // завершаем программу из-за неверного аргумента
+  }  // конец проверки шага
 
   // -------------------- Открытие файла --------------------  // настраиваем и открываем файл для ввода-вывода
   /*
@@ -289,7 +1974,8 @@ int main(int argc, char** argv) {  // основная функция получ
    * записи и ошибки EFBIG в процессе теста.
    */
   if (do_write_flag) {  // продолжаем только если выбрана запись, поскольку чтению не требуется изменение размера
-    off_t needed_size = io_range_start + (off_t)block_size_bytes * (off_t)block_count_total;  // рассчитываем необходимый размер файла, учитывая смещение и количество блоков
+    off_t slices_total = is_shared_slice ? 1 : (off_t)threads_total;  // при непересекающихся диапазонах каждому потоку нужно место под свои блоки
+    off_t needed_size = io_range_start + (off_t)block_size_bytes * (off_t)block_count_total * slices_total;  // рассчитываем необходимый размер файла, учитывая смещение, количество блоков и число диапазонов
     if (needed_size > file_total_size) {  // проверяем, достаточно ли текущего размера файла, чтобы избежать выхода за границы
       if (ftruncate(fd_file, needed_size) != 0) {  // пытаемся увеличить файл до нужного размера, используя системный вызов расширения
         perror("ftruncate");  // сообщаем о невозможности изменить размер, чтобы пользователь увидел первопричину
@@ -303,98 +1989,299 @@ int main(int argc, char** argv) {  // основная функция получ
     }  // завершение проверки необходимости увеличения файла, исключающей лишние вызовы ftruncate
   }  // конец ветки подготовки файла для записи, после которой можно безопасно выполнять операции записи
 
-  // -------------------- Выделение буфера --------------------  // резервируем память под рабочий буфер
-  /*
-   * Работа с прямым вводом-выводом и крупными блоками требует выровненной
-   * памяти. posix_memalign позволяет выделить буфер, кратный размеру страницы,
-   * что удовлетворяет требованиям O_DIRECT и повышает вероятность кеш-линии
-   * оптимального размера.
-   */
-  size_t memory_alignment_bytes = (size_t)sysconf(_SC_PAGESIZE);  // определяем размер страницы памяти для выравнивания буфера, делая код переносимым между системами
-  void* buffer_ptr = NULL;  // указатель на будущий буфер данных, который будет передаваться в pwrite/pread
-
-  if (posix_memalign(&buffer_ptr, memory_alignment_bytes, block_size_bytes) != 0) {  // выделяем выровненную область памяти, требуя успеха для корректных операций direct I/O
-    perror("posix_memalign");  // сообщаем об ошибке выделения памяти, чтобы пользователь видел, что недостаточно ресурсов или параметры некорректны
-    close(fd_file);  // закрываем файловый дескриптор перед выходом, освобождая системный ресурс
-    return 1;  // завершаем программу из-за невозможности выделить буфер, поскольку без него операции ввода-вывода невозможны
-  }  // конец обработки posix_memalign, обеспечивающего корректные требования выравнивания
-
-  if (do_write_flag) {  // если выполняется запись, подготовим данные, чтобы записывать воспроизводимый шаблон
-    size_t byte_index = 0;  // объявляем индекс перебора байтов буфера, позволяя заполнить его пошагово
-    for (byte_index = 0; byte_index < block_size_bytes; ++byte_index) {  // заполняем каждый байт буфера шаблоном, чтобы данные были непустыми и легко проверяемыми
-      ((unsigned char*)buffer_ptr)[byte_index] = (unsigned char)(byte_index & 0xFF);  // записываем циклический шаблон данных в буфер, обеспечивая повторяемость и наглядность содержимого
-    }  // завершение заполнения буфера данными, после чего блок готов к записи в файл
-  }  // конец ветки подготовки буфера для записи, оставляющей буфер нетронутым при работе в режиме чтения
-
-  // -------------------- Подготовка цикла IO --------------------  // устанавливаем параметры для повторений и режима доступа
+  // -------------------- Подготовка цикла IO --------------------  // проверяем диапазон и делим его между потоками
   /*
-   * Перед запуском основного цикла генератор случайных чисел инициализируется
-   * текущим временем, чтобы последовательность случайных блоков отличалась
-   * между запусками. Дополнительно вычисляется количество блоков в диапазоне,
-   * что позволяет контролировать корректность заданных параметров.
+   * Количество блоков в диапазоне определяет, сколько различных смещений
+   * доступно потокам. В режиме disjoint диапазон делится на непересекающиеся
+   * части почти равного размера, так что потоки никогда не обращаются к одним
+   * и тем же блокам; в режиме shared каждый поток работает во всём диапазоне.
    */
-  srand((unsigned)time(NULL));  // инициализируем генератор случайных чисел текущим временем для случайного доступа, чтобы избежать повторяющихся паттернов
-
   off_t blocks_in_region = (io_range_end - io_range_start) / (off_t)block_size_bytes;  // рассчитываем количество блоков в выбранном диапазоне, используя разницу смещений
-  if (blocks_in_region <= 0) {  // проверяем, что диапазон достаточно велик, иначе даже один блок не поместится
+  if (blocks_in_region <= 0 || (!is_shared_slice && blocks_in_region < threads_total)) {  // диапазон должен вмещать хотя бы по одному блоку на каждую часть
     fprintf(stderr, "Range too small for block_size\n");  // сообщаем о недостаточном диапазоне, явно указывая на потенциальную причину
-    free(buffer_ptr);  // освобождаем ранее выделенный буфер, поддерживая корректную очистку ресурсов
     close(fd_file);  // закрываем файл, чтобы не оставлять дескриптор открытым
     return 1;  // прекращаем выполнение из-за некорректного диапазона, избегая деления на ноль и прочих ошибок
   }  // конец проверки блока диапазона, гарантируя, что хотя бы один блок можно обработать
 
-  // -------------------- Основной цикл IO --------------------  // выполняем повторяющиеся проходы по блокам ввода-вывода
+  // -------------------- Задания потоков --------------------  // готовим буферы, диапазоны и генераторы потоков
+  /*
+   * Работа с прямым вводом-выводом и крупными блоками требует выровненной
+   * памяти, поэтому каждый поток получает собственный буфер от posix_memalign
+   * с выравниванием на страницу: общие буферы заставили бы потоки делить
+   * кэш-линии и мешали бы чтению. Генератор случайных чисел каждого потока
+   * инициализируется временем и номером потока, чтобы последовательности
+   * различались между потоками и запусками.
+   */
+  size_t memory_alignment_bytes = (size_t)sysconf(_SC_PAGESIZE);  // определяем размер страницы памяти для выравнивания буферов, делая код переносимым между системами
+  io_task_t* tasks = calloc((size_t)threads_total, sizeof(io_task_t));  // задания потоков, обнулённые для безопасной очистки
+  double* started_all = calloc((size_t)threads_total * (size_t)repetitions_total, sizeof(double));  // отметки начала повторов всех потоков одной таблицей
+  double* finished_all = calloc((size_t)threads_total * (size_t)repetitions_total, sizeof(double));  // отметки конца повторов всех потоков одной таблицей
+  pthread_t* threads = calloc((size_t)threads_total, sizeof(pthread_t));  // идентификаторы запущенных потоков
+  if (!tasks || !started_all || !finished_all || !threads) {  // без этих массивов запустить потоки невозможно
+    perror("calloc");  // сообщаем о нехватке памяти
+    close(fd_file);  // закрываем файл перед выходом
+    return 1;  // завершаем программу с ошибкой
+  }  // конец проверки выделения массивов
+
+  pthread_barrier_t barrier;  // барьер на все рабочие потоки и главный поток
+  pthread_barrier_init(&barrier, NULL, (unsigned)threads_total + 1);  // главный поток тоже ждёт на барьере, чтобы знать о начале и конце повтора
+  uint64_t rng_state[4];  // состояние генератора для очередного потока
+  rng_seed(rng_state, seed);  // поток 0 начинает с зерна
+  off_t dist_blocks = 0;  // размер диапазона, для которого предвычислено распределение
+
+  int thread_index = 0;  // номер подготавливаемого потока
+  for (thread_index = 0; thread_index < threads_total; ++thread_index) {  // заполняем задание для каждого потока
+    io_task_t* task = &tasks[thread_index];  // задание текущего потока
+    off_t slice_first = is_shared_slice ? 0 : blocks_in_region * thread_index / threads_total;  // первый блок части потока
+    off_t slice_last = is_shared_slice ? blocks_in_region : blocks_in_region * (thread_index + 1) / threads_total;  // блок за последним в части потока
+
+    task->file = file_path_str;  // путь к файлу для диагностики
+    task->block_size = block_size_bytes;  // размер одной операции
+    task->block_count = block_count_total;  // число операций потока за повтор
+    task->rwmixread = rwmixread;  // доля чтений
+    task->repetitions = repetitions_total;  // число повторов
+    task->fd = fd_file;  // общий дескриптор файла
+    task->thread_index = thread_index;  // номер потока для отчёта
+    task->is_sequence = is_sequence_access;  // режим выбора блоков
+    task->slice_start = io_range_start + slice_first * (off_t)block_size_bytes;  // начало части потока в байтах
+    task->slice_blocks = slice_last - slice_first;  // число блоков в части потока
+    memcpy(task->rng, rng_state, sizeof(rng_state));  // собственное состояние генератора потока
+    rng_jump(rng_state);  // следующий поток начнёт на 2^128 шагов дальше
+    if (thread_index == 0 || task->slice_blocks != dist_blocks) {  // непересекающиеся части почти всегда одного размера, поэтому zipf считается один раз
+      parse_dist(dist_str, &dist);  // сбрасываем предвычисленное для прошлого размера
+      dist_prepare(&dist, task->slice_blocks);  // параметры для диапазона потока
+      dist_blocks = task->slice_blocks;  // запоминаем размер
+    }  // конец предвычисления
+    task->dist = dist;  // распределение потока
+    task->barrier = &barrier;  // общий барьер
+    task->started = &started_all[(size_t)thread_index * (size_t)repetitions_total];  // строка таблицы начал для потока
+    task->finished = &finished_all[(size_t)thread_index * (size_t)repetitions_total];  // строка таблицы концов для потока
+    task->engine = engine;  // выбранный движок
+    task->iodepth = iodepth;  // глубина очереди потока
+    task->rate_interval_ns = rate_interval_ns;  // шаг расписания потока
+    task->rate_phase_ns = rate_interval_ns * (uint64_t)thread_index / (uint64_t)threads_total;  // потоки чередуются, а не стартуют пачкой
+    task->madvise_advice = madvise_advice;  // совет для отображения
+    task->is_populate = is_populate;  // предзагрузка отображения
+    task->rwf_flags = rwf_flags;  // флаги векторных вызовов psync
+    task->verify = is_verify;  // проверка данных
+    task->verify_exclusive = is_verify && do_write_flag && !engine->is_blocking && iodepth > 1;  // с записями в полёте операции над одним блоком не пересекаются
+    task->verify_blank_ok = do_write_flag;  // без записей файл должен быть целиком записан прошлым запуском
+    task->verify_stale = is_verify && (!is_shared_slice || threads_total == 1);  // версии отслеживаемы, если блоки пишет один поток; в полёте над блоком не больше одной операции
+    if (engine->init(task) != 0) {  // создаём состояние движка: кольцо, контекст AIO или очередь
+      perror(engine->name);  // например, io_uring запрещён в контейнере
+      close(fd_file);  // закрываем файловый дескриптор перед выходом
+      return 1;  // без движка поток работать не может
+    }  // конец создания движка
+
+    if (posix_memalign(&task->buffer, memory_alignment_bytes, block_size_bytes * (size_t)iodepth) != 0) {  // выделяем выровненную область памяти, требуя успеха для корректных операций direct I/O
+      perror("posix_memalign");  // сообщаем об ошибке выделения памяти, чтобы пользователь видел, что недостаточно ресурсов или параметры некорректны
+      close(fd_file);  // закрываем файловый дескриптор перед выходом, освобождая системный ресурс
+      return 1;  // завершаем программу из-за невозможности выделить буфер, поскольку без него операции ввода-вывода невозможны
+    }  // конец обработки posix_memalign, обеспечивающего корректные требования выравнивания
+
+    if (do_write_flag) {  // если выполняется запись, подготовим данные, чтобы записывать воспроизводимый шаблон
+      size_t byte_index = 0;  // объявляем индекс перебора байтов буфера, позволяя заполнить его пошагово
+      for (byte_index = 0; byte_index < block_size_bytes * (size_t)iodepth; ++byte_index) {  // заполняем каждый байт всех буферов шаблоном, чтобы данные были непустыми и легко проверяемыми
+        ((unsigned char*)task->buffer)[byte_index] = (unsigned char)(byte_index & 0xFF);  // записываем циклический шаблон данных в буфер, обеспечивая повторяемость и наглядность содержимого
+      }  // завершение заполнения буфера данными, после чего блок готов к записи в файл
+    }  // конец ветки подготовки буфера для записи, оставляющей буфер нетронутым при работе в режиме чтения
+  }  // конец подготовки заданий
+
+  for (thread_index = 0; thread_index < threads_total; ++thread_index) {  // запускаем рабочие потоки
+    int create_error = pthread_create(&threads[thread_index], NULL, io_worker, &tasks[thread_index]);  // поток сразу встаёт на барьер первого повтора
+    if (create_error != 0) {  // запуск потока не удался
+      fprintf(stderr, "pthread_create: %s\n", strerror(create_error));  // pthread_create возвращает код ошибки, а не выставляет errno
+      return 1;  // завершаем процесс вместе с уже запущенными потоками
+    }  // конец проверки запуска потока
+  }  // конец запуска потоков
+
+  // -------------------- Основной цикл IO --------------------  // синхронизируем повторы и печатаем их результаты
   /*
    * Внешний цикл отвечает за повторение всей серии операций, что позволяет
-   * усреднить результаты и построить стабильную статистику. Внутренний цикл
-   * последовательно (или случайно) выбирает блоки и выполняет реальные вызовы
-   * pread/pwrite. Каждое повторение замеряется при помощи CLOCK_MONOTONIC, чтобы
-   * получить точное время выполнения без влияния изменений системного времени.
+   * усреднить результаты и построить стабильную статистику. Сами операции
+   * выполняют рабочие потоки, а главный поток открывает каждый повтор
+   * барьером и дожидается его окончания на втором барьере. Общее время
+   * повтора — от самого раннего начала до самого позднего конца по отметкам
+   * CLOCK_MONOTONIC самих потоков: собственные часы главного потока после
+   * барьера могут запаздывать, если планировщик не сразу его разбудил.
+   * Суммарная пропускная способность считается по общему времени, а не по
+   * сумме потоковых, поэтому отражает реальную скорость всей группы потоков.
+   * Отчёт о каждом повторе и итоговый выводятся текстом или, с
+   * --output-format json, одним JSON-документом, в котором stdout не содержит
+   * ничего, кроме него.
    */
+  io_report_t* repetition_report = calloc(1, sizeof(io_report_t));  // итоги текущего повтора; гистограмма велика для стека
+  io_report_t* total_report = calloc(1, sizeof(io_report_t));  // итоги всех повторов
+  if (!repetition_report || !total_report) {  // без отчётов запуск бессмыслен
+    perror("calloc");  // сообщаем о нехватке памяти
+    return 1;  // завершаем процесс вместе с ожидающими потоками
+  }  // конец проверки выделения отчётов
+  histogram_reset(&total_report->latency);  // итоговая гистограмма пуста
+  histogram_reset(&total_report->lag);  // итоговые опоздания тоже
+
+  if (is_json_output) {  // открываем JSON-документ описанием запуска
+    printf("{\"config\": {\"file\": ");  // параметры, от которых зависят результаты
+    print_json_string(file_path_str);  // путь к файлу
+    printf(", \"rw\": ");  // режим чтения или записи
+    print_json_string(rw_mode_str);  // строка из командной строки
+    printf(  // объём работы, движок и открытый цикл
+        ", \"block_size\": %zu, \"block_count\": %zu, \"repetitions\": %d, "  // файл, режим и объём работы
+        "\"threads\": %d, \"slice\": \"%s\", \"type\": \"%s\", \"direct\": %s, \"engine\": \"%s\", \"iodepth\": %d, \"rate_iops\": %.1f, "  // движок и открытый цикл
+        "\"rwmixread\": %d, \"dist\": ",  // доля чтений и распределение
+        block_size_bytes,  // размер блока
+        block_count_total,  // число блоков на поток
+        repetitions_total,  // число повторов
+        threads_total,  // число потоков
+        is_shared_slice ? "shared" : "disjoint",  // деление диапазона
+        is_sequence_access ? "sequence" : "random",  // режим выбора блоков
+        direct_io_flag ? "true" : "false",  // прямой ввод-вывод
+        engine->name,  // движок
+        iodepth,  // глубина очереди
+        rate_iops,  // частота открытого цикла, 0 — замкнутый цикл
+        rwmixread  // доля чтений
+    );  // конец полей движка
+    print_json_string(dist_str);  // распределение случайных блоков
+    printf(  // кэш vtpc
+        ", \"seed\": %llu, \"cache_pages\": %zu, \"madvise\": ",  // зерно и ёмкость кэша
+        (unsigned long long)seed,  // зерно для повторения запуска
+        is_vtpc_engine ? cache_pages : (size_t)0  // ёмкость кэша vtpc, 0 — без кэша
+    );  // конец полей кэша
+    print_json_string(madvise_str ? madvise_str : "none");  // совет отображению
+    printf(", \"populate\": %s, \"batch\": %d, \"rwf\": ", is_populate ? "true" : "false", batch);  // предзагрузка отображения и пакет psync
+    print_json_string(rwf_str ? rwf_str : "none");  // флаги preadv2/pwritev2
+    printf(", \"verify\": \"%s\"}, \"iterations\": [", verify_str);  // проверка данных и реализация CRC32C
+  }  // конец заголовка JSON
+
   int repetition_index = 0;  // счётчик текущего повторения цикла, используемый для сообщений и контроля количества итераций
-  size_t block_index_iter = 0;  // счётчик обработки блоков внутри повторения, позволяющий итерироваться по block_count_total
+  size_t errors_seen = 0;  // ошибки всех потоков к концу прошлого повтора
+  size_t short_seen = 0;  // укороченные операции всех потоков к концу прошлого повтора
+  struct rusage usage_seen;  // страничные отказы процесса к концу прошлого повтора
+  getrusage(RUSAGE_SELF, &usage_seen);  // отсчёт для первого повтора: отказы подготовки в него не входят
+  struct vtpc_stats cache_seen;  // счётчики кэша к концу прошлого повтора
+  memset(&cache_seen, 0, sizeof(cache_seen));  // без vtpc счётчики остаются нулями
+  if (is_vtpc_engine) {  // хэндлы уже открыты, но обращений ещё не было
+    vtpc_stats(&cache_seen);  // отсчёт для первого повтора
+  }  // конец начального снимка
+  size_t verify_seen = 0;  // испорченные блоки всех потоков к концу прошлого повтора
+  size_t unwritten_seen = 0;  // не записанные блоки всех потоков к концу прошлого повтора
+  repetition_report->has_verify = is_verify;  // отчёты содержат результат проверки только с --verify
+  total_report->has_verify = is_verify;  // отчёты содержат результат проверки только с --verify
+  repetition_report->has_cache = is_vtpc_engine;  // отчёты содержат счётчики кэша только для vtpc
+  total_report->has_cache = is_vtpc_engine;  // отчёты содержат счётчики кэша только для vtpc
+  repetition_report->has_lag = rate_interval_ns != 0;  // опоздания есть только у открытого цикла
+  total_report->has_lag = rate_interval_ns != 0;  // опоздания есть только у открытого цикла
   for (repetition_index = 0; repetition_index < repetitions_total; ++repetition_index) {  // выполняем заданное пользователем число повторов, пока не достигнем repetitions_total
-    struct timespec _start_iter, _end_iter, _diff_iter;  // структуры для замера времени повторения, включающие секунды и наносекунды
-    clock_gettime(CLOCK_MONOTONIC, &_start_iter);  // фиксируем начало повторения, используя монотонные часы для стабильности измерений
-  printf("IO: Iteration %d: ", repetition_index + 1);  // выводим прогресс текущего прогона в stdout, чтобы итоговый лог эксперимента сразу содержал порядковый номер
-    for (block_index_iter = 0; block_index_iter < block_count_total; ++block_index_iter) {  // перебираем блоки внутри повторения, выполняя операции block_count_total раз
-      off_t current_block_index = is_sequence_access ? (off_t)block_index_iter % blocks_in_region : rand() % blocks_in_region;  // выбираем индекс блока в зависимости от режима доступа, обеспечивая либо последовательность, либо равномерный случай
-
-      off_t current_offset_bytes = io_range_start + current_block_index * (off_t)block_size_bytes;  // вычисляем смещение в файле для выбранного блока, комбинируя базу диапазона и индекс блока
-
-      // -------------------- Операция IO --------------------  // выполняем либо запись, либо чтение блока по вычисленному смещению
-      if (do_write_flag) {  // ветка для режима записи, где данные из буфера отправляются в файл
-        ssize_t written_bytes = pwrite(fd_file, buffer_ptr, block_size_bytes, current_offset_bytes);  // записываем блок данных в файл по указанному смещению, используя позиционный ввод-вывод
-        if (written_bytes != (ssize_t)block_size_bytes) {  // проверяем, что записан полный блок, иначе ищем причину
-          if (written_bytes < 0) {  // если запись завершилась ошибкой, значит pwrite вернул отрицательное значение
-            perror("pwrite");  // выводим причину ошибки записи, извлекая текст из errno
-          } else {  // иначе запись была укороченной, что может означать заполнение диска или сигналы
-            fprintf(stderr, "Short write %zd\n", written_bytes);  // предупреждаем о неполной записи блока, фиксируя фактический объём
-          }  // конец ветки укороченной записи, информирующей о частичном результате
-        }  // закрываем проверку количества записанных байтов, подтверждая успех операции
-      } else {  // режим чтения из файла, при котором данные поступают в буфер
-        ssize_t read_bytes = pread(fd_file, buffer_ptr, block_size_bytes, current_offset_bytes);  // считываем блок данных из файла по смещению, не меняя глобальный указатель позиционирования
-        if (read_bytes != (ssize_t)block_size_bytes) {  // проверяем, что считан полный блок, чтобы исключить неожиданные ранние EOF
-          if (read_bytes < 0) {  // обрабатываем ошибку чтения, если pread вернул отрицательную величину
-            perror("pread");  // выводим описание ошибки чтения, используя errno для большей информативности
-          } else {  // иначе блок считан не полностью, что может указывать на конец файла или усечённый диапазон
-            fprintf(stderr, "Short read %zd\n", read_bytes);  // сообщаем о неполном чтении блока, фиксируя фактический размер результата
-          }  // завершение ветки укороченного чтения, предоставляющей контекст пользователю
-        }  // конец проверки количества прочитанных байтов, гарантируя, что буфер заполнен полностью
-      }  // окончание ветки чтения/записи, после которой можно перейти к следующему блоку
-    }  // завершение цикла по блокам, покрывающего все запланированные операции внутри текущего повторения
-    clock_gettime(CLOCK_MONOTONIC, &_end_iter);  // фиксируем время окончания повторения, чтобы вычислить длительность итерации
-
-    _diff_iter.tv_sec = _end_iter.tv_sec - _start_iter.tv_sec;  // вычисляем разницу секунд между началом и концом, получая грубую составляющую времени
-    _diff_iter.tv_nsec = _end_iter.tv_nsec - _start_iter.tv_nsec;  // считаем разницу наносекунд, добавляющую точность измерений
-    if (_diff_iter.tv_nsec < 0) {  // нормализуем результат, если разница наносекунд отрицательная из-за заимствования секунды
-      _diff_iter.tv_sec -= 1;  // заимствуем одну секунду, уменьшая целую часть
-      _diff_iter.tv_nsec += NSEC_PER_SEC;  // добавляем эквивалент наносекунд, чтобы итог оставался корректным и положительным
-    }  // завершение нормализации временного интервала, приводя результат к каноническому виду
-    double elapsed_iter = _diff_iter.tv_sec + _diff_iter.tv_nsec / (double)NSEC_PER_SEC;  // переводим разницу времени в секунды с дробной частью, подготавливая её к выводу
-  fprintf(stderr, "elapsed: %.6f s\n", elapsed_iter);  // публикуем длительность повторения в stderr, изолируя диагностические тайминги от основных данных stdout
+    pthread_barrier_wait(&barrier);  // отпускаем потоки: все начинают повтор одновременно
+    pthread_barrier_wait(&barrier);  // ждём, пока все потоки закончат повтор
+
+    double first_start = tasks[0].started[repetition_index];  // самое раннее начало среди потоков
+    double last_finish = tasks[0].finished[repetition_index];  // самый поздний конец среди потоков
+    size_t errors_now = 0;  // ошибки всех потоков к концу повтора
+    size_t short_now = 0;  // укороченные операции всех потоков к концу повтора
+    size_t verify_now = 0;  // испорченные блоки всех потоков к концу повтора
+    size_t unwritten_now = 0;  // не записанные блоки всех потоков к концу повтора
+    histogram_reset(&repetition_report->latency);  // гистограмма повтора собирается заново
+    histogram_reset(&repetition_report->lag);  // опоздания повтора тоже
+    for (thread_index = 0; thread_index < threads_total; ++thread_index) {  // потоки стоят на следующем барьере, поэтому их поля можно читать
+      if (tasks[thread_index].started[repetition_index] < first_start) {  // поток начал раньше найденного
+        first_start = tasks[thread_index].started[repetition_index];  // обновляем начало повтора
+      }  // конец сравнения начала
+      if (tasks[thread_index].finished[repetition_index] > last_finish) {  // поток закончил позже найденного
+        last_finish = tasks[thread_index].finished[repetition_index];  // обновляем конец повтора
+      }  // конец сравнения конца
+      errors_now += tasks[thread_index].errors;  // накопленные ошибки потока
+      short_now += tasks[thread_index].short_ops;  // накопленные укороченные операции потока
+      verify_now += tasks[thread_index].verify_errors;  // накопленные испорченные блоки потока
+      unwritten_now += tasks[thread_index].verify_unwritten;  // накопленные не записанные блоки потока
+      histogram_merge(&repetition_report->latency, &tasks[thread_index].latency);  // задержки потока за повтор
+      histogram_merge(&repetition_report->lag, &tasks[thread_index].lag);  // опоздания потока за повтор
+    }  // конец сбора по потокам
+    repetition_report->elapsed = last_finish - first_start;  // длительность повтора в секундах с дробной частью
+    repetition_report->ops = (double)block_count_total * threads_total;  // операции всех потоков
+    repetition_report->bytes = repetition_report->ops * (double)block_size_bytes;  // объём данных всех потоков за повтор
+    repetition_report->errors = errors_now - errors_seen;  // ошибки этого повтора
+    repetition_report->short_ops = short_now - short_seen;  // укороченные операции этого повтора
+    errors_seen = errors_now;  // запоминаем счётчики для следующего повтора
+    short_seen = short_now;  // запоминаем счётчики для следующего повтора
+    repetition_report->verify_errors = verify_now - verify_seen;  // испорченные блоки этого повтора
+    total_report->verify_errors += repetition_report->verify_errors;  // итоговые испорченные блоки
+    verify_seen = verify_now;  // запоминаем счётчик для следующего повтора
+    repetition_report->verify_unwritten = unwritten_now - unwritten_seen;  // не записанные блоки этого повтора
+    total_report->verify_unwritten += repetition_report->verify_unwritten;  // итоговые не записанные блоки
+    unwritten_seen = unwritten_now;  // запоминаем счётчик для следующего повтора
+
+    total_report->elapsed += repetition_report->elapsed;  // итоговое время — сумма времени повторов
+    total_report->ops += repetition_report->ops;  // итоговое число операций
+    total_report->bytes += repetition_report->bytes;  // итоговый объём
+    total_report->errors += repetition_report->errors;  // итоговые ошибки
+    total_report->short_ops += repetition_report->short_ops;  // итоговые укороченные операции
+    histogram_merge(&total_report->latency, &repetition_report->latency);  // итоговые задержки
+    histogram_merge(&total_report->lag, &repetition_report->lag);  // итоговые опоздания
+    struct rusage usage_now;  // страничные отказы процесса к концу повтора
+    getrusage(RUSAGE_SELF, &usage_now);  // потоки стоят на барьере, поэтому новые отказы относятся к повтору
+    repetition_report->minor_faults = (uint64_t)(usage_now.ru_minflt - usage_seen.ru_minflt);  // отказы без диска за повтор
+    repetition_report->major_faults = (uint64_t)(usage_now.ru_majflt - usage_seen.ru_majflt);  // отказы с диском за повтор
+    total_report->minor_faults += repetition_report->minor_faults;  // итоговые отказы без диска
+    total_report->major_faults += repetition_report->major_faults;  // итоговые отказы с диском
+    usage_seen = usage_now;  // отсчёт для следующего повтора
+    if (is_vtpc_engine) {  // потоки стоят на барьере, поэтому счётчики относятся ровно к этому повтору
+      struct vtpc_stats cache_now;  // счётчики кэша к концу повтора
+      vtpc_stats(&cache_now);  // снимок счётчиков
+      repetition_report->cache_hits = cache_now.hits - cache_seen.hits;  // попадания этого повтора
+      repetition_report->cache_misses = cache_now.misses - cache_seen.misses;  // промахи этого повтора
+      total_report->cache_hits += repetition_report->cache_hits;  // итоговые попадания
+      total_report->cache_misses += repetition_report->cache_misses;  // итоговые промахи
+      cache_seen = cache_now;  // отсчёт для следующего повтора
+    }  // конец счётчиков кэша
+
+    if (is_json_output) {  // повтор — элемент массива iterations
+      printf("%s{\"index\": %d, ", repetition_index ? ", " : "", repetition_index + 1);  // номер повтора
+      print_report_json(repetition_report);  // производительность и задержки повтора
+      printf(", \"threads\": [");  // вклад каждого потока
+    } else {  // текстовый отчёт о повторе
+      char label[32];  // метка строки повтора
+      snprintf(label, sizeof(label), "Iteration %d", repetition_index + 1);  // порядковый номер повтора
+      print_report_text(label, repetition_report);  // производительность и задержки повтора
+    }  // конец отчёта о повторе
+    for (thread_index = 0; thread_index < threads_total; ++thread_index) {  // вклад каждого потока
+      double thread_elapsed = tasks[thread_index].finished[repetition_index] - tasks[thread_index].started[repetition_index];  // время работы потока в этом повторе
+      double thread_mb = (double)block_size_bytes * (double)block_count_total / thread_elapsed / BYTES_PER_MB;  // мегабайты в секунду потока
+      double thread_iops = (double)block_count_total / thread_elapsed;  // операции потока в секунду
+      if (is_json_output) {  // поток — элемент массива threads
+        printf("%s{\"index\": %d, \"elapsed_s\": %.6f, \"mb_per_s\": %.3f, \"iops\": %.1f}", thread_index ? ", " : "", thread_index, thread_elapsed, thread_mb, thread_iops);  // номер, время и производительность потока
+      } else if (threads_total > 1) {  // в тексте потоки показываем, только когда их несколько
+        printf("IO:   thread %d: %.6f s, %.2f MB/s, %.0f IOPS\n", thread_index, thread_elapsed, thread_mb, thread_iops);  // номер, время, пропускная способность и операции в секунду
+      }  // конец строки потока
+    }  // конец перебора потоков
+    if (is_json_output) {  // закрываем массив потоков и объект повтора
+      printf("]}");  // конец повтора
+    }  // конец закрытия повтора
+    fflush(stdout);  // выталкиваем отчёт повтора до служебного вывода в stderr
+    fprintf(stderr, "elapsed: %.6f s\n", repetition_report->elapsed);  // публикуем длительность повторения в stderr, изолируя диагностические тайминги от основных данных stdout
   }  // конец основного цикла повторений, после которого выполнены все запрошенные серии операций
 
+  if (is_json_output) {  // итог — последний член документа
+    printf("], \"total\": {");  // закрываем массив повторов
+    print_report_json(total_report);  // производительность и задержки всех повторов
+    printf("}}\n");  // закрываем итог и документ
+  } else {  // текстовый итог
+    print_report_text("Total", total_report);  // производительность и задержки всех повторов
+  }  // конец итогового отчёта
+
+  for (thread_index = 0; thread_index < threads_total; ++thread_index) {  // дожидаемся завершения потоков
+    pthread_join(threads[thread_index], NULL);  // поток уже прошёл последний барьер и завершается
+    free(tasks[thread_index].buffer);  // освобождаем буфер потока
+    engine->destroy(&tasks[thread_index]);  // освобождаем состояние движка
+  }  // конец ожидания потоков
+  pthread_barrier_destroy(&barrier);  // барьер больше не нужен
+  int verify_failed = total_report->verify_errors > 0;  // код выхода для скриптов, проверяющих данные
+  free(repetition_report);  // отчёт повтора
+  free(total_report);  // итоговый отчёт
+  free(threads);  // освобождаем массив идентификаторов потоков
+  free(started_all);  // освобождаем таблицу начал
+  free(finished_all);  // освобождаем таблицу концов
+  free(tasks);  // освобождаем задания потоков
+
   // -------------------- Завершение --------------------  // освобождаем ресурсы и выводим финальное сообщение
   /*
    * После завершения всех операций важно аккуратно освободить выделенную
@@ -402,17 +2289,28 @@ int main(int argc, char** argv) {  // основная функция получ
    * Финальное сообщение суммирует основные параметры запуска, подтверждая
    * успешное завершение сценария.
    */
-  free(buffer_ptr);  // освобождаем выделенный буфер памяти, возвращая систему в исходное состояние и предотвращая утечку
   close(fd_file);  // закрываем файловый дескриптор, уведомляя ядро о конце работы с файлом
 
-  printf(  // сообщаем итоговую сводку параметров работы утилиты, подтверждая, что сценарий завершён
-      "IO loader completed (rw=%s, block_size=%zu, block_count=%zu, "  // форматируем сообщение с параметрами, фиксируя режим операции и размер блока
-      "repetitions=%d)\n",  // добавляем количество повторений в вывод, завершая строку переводом строки
-      rw_mode_str,  // подставляем режим работы read/write, чтобы легче соотнести результаты замеров с конфигурацией
-      block_size_bytes,  // выводим размер блока, подтверждая величину атомарной операции
-      block_count_total,  // сообщаем количество блоков, отражая масштаб выбранного теста
-      repetitions_total  // указываем число повторений, что помогает интерпретировать суммарное время
-  );  // завершаем печать сводного сообщения, отправляя его в стандартный вывод
+  if (!is_json_output) {  // в режиме JSON stdout содержит только документ
+    printf(  // сообщаем итоговую сводку параметров работы утилиты, подтверждая, что сценарий завершён
+        "IO loader completed (rw=%s, block_size=%zu, block_count=%zu, "  // форматируем сообщение с параметрами, фиксируя режим операции и размер блока
+        "repetitions=%d, threads=%d, engine=%s, iodepth=%d, rate=%.0f IOPS, "  // движок и открытый цикл
+        "rwmixread=%d, dist=%s, seed=%llu, batch=%d, verify=%s)\n",  // добавляем количество повторений и потоков в вывод, завершая строку переводом строки
+        rw_mode_str,  // подставляем режим работы read/write, чтобы легче соотнести результаты замеров с конфигурацией
+        block_size_bytes,  // выводим размер блока, подтверждая величину атомарной операции
+        block_count_total,  // сообщаем количество блоков, отражая масштаб выбранного теста
+        repetitions_total,  // указываем число повторений, что помогает интерпретировать суммарное время
+        threads_total,  // указываем число потоков, нагружавших файл
+        engine->name,  // движок ввода-вывода
+        iodepth,  // глубина очереди на поток
+        rate_iops,  // частота открытого цикла, 0 — замкнутый цикл
+        rwmixread,  // доля чтений
+        dist_str,  // распределение случайных блоков
+        (unsigned long long)seed,  // зерно для повторения запуска
+        batch,  // операций в пакете psync
+        verify_str  // проверка данных и реализация CRC32C
+    );  // завершаем печать сводного сообщения, отправляя его в стандартный вывод
+  }  // конец итогового сообщения
 
-  return 0;  // завершение программы с кодом успеха, сигнализирующим о корректном выполнении сценария IO
+  return verify_failed ? 1 : 0;  // испорченные блоки — ошибка запуска, даже если сами операции прошли
 }  // конец функции main, возвращающей управление операционной системе
\ No newline at end of file
@@ -1,21 +1,132 @@
 #ifndef IO_LOADER_H
 #define IO_LOADER_H
 
+#include <pthread.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+struct io_engine;
+
+/* io_histogram_t — лог-линейная гистограмма задержек в наносекундах в духе
+ * HdrHistogram: каждая степень двойки делится на IO_LATENCY_SUB_COUNT равных
+ * корзин, так что относительная погрешность не превышает 1/64 при любом
+ * порядке величины, а запись стоит пару сдвигов и инкремент.
+ */
+#define IO_LATENCY_SUB_BITS 6
+#define IO_LATENCY_SUB_COUNT (1 << IO_LATENCY_SUB_BITS)
+#define IO_LATENCY_BUCKETS ((64 - IO_LATENCY_SUB_BITS + 1) * IO_LATENCY_SUB_COUNT)
+
+typedef struct {
+    uint64_t counts[IO_LATENCY_BUCKETS]; /* число значений в каждой корзине */
+    uint64_t count;        /* всего значений */
+    uint64_t min_ns;       /* наименьшее значение */
+    uint64_t max_ns;       /* наибольшее значение */
+    double sum_ns;         /* сумма значений для среднего */
+} io_histogram_t;
+
+/* io_dist_t — распределение номеров блоков при случайном доступе.
+ * Горячие блоки всех неравномерных распределений лежат в начале диапазона
+ * потока, кроме normal, у которого пик в середине.
+ */
+typedef enum {
+    IO_DIST_UNIFORM,       /* все блоки равновероятны */
+    IO_DIST_ZIPF,          /* ранг k выбирается с вероятностью ~ 1 / k^theta */
+    IO_DIST_PARETO,        /* доля 1 - h обращений приходится на долю h блоков */
+    IO_DIST_HOTSPOT,       /* hot_access обращений равномерно в hot_blocks блоков */
+    IO_DIST_NORMAL         /* нормальное со средним в середине диапазона */
+} io_dist_kind_t;
 
-/* io_task_t — структура для передачи данных IO потоку */
 typedef struct {
+    io_dist_kind_t kind;   /* вид распределения */
+    double param;          /* theta для zipf, h для pareto, sigma в долях диапазона для normal */
+    double hot_access;     /* доля обращений в горячую часть для hotspot */
+    double hot_blocks;     /* доля блоков горячей части для hotspot */
+    double zipf_zetan;     /* сумма 1 / k^theta по блокам диапазона */
+    double zipf_alpha;     /* 1 / (1 - theta) */
+    double zipf_eta;       /* поправка алгоритма Грея для хвоста */
+} io_dist_t;
+
+/* io_verify_header_t — метка в начале каждого блока, записанного с --verify.
+ * crc — CRC32C полей magic, offset и generation и всех байтов блока после
+ * метки; остальные байты блока — псевдослучайные, выведенные из offset и
+ * generation, поэтому блоки не сжимаются и не дедуплицируются.
+ */
+typedef struct {
+    uint64_t magic;        /* IO_VERIFY_MAGIC */
+    uint64_t offset;       /* смещение блока в файле */
+    uint64_t generation;   /* номер записи блока потоком */
+    uint32_t crc;          /* контрольная сумма блока */
+    uint32_t reserved;     /* выравнивание, всегда 0 */
+} io_verify_header_t;
+
+#define IO_VERIFY_MAGIC 0x5946495245564F49ULL /* "IOVERIFY" */
+
+/* io_task_t — структура для передачи данных IO потоку */
+typedef struct io_task {
     const char* file;      /* путь к файлу */
     size_t block_size;     /* размер блока в байтах */
     size_t block_count;    /* количество блоков для чтения/записи */
-    int do_write;          /* 1 = писать, 0 = читать */
+    int rwmixread;         /* доля чтений в процентах: 100 = только чтение, 0 = только запись */
     int repetitions;       /* количество повторов */
+
+    int fd;                /* общий для всех потоков дескриптор файла */
+    int thread_index;      /* номер потока, начиная с нуля */
+    int is_sequence;       /* 1 = последовательный доступ, 0 = случайный */
+    off_t slice_start;     /* начало диапазона потока в байтах */
+    off_t slice_blocks;    /* число блоков в диапазоне потока */
+    void* buffer;          /* выровненные буферы потока, iodepth штук подряд */
+    uint64_t rng[4];       /* состояние генератора xoshiro256** потока */
+    io_dist_t dist;        /* распределение случайных блоков с параметрами для slice_blocks */
+    pthread_barrier_t* barrier; /* общий барьер начала и конца повтора */
+    double* started;       /* начало каждого повтора, CLOCK_MONOTONIC в секундах */
+    double* finished;      /* конец каждого повтора, CLOCK_MONOTONIC в секундах */
+    size_t errors;         /* число операций, завершившихся ошибкой */
+    size_t short_ops;      /* число укороченных операций */
+    io_histogram_t latency; /* задержки операций текущего повтора */
+    io_histogram_t lag;    /* опоздание постановки операций против расписания --rate в текущем повторе */
+
+    const struct io_engine* engine; /* движок, выполняющий операции */
+    void* engine_ctx;      /* состояние движка в этом потоке */
+    int iodepth;           /* наибольшее число операций в полёте */
+    uint64_t rate_interval_ns; /* шаг расписания операций потока, 0 = замкнутый цикл */
+    uint64_t rate_phase_ns; /* сдвиг расписания потока относительно начала повтора */
+    int madvise_advice;    /* совет madvise для --engine mmap, -1 = не задан */
+    int is_populate;       /* 1 = отображать с MAP_POPULATE */
+    int rwf_flags;         /* флаги RWF_* для preadv2/pwritev2 в psync, 0 = обычные вызовы */
+    int verify;            /* 1 = писать блоки с меткой и проверять прочитанные */
+    int verify_blank_ok;   /* 1 = нулевой блок, куда поток ещё не писал, не ошибка, а не записанный */
+    int verify_stale;      /* 1 = ещё и проверять, что чтение не старее последней записи потока */
+    int verify_exclusive;  /* 1 = не ставить операцию над блоком, пока над ним идёт предыдущая */
+    uint64_t generation;   /* номер последней записи потока */
+    size_t verify_errors;  /* число прочитанных блоков, не прошедших проверку */
+    size_t verify_unwritten; /* число прочитанных нулевых блоков, куда ещё не писали */
 } io_task_t;
 
+/* io_engine_t — способ выполнения операций потока.
+ * prepare ставит в очередь запись или чтение буфера slot по смещению offset,
+ * complete отправляет очередь и ждёт хотя бы одного завершения до момента
+ * deadline по CLOCK_MONOTONIC в наносекундах (0 — не ждать,
+ * IO_WAIT_FOREVER — без срока), записывая номера буферов и результаты
+ * (байты или -errno) в slots и results; возвращает число завершений (0, если
+ * срок наступил раньше) или -1 с errno. Движок никогда не получает больше
+ * iodepth незавершённых операций.
+ */
+#define IO_WAIT_FOREVER UINT64_MAX
+
+typedef struct io_engine {
+    const char* name;      /* имя для --engine */
+    int is_blocking;       /* 1 = операции выполняются по одной, --iodepth не имеет смысла */
+    int (*init)(io_task_t* task);
+    void (*prepare)(io_task_t* task, int slot, off_t offset, int is_write);
+    int (*complete)(io_task_t* task, int* slots, ssize_t* results, uint64_t deadline);
+    void (*destroy)(io_task_t* task);
+} io_engine_t;
+
 /* io_worker(void* arg)
  * Потоковая функция для нагрузки ввода/вывода.
  * Принимает указатель на io_task_t.
  */
 void* io_worker(void* arg);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,124 @@
+import json
+import os
+import shutil
+import subprocess
+import tempfile
+from typing import List
+from unittest import TestCase
+
+BLOCK_SIZE = 4096
+BLOCK_COUNT = 64
+ENGINES = ["psync", "io_uring", "libaio", "vtpc", "mmap"]
+
+
+class TestIoLoader(TestCase):
+    def setUp(self):
+        loader_path = os.path.join(
+            os.path.dirname(__file__), "../build/bin/io-loader"
+        )
+        self.loader_path = os.path.abspath(loader_path)
+        self.work_dir = tempfile.mkdtemp(prefix="io-loader-")
+
+    def tearDown(self):
+        shutil.rmtree(self.work_dir, ignore_errors=True)
+
+    def path(self, name: str) -> str:
+        return os.path.join(self.work_dir, name)
+
+    def run_loader(self, file: str, rw: str, *args: str):
+        cmd = [
+            self.loader_path,
+            "--rw", rw,
+            "--block_size", str(BLOCK_SIZE),
+            "--block_count", str(BLOCK_COUNT),
+            "--file", file,
+            *args,
+        ]
+        return subprocess.run(cmd, capture_output=True, text=True, timeout=60)
+
+    def run_json(self, file: str, rw: str, *args: str) -> dict:
+        result = self.run_loader(file, rw, "--output-format", "json", *args)
+        self.assertEqual(result.returncode, 0, result.stderr)
+        return json.loads(result.stdout)
+
+    def write_verified(self, file: str, *args: str) -> dict:
+        return self.run_json(file, "write", "--verify", *args)
+
+    def test_engines_json(self):
+        data = self.path("data.dat")
+        self.write_verified(data)
+        for engine in ENGINES:
+            with self.subTest(engine=engine):
+                result = self.run_loader(
+                    data, "read", "--engine", engine, "--output-format", "json"
+                )
+                if result.returncode != 0 and engine in ("io_uring", "libaio"):
+                    # Песочницы и контейнеры часто запрещают асинхронный ввод-вывод.
+                    self.skipTest(f"{engine} unavailable: {result.stderr.strip()}")
+                self.assertEqual(result.returncode, 0, result.stderr)
+                report = json.loads(result.stdout)
+                self.assertEqual(report["config"]["engine"], engine)
+                self.assertEqual(len(report["iterations"]), 1)
+                total = report["total"]
+                self.assertEqual(total["ops"], BLOCK_COUNT)
+                self.assertEqual(total["errors"], 0)
+                self.assertEqual(total["short"], 0)
+                self.assertGreater(total["latency_us"]["max"], 0)
+                if engine == "vtpc":
+                    self.assertIn("vtpc", total)
+
+    def test_verify_round_trip(self):
+        data = self.path("data.dat")
+        self.assertEqual(self.write_verified(data)["total"]["verify_errors"], 0)
+        report = self.run_json(data, "read", "--verify")
+        self.assertEqual(report["total"]["verify_errors"], 0)
+        self.assertEqual(report["total"]["verify_unwritten"], 0)
+
+    def test_verify_detects_corruption(self):
+        data = self.path("data.dat")
+        self.write_verified(data)
+        with open(data, "r+b") as file:
+            file.seek(5 * BLOCK_SIZE + 100)
+            byte = file.read(1)
+            file.seek(-1, os.SEEK_CUR)
+            file.write(bytes([byte[0] ^ 0xFF]))
+        result = self.run_loader(
+            data, "read", "--verify", "--output-format", "json"
+        )
+        self.assertEqual(result.returncode, 1)
+        self.assertEqual(json.loads(result.stdout)["total"]["verify_errors"], 1)
+        self.assertIn("checksum mismatch", result.stderr)
+
+    def test_verify_detects_lost_write(self):
+        data = self.path("data.dat")
+        self.write_verified(data)
+        with open(data, "r+b") as file:
+            file.seek(7 * BLOCK_SIZE)
+            file.write(bytes(BLOCK_SIZE))
+        result = self.run_loader(data, "read", "--verify")
+        self.assertEqual(result.returncode, 1)
+        self.assertIn("blank block", result.stderr)
+
+    def test_rate_reports_lag(self):
+        data = self.path("data.dat")
+        self.write_verified(data)
+        report = self.run_json(data, "read", "--rate", "20000")
+        self.assertEqual(report["config"]["rate_iops"], 20000)
+        self.assertIn("schedule_lag_us", report["total"])
+        closed = self.run_json(data, "read")
+        self.assertNotIn("schedule_lag_us", closed["total"])
+
+    def random_writes(self, name: str, seed: int) -> bytes:
+        data = self.path(name)
+        args: List[str] = ["--type", "random", "--seed", str(seed)]
+        report = self.write_verified(data, *args)
+        self.assertEqual(report["config"]["seed"], seed)
+        with open(data, "rb") as file:
+            return file.read()
+
+    def test_seed_reproducible(self):
+        first = self.random_writes("first.dat", 42)
+        second = self.random_writes("second.dat", 42)
+        other = self.random_writes("other.dat", 43)
+        self.assertEqual(first, second)
+        self.assertNotEqual(first, other)